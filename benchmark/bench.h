@@ -0,0 +1,315 @@
+/**
+ * @brief 微基准测试工具：rdtscp 计时 + perf_event_open 硬件计数器
+ * @details
+ * 只有一个头文件，C 和 C++ 的例子都可以直接包含。
+ *
+ * 计时：
+ *      开始 lfence; rdtsc，结束 rdtscp; lfence，
+ *      保证被测代码不会被乱序执行到计时区间之外。
+ *      启动时用 CLOCK_MONOTONIC_RAW 校准 TSC 频率，把周期换算成纳秒。
+ * 硬件计数器：
+ *      用 perf_event_open 打开一组计数器（cycles、instructions、
+ *      cache-misses、branch-misses），只统计用户态。
+ *      没有权限或没有 PMU（例如虚拟机）时对应的值为 -1（json 中为 null）。
+ * 稳定性：
+ *      先预热，并把每轮的调用次数加倍，直到一轮至少 BENCH_MIN_RUN_NS；
+ *      然后反复运行，直到平均值的相对标准误差低于 target_rse，
+ *      或达到 max_runs / max_seconds。
+ * 输出：
+ *      环境变量 BENCH_FORMAT=text（默认）| csv | json，
+ *      json 为每行一个对象，方便用脚本汇总不同例子的结果。
+ *
+ * 用法：
+ *      bench_init(NULL);
+ *      struct bench_result r = bench_run("name", fn, arg, ops_per_call);
+ *      bench_report(&r);
+ *
+ * @details
+ * https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/ia-32-ia-64-benchmark-code-execution-paper.pdf
+ * https://man7.org/linux/man-pages/man2/perf_event_open.2.html
+ */
+#pragma once
+
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MIN_RUN_NS 100000.0 /* 每轮至少 100 微秒 */
+#define BENCH_MAX_RUNS_KEPT 4096
+#define BENCH_NCOUNTERS 4
+
+enum bench_format {
+    BENCH_TEXT,
+    BENCH_CSV,
+    BENCH_JSON
+};
+
+struct bench_config {
+    enum bench_format format;
+    double target_rse; /* 目标相对标准误差，默认 0.01 */
+    int min_runs;      /* 默认 10 */
+    int max_runs;      /* 默认 1000 */
+    double max_seconds; /* 每个测试最多运行的时间，默认 2 秒 */
+    FILE* out;
+};
+
+struct bench_result {
+    char name[64];
+    int runs;
+    double ops;          /* 每轮的操作数 */
+    double mean_ns;      /* 以下时间均为每个操作 */
+    double median_ns;
+    double min_ns;
+    double stddev_ns;
+    double rse;          /* 平均值的相对标准误差 */
+    double tsc_cycles;
+    /* 每个操作的硬件计数，不可用时为 -1 */
+    double cycles;
+    double instructions;
+    double cache_misses;
+    double branch_misses;
+};
+
+typedef void (*bench_fn)(void* arg);
+
+static struct bench_config bench_cfg;
+static double bench_tsc_ghz;
+static int bench_perf_fds[BENCH_NCOUNTERS] = {-1, -1, -1, -1};
+static int bench_header_printed;
+
+static inline uint64_t bench_tsc_begin(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("lfence;"
+                         "rdtsc;"
+                         : "=a"(lo), "=d"(hi)
+                         :
+                         : "memory");
+    return (uint64_t)hi << 32 | lo;
+}
+
+static inline uint64_t bench_tsc_end(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtscp;"
+                         "lfence;"
+                         : "=a"(lo), "=d"(hi)
+                         :
+                         : "rcx", "memory");
+    return (uint64_t)hi << 32 | lo;
+}
+
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 用 50 毫秒的墙上时间校准 TSC 频率，返回 GHz（每纳秒的周期数）
+static inline double bench_calibrate_tsc(void) {
+    double t0 = bench_now_ns();
+    uint64_t c0 = bench_tsc_begin();
+    while (bench_now_ns() - t0 < 50e6)
+        ;
+    uint64_t c1 = bench_tsc_end();
+    double t1 = bench_now_ns();
+    return (c1 - c0) / (t1 - t0);
+}
+
+static inline int bench_perf_open(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static inline void bench_perf_setup(void) {
+    const uint64_t configs[BENCH_NCOUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < BENCH_NCOUNTERS; ++i)
+        bench_perf_fds[i] = bench_perf_open(configs[i], bench_perf_fds[0]);
+}
+
+// 读出计数器组；leader 打不开时返回 0
+static inline int bench_perf_read(uint64_t* values) {
+    uint64_t buf[1 + BENCH_NCOUNTERS];
+    if (bench_perf_fds[0] == -1 ||
+        read(bench_perf_fds[0], buf, sizeof(buf)) < (ssize_t)sizeof(buf[0]))
+        return 0;
+    int k = 1;
+    for (int i = 0; i < BENCH_NCOUNTERS; ++i)
+        values[i] = bench_perf_fds[i] != -1 && k <= (int)buf[0] ? buf[k++] : 0;
+    return 1;
+}
+
+/**
+ * @brief 初始化：读取配置、校准 TSC、打开硬件计数器
+ * @param cfg 为 NULL 时使用默认值，格式由环境变量 BENCH_FORMAT 决定
+ */
+static inline void bench_init(const struct bench_config* cfg) {
+    if (cfg != NULL) {
+        bench_cfg = *cfg;
+    } else {
+        const char* format = getenv("BENCH_FORMAT");
+        bench_cfg.format = BENCH_TEXT;
+        if (format != NULL && strcmp(format, "csv") == 0)
+            bench_cfg.format = BENCH_CSV;
+        else if (format != NULL && strcmp(format, "json") == 0)
+            bench_cfg.format = BENCH_JSON;
+        bench_cfg.target_rse = 0.01;
+        bench_cfg.min_runs = 10;
+        bench_cfg.max_runs = 1000;
+        bench_cfg.max_seconds = 2.0;
+        bench_cfg.out = stdout;
+    }
+    if (bench_cfg.max_runs > BENCH_MAX_RUNS_KEPT)
+        bench_cfg.max_runs = BENCH_MAX_RUNS_KEPT;
+    bench_tsc_ghz = bench_calibrate_tsc();
+    bench_perf_setup();
+}
+
+static inline int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 测量 fn(arg)
+ * @param ops_per_call fn 每次调用包含的操作数，结果都折算到每个操作
+ */
+static inline struct bench_result bench_run(const char* name, bench_fn fn,
+                                            void* arg, double ops_per_call) {
+    struct bench_result r;
+    memset(&r, 0, sizeof(r));
+    snprintf(r.name, sizeof(r.name), "%s", name);
+
+    // 预热（第一次调用可能包含缺页、子进程启动等），再确定每轮调用多少次
+    for (int i = 0; i < 3; ++i)
+        fn(arg);
+    long inner = 1;
+    for (;;) {
+        uint64_t c0 = bench_tsc_begin();
+        for (long i = 0; i < inner; ++i)
+            fn(arg);
+        uint64_t c1 = bench_tsc_end();
+        if ((c1 - c0) / bench_tsc_ghz >= BENCH_MIN_RUN_NS || inner >= 1L << 30)
+            break;
+        inner *= 2;
+    }
+    r.ops = inner * ops_per_call;
+
+    static double samples[BENCH_MAX_RUNS_KEPT];
+    uint64_t counters[BENCH_NCOUNTERS] = {0};
+    double sum = 0, sum_sq = 0;
+    int have_perf = bench_perf_fds[0] != -1;
+    double deadline = bench_now_ns() + bench_cfg.max_seconds * 1e9;
+
+    if (have_perf) {
+        ioctl(bench_perf_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(bench_perf_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    int n = 0;
+    while (n < bench_cfg.max_runs) {
+        uint64_t c0 = bench_tsc_begin();
+        for (long i = 0; i < inner; ++i)
+            fn(arg);
+        uint64_t c1 = bench_tsc_end();
+
+        double ns = (c1 - c0) / bench_tsc_ghz / r.ops;
+        samples[n++] = ns;
+        sum += ns;
+        sum_sq += ns * ns;
+        r.tsc_cycles += (double)(c1 - c0);
+
+        if (n >= bench_cfg.min_runs) {
+            double mean = sum / n;
+            double var = (sum_sq - n * mean * mean) / (n - 1);
+            r.rse = sqrt(var > 0 ? var : 0) / sqrt(n) / mean;
+            if (r.rse < bench_cfg.target_rse || bench_now_ns() > deadline)
+                break;
+        }
+    }
+    if (have_perf) {
+        ioctl(bench_perf_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        have_perf = bench_perf_read(counters);
+    }
+
+    qsort(samples, n, sizeof(double), bench_compare_double);
+    r.runs = n;
+    r.mean_ns = sum / n;
+    r.median_ns = samples[n / 2];
+    r.min_ns = samples[0];
+    r.stddev_ns = n > 1 ? sqrt(fmax(0, (sum_sq - n * r.mean_ns * r.mean_ns) /
+                                          (n - 1)))
+                        : 0;
+    r.tsc_cycles /= n * r.ops;
+
+    double total_ops = n * r.ops;
+    double* per_op[BENCH_NCOUNTERS] = {&r.cycles, &r.instructions,
+                                       &r.cache_misses, &r.branch_misses};
+    for (int i = 0; i < BENCH_NCOUNTERS; ++i)
+        *per_op[i] = have_perf && bench_perf_fds[i] != -1
+                         ? counters[i] / total_ops
+                         : -1;
+    return r;
+}
+
+static inline void bench_report(const struct bench_result* r) {
+    FILE* out = bench_cfg.out != NULL ? bench_cfg.out : stdout;
+    switch (bench_cfg.format) {
+    case BENCH_CSV:
+        if (!bench_header_printed++)
+            fprintf(out, "name,runs,ops,mean_ns,median_ns,min_ns,stddev_ns,"
+                         "rse,tsc_cycles,cycles,instructions,cache_misses,"
+                         "branch_misses\n");
+        fprintf(out, "%s,%d,%.0f,%.3f,%.3f,%.3f,%.3f,%.5f,%.3f,%.3f,%.3f,"
+                     "%.5f,%.5f\n",
+                r->name, r->runs, r->ops, r->mean_ns, r->median_ns, r->min_ns,
+                r->stddev_ns, r->rse, r->tsc_cycles, r->cycles,
+                r->instructions, r->cache_misses, r->branch_misses);
+        break;
+    case BENCH_JSON: {
+        char counters[BENCH_NCOUNTERS][32];
+        const double values[BENCH_NCOUNTERS] = {
+            r->cycles, r->instructions, r->cache_misses, r->branch_misses};
+        for (int i = 0; i < BENCH_NCOUNTERS; ++i) {
+            if (values[i] < 0)
+                snprintf(counters[i], sizeof(counters[i]), "null");
+            else
+                snprintf(counters[i], sizeof(counters[i]), "%.5f", values[i]);
+        }
+        fprintf(out,
+                "{\"name\":\"%s\",\"runs\":%d,\"ops\":%.0f,\"mean_ns\":%.3f,"
+                "\"median_ns\":%.3f,\"min_ns\":%.3f,\"stddev_ns\":%.3f,"
+                "\"rse\":%.5f,\"tsc_cycles\":%.3f,\"cycles\":%s,"
+                "\"instructions\":%s,\"cache_misses\":%s,"
+                "\"branch_misses\":%s}\n",
+                r->name, r->runs, r->ops, r->mean_ns, r->median_ns, r->min_ns,
+                r->stddev_ns, r->rse, r->tsc_cycles, counters[0], counters[1],
+                counters[2], counters[3]);
+        break;
+    }
+    default:
+        if (!bench_header_printed++)
+            fprintf(out, "%-24s %6s %12s %8s %10s %10s %10s %10s\n", "name",
+                    "runs", "median_ns", "rse", "tsc_cyc", "instr",
+                    "cache_miss", "br_miss");
+        fprintf(out, "%-24s %6d %12.2f %7.2f%% %10.1f %10.1f %10.3f %10.3f\n",
+                r->name, r->runs, r->median_ns, r->rse * 100, r->tsc_cycles,
+                r->instructions, r->cache_misses, r->branch_misses);
+        break;
+    }
+    fflush(out);
+}
@@ -0,0 +1,137 @@
+/**
+ * @brief 用 ./bench.h 测量几条典型路径
+ * @details
+ * 1. asm：inline-assembly/first.c 例子 4 中的 addl / subl / imull / idivl
+ * 2. pipe：父子进程通过两个管道来回传 1 个字节（一次往返）
+ * 3. fork：fork 一个立即 _exit 的子进程并 waitpid
+ * 4. signal：向自己发送 SIGUSR1，信号处理函数返回
+ *
+ * 结果都折算成每个操作的纳秒、TSC 周期和硬件计数，可以直接互相比较。
+ * 输出格式由环境变量 BENCH_FORMAT 控制（text / csv / json）。
+ *
+ * @note
+ * gcc benchmark/first.c -o out/a.out -O2 -lm && out/a.out
+ * BENCH_FORMAT=json out/a.out
+ */
+
+#include "bench.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define ASM_OPS 64
+
+// 例子 4 的四则运算，结果累加，避免被当作无用代码
+static void asm_arith(void* arg) {
+    int* sink = arg;
+    int arg1 = 4, arg2 = 2, add, sub, mul, quo, rem;
+    for (int i = 0; i < ASM_OPS; ++i) {
+        __asm__ __volatile__("addl %%ebx, %%eax;"
+                             : "=a"(add)
+                             : "a"(arg1), "b"(arg2));
+        __asm__ __volatile__("subl %%ebx, %%eax;"
+                             : "=a"(sub)
+                             : "a"(arg1), "b"(arg2));
+        __asm__ __volatile__("imull %%ebx, %%eax;"
+                             : "=a"(mul)
+                             : "a"(arg1), "b"(arg2));
+        // cltd 把 eax 符号扩展到 edx:eax；edx 先被写，除数不能放在 edx 里
+        __asm__ __volatile__("cltd;"
+                             "idivl %3;"
+                             : "=a"(quo), "=&d"(rem)
+                             : "a"(arg1), "r"(arg2)
+                             : "cc");
+        *sink += add + sub + mul + quo + rem;
+    }
+}
+
+struct pingpong {
+    int to_child;
+    int from_child;
+};
+
+static void pipe_round_trip(void* arg) {
+    struct pingpong* pp = arg;
+    char c = 'p';
+    if (write(pp->to_child, &c, 1) != 1 || read(pp->from_child, &c, 1) != 1) {
+        perror("pipe round trip");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void fork_wait(void* arg) {
+    (void)arg;
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0)
+        _exit(0);
+    waitpid(pid, NULL, 0);
+}
+
+static volatile sig_atomic_t signal_count;
+
+static void sigusr1Handler(int sig) {
+    (void)sig;
+    ++signal_count;
+}
+
+static void raise_signal(void* arg) {
+    (void)arg;
+    raise(SIGUSR1);
+}
+
+int main() {
+    bench_init(NULL);
+    if (bench_cfg.format == BENCH_TEXT)
+        printf("tsc %.3f GHz, perf counters %s\n", bench_tsc_ghz,
+               bench_perf_fds[0] != -1 ? "on" : "unavailable");
+
+    int sink = 0;
+    struct bench_result r = bench_run("asm_arith", asm_arith, &sink, ASM_OPS);
+    bench_report(&r);
+
+    // 子进程：收到一个字节就回一个字节，直到管道关闭
+    int down[2], up[2];
+    if (pipe(down) == -1 || pipe(up) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pid_t child = fork();
+    if (child == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (child == 0) {
+        close(down[1]);
+        close(up[0]);
+        char c;
+        while (read(down[0], &c, 1) == 1)
+            if (write(up[1], &c, 1) != 1)
+                break;
+        _exit(0);
+    }
+    close(down[0]);
+    close(up[1]);
+    struct pingpong pp = {down[1], up[0]};
+    r = bench_run("pipe_round_trip", pipe_round_trip, &pp, 1);
+    bench_report(&r);
+    close(down[1]);
+    close(up[0]);
+    waitpid(child, NULL, 0);
+
+    r = bench_run("fork_wait", fork_wait, NULL, 1);
+    bench_report(&r);
+
+    struct sigaction sa = {0};
+    sa.sa_handler = sigusr1Handler;
+    sigaction(SIGUSR1, &sa, NULL);
+    r = bench_run("signal_raise", raise_signal, NULL, 1);
+    bench_report(&r);
+
+    return sink == 0 && signal_count == 0;
+}
@@ -0,0 +1,536 @@
+/**
+ * @brief 单线程的 C++20 协程运行时：epoll 反应器 + 管道 / FIFO / 信号 / 子进程退出的 awaitable
+ * @details
+ * 其他例子里到处都在阻塞：管道的 read()、fork 例子里的 wait()、../other/single.c 的 sleep()。
+ * 要同时照看许多子进程，要么每个等待开一个线程，要么自己写状态机。
+ * 这里用协程把状态机交给编译器：每个交互写成顺序的代码，
+ * 在会阻塞的地方 co_await，协程挂起，线程回到 EventLoop 处理别的事件。
+ *
+ * Task<T>
+ *      惰性启动的协程，被 co_await 时才开始运行，结束时对称转移回等待它的协程。
+ *      不使用异常：协程中抛出异常直接 std::terminate()。T 必须可以默认构造。
+ * EventLoop
+ *      spawn(task) 把一个 Task<void> 交给循环，run() 一直运行到所有 spawn 的任务结束。
+ *      所有文件描述符以 EPOLLIN | EPOLLOUT | EPOLLET 注册到同一个 epoll，
+ *      epoll_event.data.ptr 指向 IoState，事件到来时恢复在上面等待的读者或写者。
+ *      操作总是先尝试系统调用，EAGAIN 才挂起，所以边沿触发不会丢事件。
+ *      co_await loop.sleep(ms)      定时器（最小堆），决定 epoll_wait() 的超时
+ *      co_await loop.signal(sig)    第一次调用时屏蔽 sig，加入循环的 signalfd；
+ *                                   没有协程等待时到达的信号先存起来，之后的 co_await 立即返回
+ * AsyncFd
+ *      拥有一个非阻塞的文件描述符（管道的一端，或 openFifo() 打开的 FIFO）：
+ *      co_await fd.read(buf)        读到一些数据就返回：字节数，0 为 EOF，失败为 -errno
+ *      co_await fd.readExact(buf)   读满 buf，EOF 或失败返回 false
+ *      co_await fd.write(msg)       全部写完才返回：字节数，失败为 -errno
+ * AsyncChild
+ *      co_await child.exit()        通过 pidfd 等待子进程退出，返回 waitid() 的 siginfo_t
+ *
+ * 同一个 AsyncFd 同一时刻最多一个读者、一个写者；有协程在等待时不能销毁或移动它等待的对象。
+ * 只能在一个线程里使用。
+ *
+ * @details
+ * https://en.cppreference.com/w/cpp/language/coroutines
+ * https://lewissbaker.github.io/2020/05/11/understanding_symmetric_transfer
+ * https://man7.org/linux/man-pages/man7/epoll.7.html
+ */
+#pragma once
+
+#include "../process/fork/reaper.h" // pidfdOpen, pidfdSendSignal, P_PIDFD
+#include <chrono>
+#include <coroutine>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <queue>
+#include <span>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+
+    // 结束时恢复等待者；没有等待者时是 noop_coroutine
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    T value{};
+    void return_value(T v) { value = std::move(v); }
+    T result() { return std::move(value); }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    void return_void() {}
+    void result() {}
+};
+
+template <typename T = void>
+class [[nodiscard]] Task {
+public:
+    struct promise_type : TaskPromise<T> {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Task(Task&& other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        std::swap(h_, other.h_);
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (h_)
+            h_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    // 记下等待者，直接转到这个任务开始运行
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+        h_.promise().continuation = caller;
+        return h_;
+    }
+
+    T await_resume() { return h_.promise().result(); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> h) : h_(h) {}
+
+    std::coroutine_handle<promise_type> h_;
+};
+
+// 一个文件描述符上等待的读者和写者
+struct IoState {
+    int fd = -1;
+    bool watched = false;
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+};
+
+class EventLoop {
+public:
+    EventLoop() {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd_ == -1) {
+            perror("epoll_create1");
+            exit(EXIT_FAILURE);
+        }
+        sigemptyset(&sigmask_);
+    }
+
+    ~EventLoop() {
+        if (sigfd_ != -1)
+            close(sigfd_);
+        close(epfd_);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 开始运行 task（运行到第一次挂起），run() 会等它结束
+    void spawn(Task<void> task) {
+        ++live_;
+        runDetached(std::move(task));
+    }
+
+    // 尚未结束的 spawn 任务个数
+    size_t live() const { return live_; }
+
+    // 处理事件，直到所有 spawn 的任务都结束
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        while (live_ > 0) {
+            while (!ready_.empty()) {
+                std::coroutine_handle<> h = ready_.front();
+                ready_.pop_front();
+                h.resume();
+            }
+            if (live_ == 0)
+                break;
+
+            int n = epoll_wait(epfd_, events, MAX_EVENTS, timeoutMs());
+            if (n == -1) {
+                if (errno == EINTR)
+                    continue;
+                perror("epoll_wait");
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    dispatchSignals();
+                    continue;
+                }
+                IoState* s = static_cast<IoState*>(events[i].data.ptr);
+                uint32_t ev = events[i].events;
+                if ((ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) && s->reader)
+                    ready_.push_back(std::exchange(s->reader, nullptr));
+                if ((ev & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && s->writer)
+                    ready_.push_back(std::exchange(s->writer, nullptr));
+            }
+            fireTimers();
+        }
+    }
+
+    // 挂起 h，直到 s->fd 可读（readable 为 true）或可写
+    void waitFd(IoState* s, bool readable, std::coroutine_handle<> h) {
+        (readable ? s->reader : s->writer) = h;
+        if (s->watched)
+            return;
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.ptr = s;
+        if (epoll_ctl(epfd_, EPOLL_CTL_ADD, s->fd, &ev) == -1) {
+            perror("epoll_ctl");
+            exit(EXIT_FAILURE);
+        }
+        s->watched = true;
+    }
+
+    void forget(IoState* s) {
+        if (s->watched)
+            epoll_ctl(epfd_, EPOLL_CTL_DEL, s->fd, nullptr);
+        s->watched = false;
+    }
+
+    struct FdAwaiter {
+        EventLoop* loop;
+        IoState* state;
+        bool readable;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            loop->waitFd(state, readable, h);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct SleepAwaiter {
+        EventLoop* loop;
+        std::chrono::steady_clock::time_point until;
+        bool await_ready() const {
+            return until <= std::chrono::steady_clock::now();
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            loop->timers_.push(Timer{until, loop->timer_seq_++, h});
+        }
+        void await_resume() const noexcept {}
+    };
+
+    SleepAwaiter sleep(std::chrono::milliseconds duration) {
+        return SleepAwaiter{this, std::chrono::steady_clock::now() + duration};
+    }
+
+    struct SignalAwaiter {
+        EventLoop* loop;
+        int sig;
+        signalfd_siginfo info{};
+        bool await_ready() { return loop->takePendingSignal(sig, &info); }
+        void await_suspend(std::coroutine_handle<> h) {
+            loop->signal_waiters_.push_back(SignalWaiter{sig, this, h});
+        }
+        signalfd_siginfo await_resume() const { return info; }
+    };
+
+    // 等待 sig；第一次调用时屏蔽它，之前到达的仍按原来的方式处理
+    SignalAwaiter signal(int sig) {
+        watchSignal(sig);
+        return SignalAwaiter{this, sig};
+    }
+
+private:
+    static constexpr int MAX_EVENTS = 256;
+
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+
+    Detached runDetached(Task<void> task) {
+        co_await task;
+        --live_;
+    }
+
+    struct Timer {
+        std::chrono::steady_clock::time_point until;
+        uint64_t seq; // 同一时刻的按加入顺序
+        std::coroutine_handle<> h;
+        bool operator>(const Timer& other) const {
+            return until != other.until ? until > other.until
+                                        : seq > other.seq;
+        }
+    };
+
+    struct SignalWaiter {
+        int sig;
+        SignalAwaiter* awaiter;
+        std::coroutine_handle<> h;
+    };
+
+    // 距离最早的定时器的毫秒数（向上取整），没有定时器时为 -1
+    int timeoutMs() const {
+        if (!ready_.empty())
+            return 0;
+        if (timers_.empty())
+            return -1;
+        auto left = timers_.top().until - std::chrono::steady_clock::now();
+        if (left.count() <= 0)
+            return 0;
+        return static_cast<int>(
+            std::chrono::ceil<std::chrono::milliseconds>(left).count());
+    }
+
+    void fireTimers() {
+        auto now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.top().until <= now) {
+            ready_.push_back(timers_.top().h);
+            timers_.pop();
+        }
+    }
+
+    void watchSignal(int sig) {
+        if (sigismember(&sigmask_, sig))
+            return;
+        sigaddset(&sigmask_, sig);
+        if (sigprocmask(SIG_BLOCK, &sigmask_, nullptr) == -1) {
+            perror("sigprocmask");
+            exit(EXIT_FAILURE);
+        }
+        bool first = sigfd_ == -1;
+        sigfd_ = signalfd(sigfd_, &sigmask_, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (sigfd_ == -1) {
+            perror("signalfd");
+            exit(EXIT_FAILURE);
+        }
+        if (first) {
+            // data.ptr 为空表示 signalfd
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr;
+            epoll_ctl(epfd_, EPOLL_CTL_ADD, sigfd_, &ev);
+        }
+    }
+
+    // 读出所有到达的信号，恢复等待这个信号的所有协程；没有等待者的先存起来
+    void dispatchSignals() {
+        signalfd_siginfo info;
+        while (read(sigfd_, &info, sizeof(info)) == sizeof(info)) {
+            bool delivered = false;
+            for (size_t i = 0; i < signal_waiters_.size();) {
+                SignalWaiter& w = signal_waiters_[i];
+                if (w.sig != static_cast<int>(info.ssi_signo)) {
+                    ++i;
+                    continue;
+                }
+                w.awaiter->info = info;
+                ready_.push_back(w.h);
+                w = signal_waiters_.back();
+                signal_waiters_.pop_back();
+                delivered = true;
+            }
+            if (!delivered)
+                pending_signals_.push_back(info);
+        }
+    }
+
+    bool takePendingSignal(int sig, signalfd_siginfo* info) {
+        for (size_t i = 0; i < pending_signals_.size(); ++i) {
+            if (static_cast<int>(pending_signals_[i].ssi_signo) == sig) {
+                *info = pending_signals_[i];
+                pending_signals_.erase(pending_signals_.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int epfd_ = -1;
+    int sigfd_ = -1;
+    sigset_t sigmask_;
+    size_t live_ = 0;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timer_seq_ = 0;
+    std::vector<SignalWaiter> signal_waiters_;
+    std::vector<signalfd_siginfo> pending_signals_;
+};
+
+// 拥有一个非阻塞文件描述符
+class AsyncFd {
+public:
+    // 接管 fd，并设置 O_NONBLOCK
+    AsyncFd(EventLoop& loop, int fd)
+        : loop_(&loop), state_(std::make_unique<IoState>()) {
+        state_->fd = fd;
+        int flags = fcntl(fd, F_GETFL);
+        if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+            perror("fcntl");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /**
+     * @brief 以 O_RDWR 打开 FIFO：打开时不用等对端，也不会因为对端都关闭而读到 EOF / 写出 EPIPE
+     * @details
+     * 和 ../interprocess-communications/pipe/second.c 的读者一样的做法，Linux 上对 FIFO 有效。
+     */
+    static AsyncFd openFifo(EventLoop& loop, const char* path) {
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd == -1) {
+            perror("open fifo");
+            exit(EXIT_FAILURE);
+        }
+        return AsyncFd(loop, fd);
+    }
+
+    AsyncFd(AsyncFd&&) noexcept = default;
+
+    // 先像析构一样从 epoll 中移除并关闭原来的 fd，再接管 other 的
+    AsyncFd& operator=(AsyncFd&& other) noexcept {
+        if (this != &other) {
+            release();
+            loop_ = other.loop_;
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    ~AsyncFd() { release(); }
+
+    int fd() const { return state_->fd; }
+
+    EventLoop::FdAwaiter readable() {
+        return EventLoop::FdAwaiter{loop_, state_.get(), true};
+    }
+
+    EventLoop::FdAwaiter writable() {
+        return EventLoop::FdAwaiter{loop_, state_.get(), false};
+    }
+
+    // 读到一些数据就返回：字节数，0 为 EOF，失败为 -errno
+    Task<ssize_t> read(std::span<char> buf) {
+        for (;;) {
+            ssize_t n = ::read(state_->fd, buf.data(), buf.size());
+            if (n >= 0)
+                co_return n;
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                co_return -errno;
+            co_await readable();
+        }
+    }
+
+    // 读满 buf；EOF 或失败返回 false
+    Task<bool> readExact(std::span<char> buf) {
+        size_t got = 0;
+        while (got < buf.size()) {
+            ssize_t n = co_await read(buf.subspan(got));
+            if (n <= 0)
+                co_return false;
+            got += n;
+        }
+        co_return true;
+    }
+
+    // 全部写完才返回：字节数，失败为 -errno
+    Task<ssize_t> write(std::span<const char> buf) {
+        size_t done = 0;
+        while (done < buf.size()) {
+            ssize_t n =
+                ::write(state_->fd, buf.data() + done, buf.size() - done);
+            if (n >= 0) {
+                done += n;
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                co_return -errno;
+            co_await writable();
+        }
+        co_return static_cast<ssize_t>(done);
+    }
+
+private:
+    void release() {
+        if (state_ && state_->fd != -1) {
+            loop_->forget(state_.get());
+            close(state_->fd);
+        }
+        state_.reset();
+    }
+
+    EventLoop* loop_;
+    std::unique_ptr<IoState> state_; // 地址注册在 epoll 里，AsyncFd 移动时不能变
+};
+
+// 通过 pidfd 等待子进程
+class AsyncChild {
+public:
+    // pidfd 为 -1 时调用 pidfd_open
+    AsyncChild(EventLoop& loop, pid_t pid, int pidfd = -1)
+        : pid_(pid), fd_(loop, pidfd != -1 ? pidfd : pidfdOpenOrDie(pid)) {}
+
+    pid_t pid() const { return pid_; }
+
+    // 通过 pidfd 发信号，不会因为 pid 被复用而发错
+    int kill(int sig) { return pidfdSendSignal(fd_.fd(), sig); }
+
+    // 等待子进程退出并回收，返回 waitid() 的 siginfo_t
+    Task<siginfo_t> exit() {
+        for (;;) {
+            siginfo_t info{};
+            if (waitid(static_cast<idtype_t>(P_PIDFD), fd_.fd(), &info,
+                       WEXITED | WNOHANG) == -1) {
+                perror("waitid");
+                std::exit(EXIT_FAILURE);
+            }
+            if (info.si_pid != 0)
+                co_return info;
+            co_await fd_.readable();
+        }
+    }
+
+private:
+    static int pidfdOpenOrDie(pid_t pid) {
+        int fd = pidfdOpen(pid);
+        if (fd == -1) {
+            perror("pidfd_open");
+            std::exit(EXIT_FAILURE);
+        }
+        return fd;
+    }
+
+    pid_t pid_;
+    AsyncFd fd_;
+};
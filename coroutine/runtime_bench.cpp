@@ -0,0 +1,374 @@
+/**
+ * @brief 一个线程上的协程监督者与每个子进程一个线程的对比
+ * @details
+ * 创建 children 个子进程（默认 1000），每个子进程通过两个管道与父进程做 rounds 次
+ * size 字节的往返（默认 100 次、64 字节），然后以 exit code = 子进程序号 % 100 退出。
+ * 父进程一侧：
+ *      coroutine   一个线程，每个子进程一个协程：
+ *                  co_await to.write(msg) → co_await from.readExact(reply) → co_await child.exit()，
+ *                  最后一个结束的协程给自己发 SIGUSR1，另一个协程 co_await loop.signal(SIGUSR1)
+ *      threads     每个子进程一个线程：阻塞的 write / read / waitpid
+ * 两种方式分别在一个新的驱动进程中运行，报告每秒往返次数、驱动进程的内存峰值和上下文切换次数
+ * （getrusage(RUSAGE_SELF)，包括所有线程）。
+ * 每个回复和退出码都会检查。
+ *
+ * 驱动进程为每个子进程持有 3 个 fd（两个管道端和 pidfd）：启动时把 RLIMIT_NOFILE
+ * 的软限制提到硬限制，仍然不够时减少 children 并打印提示。
+ * 子进程只保留自己的两个管道端，驱动进程中途退出时它们读到 EOF 随之退出。
+ *
+ * 最后检查 FIFO 和定时器：同一个循环里一个协程每隔 1 毫秒向 FIFO 写一条消息，
+ * 另一个协程从同一个 FIFO 读出。
+ *
+ * @note
+ * g++ coroutine/runtime_bench.cpp -o out/a.out --std=c++20 -O2 -lpthread
+ * out/a.out [children=1000] [rounds=100] [size=64]
+ */
+#include "runtime.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <climits>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t MAX_SIZE = 4096;
+constexpr int FIFO_MESSAGES = 20;
+constexpr const char* FIFO_PATH = "/tmp/coroutine_bench_fifo";
+constexpr int FDS_PER_CHILD = 3; // 两个管道端 + pidfd
+constexpr int SPARE_FDS = 64;    // 标准流、epoll、signalfd、fork 时的临时管道等
+
+struct Child {
+    pid_t pid;
+    int to;   // 父进程写，子进程读
+    int from; // 子进程写，父进程读
+};
+
+// 驱动进程交回的结果
+struct Result {
+    double elapsed_ms;
+    uint64_t round_trips;
+    long maxrss_kb;
+    long ctx_switches;
+    int errors;
+};
+
+bool readAll(int fd, char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n <= 0)
+            return false;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 回复是请求的每个字节加一
+void fillMessage(char* msg, size_t size, int child, int round) {
+    for (size_t i = 0; i < size; ++i)
+        msg[i] = static_cast<char>(child * 7 + round * 3 + i);
+}
+
+bool checkReply(const char* reply, size_t size, int child, int round) {
+    for (size_t i = 0; i < size; ++i) {
+        if (reply[i] != static_cast<char>(child * 7 + round * 3 + i + 1))
+            return false;
+    }
+    return true;
+}
+
+int expectedExit(int child) { return child % 100; }
+
+// 关闭 a、b 之外继承来的所有 fd（标准流除外）
+void closeOtherFds(int a, int b) {
+    int lo = a < b ? a : b, hi = a < b ? b : a;
+    if ((lo > 3 && close_range(3, lo - 1, 0) == -1) ||
+        (hi > lo + 1 && close_range(lo + 1, hi - 1, 0) == -1) ||
+        close_range(hi + 1, ~0U, 0) == -1)
+        _exit(EXIT_FAILURE);
+}
+
+vector<Child> spawnEchoChildren(int children, int rounds, size_t size) {
+    vector<Child> result;
+    result.reserve(children);
+    for (int c = 0; c < children; ++c) {
+        int to[2], from[2];
+        if (pipe2(to, O_CLOEXEC) == -1 || pipe2(from, O_CLOEXEC) == -1) {
+            perror("pipe2");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            // 不持有之前的子进程和驱动进程结果管道的写端，它们才能读到 EOF
+            closeOtherFds(to[0], from[1]);
+            char buf[MAX_SIZE];
+            for (int r = 0; r < rounds; ++r) {
+                if (!readAll(to[0], buf, size))
+                    _exit(EXIT_FAILURE);
+                for (size_t i = 0; i < size; ++i)
+                    ++buf[i];
+                if (!writeAll(from[1], buf, size))
+                    _exit(EXIT_FAILURE);
+            }
+            _exit(expectedExit(c));
+        }
+        close(to[0]);
+        close(from[1]);
+        result.push_back(Child{pid, to[1], from[0]});
+    }
+    return result;
+}
+
+struct Shared {
+    int rounds;
+    size_t size;
+    int remaining; // 还没结束的监督协程
+    int errors;
+    uint64_t round_trips;
+};
+
+Task<void> superviseChild(EventLoop& loop, Child child, int index,
+                          Shared* shared) {
+    AsyncFd to(loop, child.to);
+    AsyncFd from(loop, child.from);
+    AsyncChild proc(loop, child.pid);
+
+    char msg[MAX_SIZE], reply[MAX_SIZE];
+    for (int r = 0; r < shared->rounds; ++r) {
+        fillMessage(msg, shared->size, index, r);
+        if (co_await to.write({msg, shared->size}) !=
+                static_cast<ssize_t>(shared->size) ||
+            !co_await from.readExact({reply, shared->size}) ||
+            !checkReply(reply, shared->size, index, r)) {
+            ++shared->errors;
+            proc.kill(SIGKILL);
+            break;
+        }
+        ++shared->round_trips;
+    }
+
+    siginfo_t info = co_await proc.exit();
+    if (info.si_code != CLD_EXITED || info.si_status != expectedExit(index))
+        ++shared->errors;
+    if (--shared->remaining == 0)
+        kill(getpid(), SIGUSR1);
+}
+
+Task<void> awaitDone(EventLoop& loop, Shared* shared) {
+    signalfd_siginfo info = co_await loop.signal(SIGUSR1);
+    if (info.ssi_signo != SIGUSR1 || shared->remaining != 0)
+        ++shared->errors;
+}
+
+Result runCoroutines(vector<Child>& children, int rounds, size_t size) {
+    Shared shared{rounds, size, static_cast<int>(children.size()), 0, 0};
+    EventLoop loop;
+    auto t0 = Clock::now();
+    // 先等信号：SIGUSR1 在第一次 signal() 时才被屏蔽
+    loop.spawn(awaitDone(loop, &shared));
+    for (size_t i = 0; i < children.size(); ++i)
+        loop.spawn(superviseChild(loop, children[i], static_cast<int>(i),
+                                  &shared));
+    loop.run();
+    double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return Result{ms, shared.round_trips, 0, 0, shared.errors};
+}
+
+Result runThreads(vector<Child>& children, int rounds, size_t size) {
+    std::atomic<int> errors{0};
+    std::atomic<uint64_t> round_trips{0};
+    auto t0 = Clock::now();
+    vector<std::thread> threads;
+    threads.reserve(children.size());
+    for (size_t i = 0; i < children.size(); ++i) {
+        threads.emplace_back([&, i] {
+            const Child& child = children[i];
+            int index = static_cast<int>(i);
+            char msg[MAX_SIZE], reply[MAX_SIZE];
+            for (int r = 0; r < rounds; ++r) {
+                fillMessage(msg, size, index, r);
+                if (!writeAll(child.to, msg, size) ||
+                    !readAll(child.from, reply, size) ||
+                    !checkReply(reply, size, index, r)) {
+                    ++errors;
+                    kill(child.pid, SIGKILL);
+                    break;
+                }
+                ++round_trips;
+            }
+            int status;
+            waitpid(child.pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != expectedExit(index))
+                ++errors;
+            close(child.to);
+            close(child.from);
+        });
+    }
+    for (std::thread& t : threads)
+        t.join();
+    double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return Result{ms, round_trips.load(), 0, 0, errors.load()};
+}
+
+// 在新的驱动进程中创建子进程并运行一种方式
+Result drive(bool coroutines, int children, int rounds, size_t size) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        vector<Child> kids = spawnEchoChildren(children, rounds, size);
+        Result r = coroutines ? runCoroutines(kids, rounds, size)
+                              : runThreads(kids, rounds, size);
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        r.maxrss_kb = usage.ru_maxrss;
+        r.ctx_switches = usage.ru_nvcsw + usage.ru_nivcsw;
+        writeAll(fds[1], reinterpret_cast<const char*>(&r), sizeof(r));
+        _exit(EXIT_SUCCESS);
+    }
+    close(fds[1]);
+    Result r{};
+    if (!readAll(fds[0], reinterpret_cast<char*>(&r), sizeof(r))) {
+        fprintf(stderr, "%s driver failed\n",
+                coroutines ? "coroutine" : "threads");
+        exit(EXIT_FAILURE);
+    }
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return r;
+}
+
+Task<void> fifoWriter(EventLoop& loop, AsyncFd& fifo, int* errors) {
+    for (int i = 0; i < FIFO_MESSAGES; ++i) {
+        char msg[24];
+        snprintf(msg, sizeof(msg), "message %04d\n", i);
+        if (co_await fifo.write({msg, strlen(msg)}) !=
+            static_cast<ssize_t>(strlen(msg)))
+            ++*errors;
+        co_await loop.sleep(std::chrono::milliseconds(1));
+    }
+}
+
+Task<void> fifoReader(AsyncFd& fifo, int* errors) {
+    for (int i = 0; i < FIFO_MESSAGES; ++i) {
+        char expect[24], got[24] = {};
+        snprintf(expect, sizeof(expect), "message %04d\n", i);
+        if (!co_await fifo.readExact({got, strlen(expect)}) ||
+            memcmp(got, expect, strlen(expect)) != 0)
+            ++*errors;
+    }
+}
+
+int fifoAndTimers() {
+    unlink(FIFO_PATH);
+    if (mkfifo(FIFO_PATH, 0600) == -1) {
+        perror("mkfifo");
+        exit(EXIT_FAILURE);
+    }
+    int errors = 0;
+    EventLoop loop;
+    AsyncFd writer = AsyncFd::openFifo(loop, FIFO_PATH);
+    AsyncFd reader = AsyncFd::openFifo(loop, FIFO_PATH);
+    auto t0 = Clock::now();
+    loop.spawn(fifoReader(reader, &errors));
+    loop.spawn(fifoWriter(loop, writer, &errors));
+    loop.run();
+    double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    unlink(FIFO_PATH);
+    printf("\nfifo: %d messages with 1 ms sleeps in %.1f ms, %s\n",
+           FIFO_MESSAGES, ms, errors == 0 ? "ok" : "FAILED");
+    return errors;
+}
+
+// 把打开文件数的软限制提到硬限制，返回驱动进程最多可以监督的子进程数
+int raiseFdLimit() {
+    rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == -1) {
+        perror("getrlimit");
+        exit(EXIT_FAILURE);
+    }
+    if (lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &lim) == -1) {
+            perror("setrlimit");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (lim.rlim_cur == RLIM_INFINITY || lim.rlim_cur > INT_MAX)
+        return INT_MAX;
+    return (static_cast<int>(lim.rlim_cur) - SPARE_FDS) / FDS_PER_CHILD;
+}
+
+int main(int argc, char* argv[]) {
+    int children = argc > 1 ? atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 100;
+    size_t size = argc > 3 ? strtoul(argv[3], nullptr, 10) : 64;
+    int max_children = raiseFdLimit();
+    if (children > max_children) {
+        fprintf(stderr, "RLIMIT_NOFILE allows %d children, using %d\n",
+                max_children, max_children);
+        children = max_children;
+    }
+    if (children <= 0 || rounds <= 0 || size == 0 || size > MAX_SIZE) {
+        fprintf(stderr, "children, rounds must be positive, size 1..%zu\n",
+                MAX_SIZE);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%d children x %d round trips of %zu bytes\n\n", children, rounds,
+           size);
+    printf("%-10s %12s %11s %11s %13s\n", "", "round_trips/s", "elapsed_ms",
+           "maxrss_kb", "ctx_switches");
+    int errors = 0;
+    for (bool coroutines : {true, false}) {
+        Result r = drive(coroutines, children, rounds, size);
+        printf("%-10s %12.0f %11.1f %11ld %13ld\n",
+               coroutines ? "coroutine" : "threads",
+               r.round_trips / (r.elapsed_ms / 1e3), r.elapsed_ms,
+               r.maxrss_kb, r.ctx_switches);
+        if (r.errors != 0 ||
+            r.round_trips != static_cast<uint64_t>(children) * rounds) {
+            fprintf(stderr, "%s: %d errors, %llu round trips\n",
+                    coroutines ? "coroutine" : "threads", r.errors,
+                    static_cast<unsigned long long>(r.round_trips));
+            ++errors;
+        }
+    }
+
+    errors += fifoAndTimers();
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,350 @@
+/**
+ * @brief 定长无符号大整数（128 - 4096 位）的加、减、乘和 Montgomery 乘法
+ * @details
+ * ./first.c 的例 4 用 addl / subl / imull / idivl 计算单个 int。
+ * 大整数由 n 个 64 位的 limb 组成（小端，r[0] 最低），n 最大为 BN_MAX_LIMBS，
+ * 运算的核心是进位链：每一个 limb 的结果都依赖上一个 limb 的进位。
+ *
+ * 加减法
+ *      bn_add_portable / bn_sub_portable   unsigned __int128 保存进位 / 借位
+ *      bn_add_adc / bn_sub_sbb             adc / sbb 进位链，循环计数用 inc / dec，
+ *                                          它们不修改 CF，进位在整个循环中留在 CF 里
+ * 乘法（r 有 2n 个 limb，不能与 a、b 重叠）
+ *      bn_mul_portable     逐行（schoolbook）：r += a * b[j]，unsigned __int128
+ *      bn_mul_mulq         逐行，每行用 mulq + adc
+ *      bn_mul_adx          逐行，每行用 mulx + adcx + adox：
+ *                          mulx 不修改标志位，adcx 只用 CF，adox 只用 OF，
+ *                          “高半部分进位”和“累加到 r”两条进位链交错进行，互不等待
+ *      bn_mul_comba        逐列（Comba）：第 k 列把所有 a[i] * b[k - i] 累加到
+ *                          三个 limb 的累加器里，每个结果 limb 只写一次
+ * Montgomery 乘法（CIOS）
+ *      bn_mont_mul_portable / _mulq / _adx 计算 a * b * 2^(-64n) mod m，
+ *      m 为奇数，a、b < m，minv = -m^(-1) mod 2^64（由 bn_mont_minv 计算）。
+ *      每一轮先加上 a * b[i]，再加上 q * m 让最低的 limb 变成 0，不需要除法。
+ *
+ * 不带后缀的 bn_add、bn_sub、bn_mul、bn_mont_mul 按 CPU 支持情况选择
+ * （mulx 需要 BMI2，adcx / adox 需要 ADX）。
+ * 这些函数都不是常数时间的，不要直接用在要防旁路攻击的密码学代码中。
+ *
+ * @details
+ * https://www.felixcloutier.com/x86/adcx
+ * https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/ia-large-integer-arithmetic-paper.pdf
+ * https://en.wikipedia.org/wiki/Montgomery_modular_multiplication
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BN_MAX_LIMBS 64 /* 4096 位 */
+
+typedef unsigned __int128 bn_u128;
+
+// r = a + b，返回最高位的进位；r 可以与 a 或 b 相同
+static inline uint64_t bn_add_portable(uint64_t* r, const uint64_t* a,
+                                       const uint64_t* b, size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        bn_u128 s = (bn_u128)a[i] + b[i] + carry;
+        r[i] = (uint64_t)s;
+        carry = (uint64_t)(s >> 64);
+    }
+    return carry;
+}
+
+// r = a - b，返回最高位的借位；r 可以与 a 或 b 相同
+static inline uint64_t bn_sub_portable(uint64_t* r, const uint64_t* a,
+                                       const uint64_t* b, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        bn_u128 d = (bn_u128)a[i] - b[i] - borrow;
+        r[i] = (uint64_t)d;
+        borrow = (uint64_t)(d >> 64) & 1;
+    }
+    return borrow;
+}
+
+static inline uint64_t bn_add_adc(uint64_t* r, const uint64_t* a,
+                                  const uint64_t* b, size_t n) {
+    if (n == 0)
+        return 0;
+    uint64_t carry, t;
+    size_t i = 0;
+    __asm__ __volatile__("clc;"
+                         "1:"
+                         "movq (%[a],%[i],8), %[t];"
+                         "adcq (%[b],%[i],8), %[t];"
+                         "movq %[t], (%[r],%[i],8);"
+                         "incq %[i];"
+                         "decq %[n];"
+                         "jnz 1b;"
+                         "sbbq %[c], %[c];" /* c = -CF */
+                         "negq %[c];"
+                         : [i] "+r"(i), [n] "+r"(n), [t] "=&r"(t),
+                           [c] "=r"(carry)
+                         : [r] "r"(r), [a] "r"(a), [b] "r"(b)
+                         : "cc", "memory");
+    return carry;
+}
+
+static inline uint64_t bn_sub_sbb(uint64_t* r, const uint64_t* a,
+                                  const uint64_t* b, size_t n) {
+    if (n == 0)
+        return 0;
+    uint64_t borrow, t;
+    size_t i = 0;
+    __asm__ __volatile__("clc;"
+                         "1:"
+                         "movq (%[a],%[i],8), %[t];"
+                         "sbbq (%[b],%[i],8), %[t];"
+                         "movq %[t], (%[r],%[i],8);"
+                         "incq %[i];"
+                         "decq %[n];"
+                         "jnz 1b;"
+                         "sbbq %[c], %[c];"
+                         "negq %[c];"
+                         : [i] "+r"(i), [n] "+r"(n), [t] "=&r"(t),
+                           [c] "=r"(borrow)
+                         : [r] "r"(r), [a] "r"(a), [b] "r"(b)
+                         : "cc", "memory");
+    return borrow;
+}
+
+// 比较 a 和 b，返回 -1、0、1
+static inline int bn_cmp(const uint64_t* a, const uint64_t* b, size_t n) {
+    while (n-- > 0) {
+        if (a[n] != b[n])
+            return a[n] < b[n] ? -1 : 1;
+    }
+    return 0;
+}
+
+/* ---- r[0..n) += a[0..n) * b，返回进位的 limb（GMP 中的 mpn_addmul_1） ---- */
+
+typedef uint64_t (*bn_addmul_fn)(uint64_t* r, const uint64_t* a, size_t n,
+                                 uint64_t b);
+
+static inline uint64_t bn_addmul_1_portable(uint64_t* r, const uint64_t* a,
+                                            size_t n, uint64_t b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        bn_u128 p = (bn_u128)a[i] * b + r[i] + carry;
+        r[i] = (uint64_t)p;
+        carry = (uint64_t)(p >> 64);
+    }
+    return carry;
+}
+
+static inline uint64_t bn_addmul_1_mulq(uint64_t* r, const uint64_t* a,
+                                        size_t n, uint64_t b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t lo = a[i], hi;
+        __asm__("mulq %[b];"
+                "addq %[ri], %%rax;"
+                "adcq $0, %%rdx;"
+                "addq %[c], %%rax;"
+                "adcq $0, %%rdx;"
+                : "+a"(lo), "=&d"(hi)
+                : [b] "rm"(b), [ri] "rm"(r[i]), [c] "rm"(carry)
+                : "cc");
+        r[i] = lo;
+        carry = hi;
+    }
+    return carry;
+}
+
+/**
+ * mulx 以 rdx 为隐含的乘数，结果写到两个任意寄存器，不改标志位。
+ * 循环计数用 lea + jrcxz，同样不改标志位，两条进位链跨过整个循环：
+ *      CF：lo += 上一个 hi
+ *      OF：lo += r[i]
+ * 循环结束后把两个进位都加到最后一个 hi 上（不会溢出）。
+ * 每次循环处理两个 limb，n 为奇数时第一个 limb 先用 __int128 算好。
+ */
+static inline uint64_t bn_addmul_1_adx(uint64_t* r, const uint64_t* a,
+                                       size_t n, uint64_t b) {
+    uint64_t prev = 0;
+    if (n & 1) {
+        bn_u128 p = (bn_u128)a[0] * b + r[0];
+        r[0] = (uint64_t)p;
+        prev = (uint64_t)(p >> 64);
+        ++a;
+        ++r;
+    }
+    size_t pairs = n / 2;
+    if (pairs == 0)
+        return prev;
+    uint64_t lo, hi;
+    __asm__ __volatile__("xorl %k[lo], %k[lo];" /* 清 CF、OF */
+                         "1:"
+                         "mulxq (%[a]), %[lo], %[hi];"
+                         "adcxq %[prev], %[lo];"
+                         "adoxq (%[r]), %[lo];"
+                         "movq %[lo], (%[r]);"
+                         "mulxq 8(%[a]), %[lo], %[prev];"
+                         "adcxq %[hi], %[lo];"
+                         "adoxq 8(%[r]), %[lo];"
+                         "movq %[lo], 8(%[r]);"
+                         "leaq 16(%[a]), %[a];"
+                         "leaq 16(%[r]), %[r];"
+                         "leaq -1(%%rcx), %%rcx;"
+                         "jrcxz 2f;"
+                         "jmp 1b;"
+                         "2:"
+                         "movl $0, %k[lo];"
+                         "adcxq %[lo], %[prev];"
+                         "adoxq %[lo], %[prev];"
+                         : [a] "+r"(a), [r] "+r"(r), "+c"(pairs),
+                           [prev] "+r"(prev), [lo] "=&r"(lo), [hi] "=&r"(hi)
+                         : "d"(b)
+                         : "cc", "memory");
+    return prev;
+}
+
+/* ---- 乘法 r[0..2n) = a * b ---- */
+
+static inline void bn_mul_rows(bn_addmul_fn addmul, uint64_t* r,
+                               const uint64_t* a, const uint64_t* b, size_t n) {
+    memset(r, 0, n * sizeof(uint64_t));
+    for (size_t j = 0; j < n; ++j)
+        r[j + n] = addmul(r + j, a, n, b[j]);
+}
+
+static inline void bn_mul_portable(uint64_t* r, const uint64_t* a,
+                                   const uint64_t* b, size_t n) {
+    bn_mul_rows(bn_addmul_1_portable, r, a, b, n);
+}
+
+static inline void bn_mul_mulq(uint64_t* r, const uint64_t* a,
+                               const uint64_t* b, size_t n) {
+    bn_mul_rows(bn_addmul_1_mulq, r, a, b, n);
+}
+
+static inline void bn_mul_adx(uint64_t* r, const uint64_t* a,
+                              const uint64_t* b, size_t n) {
+    bn_mul_rows(bn_addmul_1_adx, r, a, b, n);
+}
+
+// (c2, c1, c0) += x * y
+static inline void bn_muladd3(uint64_t* c0, uint64_t* c1, uint64_t* c2,
+                              uint64_t x, uint64_t y) {
+    uint64_t hi;
+    __asm__("mulq %[y];"
+            "addq %%rax, %[c0];"
+            "adcq %%rdx, %[c1];"
+            "adcq $0, %[c2];"
+            : "+a"(x), "=&d"(hi), [c0] "+r"(*c0), [c1] "+r"(*c1),
+              [c2] "+r"(*c2)
+            : [y] "rm"(y)
+            : "cc");
+}
+
+static inline void bn_mul_comba(uint64_t* r, const uint64_t* a,
+                                const uint64_t* b, size_t n) {
+    if (n == 0)
+        return;
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+    for (size_t k = 0; k + 1 < 2 * n; ++k) {
+        size_t lo = k < n ? 0 : k - n + 1;
+        size_t hi = k < n ? k : n - 1;
+        for (size_t i = lo; i <= hi; ++i)
+            bn_muladd3(&c0, &c1, &c2, a[i], b[k - i]);
+        r[k] = c0;
+        c0 = c1;
+        c1 = c2;
+        c2 = 0;
+    }
+    r[2 * n - 1] = c0;
+}
+
+/* ---- Montgomery 乘法 ---- */
+
+// -m0^(-1) mod 2^64，m0 为奇数；牛顿迭代每次把正确的位数翻倍
+static inline uint64_t bn_mont_minv(uint64_t m0) {
+    uint64_t x = m0; /* m0 * m0 ≡ 1 (mod 8)，已有 3 位正确 */
+    for (int i = 0; i < 5; ++i)
+        x *= 2 - m0 * x;
+    return -x;
+}
+
+// t[0..) += c，c 加在 t[0] 上，最多向后进位一次（见下面的说明）
+static inline void bn_add_carry(uint64_t* t, uint64_t c) {
+    t[0] += c;
+    t[1] += t[0] < c;
+}
+
+/**
+ * r = a * b * 2^(-64n) mod m
+ * t 有 2n + 2 个 limb，第 i 轮只修改 t[i .. i + n + 1]：
+ * 前面几轮最多进位到 t[i + n]，所以这一轮开始时 t[i + n + 1] 为 0，
+ * 两次 addmul 的进位加到 t[i + n] 上，最多再向 t[i + n + 1] 进 1，不会继续传递。
+ * 第 i 轮结束时 t[i] 为 0，n 轮之后结果在 t[n .. 2n]，小于 2m，最多减一次 m。
+ */
+static inline void bn_mont_mul_with(bn_addmul_fn addmul, uint64_t* r,
+                                    const uint64_t* a, const uint64_t* b,
+                                    const uint64_t* m, uint64_t minv,
+                                    size_t n) {
+    uint64_t t[2 * BN_MAX_LIMBS + 2];
+    memset(t, 0, (2 * n + 2) * sizeof(uint64_t));
+    for (size_t i = 0; i < n; ++i) {
+        bn_add_carry(t + i + n, addmul(t + i, a, n, b[i]));
+        uint64_t q = t[i] * minv;
+        bn_add_carry(t + i + n, addmul(t + i, m, n, q));
+    }
+    if (t[2 * n] != 0 || bn_cmp(t + n, m, n) >= 0)
+        bn_sub_portable(t + n, t + n, m, n);
+    memcpy(r, t + n, n * sizeof(uint64_t));
+}
+
+static inline void bn_mont_mul_portable(uint64_t* r, const uint64_t* a,
+                                        const uint64_t* b, const uint64_t* m,
+                                        uint64_t minv, size_t n) {
+    bn_mont_mul_with(bn_addmul_1_portable, r, a, b, m, minv, n);
+}
+
+static inline void bn_mont_mul_mulq(uint64_t* r, const uint64_t* a,
+                                    const uint64_t* b, const uint64_t* m,
+                                    uint64_t minv, size_t n) {
+    bn_mont_mul_with(bn_addmul_1_mulq, r, a, b, m, minv, n);
+}
+
+static inline void bn_mont_mul_adx(uint64_t* r, const uint64_t* a,
+                                   const uint64_t* b, const uint64_t* m,
+                                   uint64_t minv, size_t n) {
+    bn_mont_mul_with(bn_addmul_1_adx, r, a, b, m, minv, n);
+}
+
+/* ---- 按 CPU 选择 ---- */
+
+static inline int bn_has_adx(void) {
+    return __builtin_cpu_supports("adx") && __builtin_cpu_supports("bmi2");
+}
+
+static inline uint64_t bn_add(uint64_t* r, const uint64_t* a,
+                              const uint64_t* b, size_t n) {
+    return bn_add_adc(r, a, b, n);
+}
+
+static inline uint64_t bn_sub(uint64_t* r, const uint64_t* a,
+                              const uint64_t* b, size_t n) {
+    return bn_sub_sbb(r, a, b, n);
+}
+
+static inline void bn_mul(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                          size_t n) {
+    if (bn_has_adx())
+        bn_mul_adx(r, a, b, n);
+    else
+        bn_mul_mulq(r, a, b, n);
+}
+
+static inline void bn_mont_mul(uint64_t* r, const uint64_t* a,
+                               const uint64_t* b, const uint64_t* m,
+                               uint64_t minv, size_t n) {
+    if (bn_has_adx())
+        bn_mont_mul_adx(r, a, b, m, minv, n);
+    else
+        bn_mont_mul_mulq(r, a, b, m, minv, n);
+}
@@ -0,0 +1,332 @@
+/**
+ * @brief ./bignum.h 的差分测试与每个 limb 的周期数
+ * @details
+ * 参考实现按 32 位一段重新实现加、减、乘（uint64_t 保存中间结果），
+ * 取模用逐位移位相减，和 bignum.h 的所有代码路径都无关。
+ * 对 1 到 BN_MAX_LIMBS 之间的若干长度（包括奇数长度），用随机数和边界值
+ * （全 0、全 1、m - 1）检查：
+ *      加减法的结果和进位 / 借位；
+ *      各种乘法的 2n 个 limb；
+ *      Montgomery 乘法的结果 c 满足 c < m 且 c * 2^(64n) ≡ a * b (mod m)。
+ *
+ * 然后用 ../benchmark/bench.h 测量 128 到 4096 位时每个版本的 TSC 周期数：
+ * 加减法除以 n（每个 limb），乘法和 Montgomery 乘法除以 n^2（每对 limb 的乘积）。
+ *
+ * @note
+ * gcc inline-assembly/bignum_bench.c -o out/a.out -O2 -lm && out/a.out [tests=200]
+ */
+
+#include "../benchmark/bench.h"
+#include "bignum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REF_WORDS (4 * BN_MAX_LIMBS + 2) /* 32 位一段，能放下 2n + 1 个 limb */
+
+/* ---- 参考实现：32 位一段 ---- */
+
+static void to32(uint32_t* w, const uint64_t* x, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        w[2 * i] = (uint32_t)x[i];
+        w[2 * i + 1] = (uint32_t)(x[i] >> 32);
+    }
+}
+
+static void from32(uint64_t* x, const uint32_t* w, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        x[i] = (uint64_t)w[2 * i + 1] << 32 | w[2 * i];
+}
+
+static uint64_t ref_add(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                        size_t n) {
+    uint32_t wa[REF_WORDS], wb[REF_WORDS], wr[REF_WORDS];
+    to32(wa, a, n);
+    to32(wb, b, n);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        uint64_t s = (uint64_t)wa[i] + wb[i] + carry;
+        wr[i] = (uint32_t)s;
+        carry = s >> 32;
+    }
+    from32(r, wr, n);
+    return carry;
+}
+
+static uint64_t ref_sub(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                        size_t n) {
+    uint32_t wa[REF_WORDS], wb[REF_WORDS], wr[REF_WORDS];
+    to32(wa, a, n);
+    to32(wb, b, n);
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        uint64_t d = (uint64_t)wa[i] - wb[i] - borrow;
+        wr[i] = (uint32_t)d;
+        borrow = d >> 63;
+    }
+    from32(r, wr, n);
+    return borrow;
+}
+
+static void ref_mul(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                    size_t n) {
+    uint32_t wa[REF_WORDS], wb[REF_WORDS], wr[2 * REF_WORDS] = {0};
+    to32(wa, a, n);
+    to32(wb, b, n);
+    for (size_t i = 0; i < 2 * n; ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < 2 * n; ++j) {
+            uint64_t p = (uint64_t)wa[i] * wb[j] + wr[i + j] + carry;
+            wr[i + j] = (uint32_t)p;
+            carry = p >> 32;
+        }
+        wr[i + 2 * n] = (uint32_t)carry;
+    }
+    from32(r, wr, 2 * n);
+}
+
+// x（xn 个 limb）mod m（n 个 limb），逐位移入余数，余数不小于 m 就减去 m
+static void ref_mod(uint64_t* rem, const uint64_t* x, size_t xn,
+                    const uint64_t* m, size_t n) {
+    uint64_t r[BN_MAX_LIMBS + 1] = {0}, mm[BN_MAX_LIMBS + 1] = {0};
+    memcpy(mm, m, n * sizeof(uint64_t));
+    for (size_t bit = 64 * xn; bit-- > 0;) {
+        for (size_t i = n + 1; i-- > 1;)
+            r[i] = r[i] << 1 | r[i - 1] >> 63;
+        r[0] = r[0] << 1 | (x[bit / 64] >> (bit % 64) & 1);
+        uint64_t t[BN_MAX_LIMBS + 1];
+        if (!ref_sub(t, r, mm, n + 1))
+            memcpy(r, t, (n + 1) * sizeof(uint64_t));
+    }
+    memcpy(rem, r, n * sizeof(uint64_t));
+}
+
+/* ---- 测试数据 ---- */
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t rand64(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// kind 0：随机，1：全 0，2：全 1，3：随机的稀疏位
+static void fill(uint64_t* x, size_t n, int kind) {
+    for (size_t i = 0; i < n; ++i) {
+        switch (kind) {
+        case 0:
+            x[i] = rand64();
+            break;
+        case 1:
+            x[i] = 0;
+            break;
+        case 2:
+            x[i] = ~0ULL;
+            break;
+        default:
+            x[i] = rand64() & rand64() & rand64();
+        }
+    }
+}
+
+static void fail(const char* what, size_t n) {
+    printf("%s: mismatch at %zu limbs\n", what, n);
+    exit(EXIT_FAILURE);
+}
+
+typedef uint64_t (*bn_addsub_fn)(uint64_t*, const uint64_t*, const uint64_t*,
+                                 size_t);
+typedef void (*bn_mul_fn)(uint64_t*, const uint64_t*, const uint64_t*, size_t);
+typedef void (*bn_mont_fn)(uint64_t*, const uint64_t*, const uint64_t*,
+                           const uint64_t*, uint64_t, size_t);
+
+struct variant {
+    const char* name;
+    void* fn;
+    int supported;
+};
+
+enum op { OP_ADD, OP_SUB, OP_MUL, OP_MONT, NOPS };
+
+static const char* op_names[NOPS] = {"add", "sub", "mul", "mont_mul"};
+
+static struct variant variants[NOPS][4];
+static int nvariants[NOPS];
+
+static void add_variant(enum op op, const char* name, void* fn, int ok) {
+    variants[op][nvariants[op]++] = (struct variant){name, fn, ok};
+}
+
+static void test_size(size_t n, int tests) {
+    uint64_t a[BN_MAX_LIMBS], b[BN_MAX_LIMBS], m[BN_MAX_LIMBS];
+    uint64_t r[2 * BN_MAX_LIMBS], expect[2 * BN_MAX_LIMBS];
+    uint64_t lhs[BN_MAX_LIMBS], rhs[BN_MAX_LIMBS];
+    uint64_t shifted[2 * BN_MAX_LIMBS];
+
+    for (int t = 0; t < tests; ++t) {
+        fill(a, n, t < 16 ? t % 4 : 0);
+        fill(b, n, t < 16 ? t / 4 : 0);
+
+        uint64_t c = ref_add(expect, a, b, n);
+        for (int v = 0; v < nvariants[OP_ADD]; ++v) {
+            bn_addsub_fn fn = (bn_addsub_fn)variants[OP_ADD][v].fn;
+            if (fn(r, a, b, n) != c || memcmp(r, expect, n * 8) != 0)
+                fail(variants[OP_ADD][v].name, n);
+        }
+        c = ref_sub(expect, a, b, n);
+        for (int v = 0; v < nvariants[OP_SUB]; ++v) {
+            bn_addsub_fn fn = (bn_addsub_fn)variants[OP_SUB][v].fn;
+            if (fn(r, a, b, n) != c || memcmp(r, expect, n * 8) != 0)
+                fail(variants[OP_SUB][v].name, n);
+        }
+
+        ref_mul(expect, a, b, n);
+        for (int v = 0; v < nvariants[OP_MUL]; ++v) {
+            if (!variants[OP_MUL][v].supported)
+                continue;
+            bn_mul_fn fn = (bn_mul_fn)variants[OP_MUL][v].fn;
+            memset(r, 0xcc, sizeof(r));
+            fn(r, a, b, n);
+            if (memcmp(r, expect, 2 * n * 8) != 0)
+                fail(variants[OP_MUL][v].name, n);
+        }
+
+        // Montgomery：m 为奇数、最高位为 1；a、b < m，t == 0 时 a = b = m - 1
+        fill(m, n, 0);
+        m[0] |= 1;
+        m[n - 1] |= 1ULL << 63;
+        if (t == 0) {
+            uint64_t one[BN_MAX_LIMBS] = {1};
+            ref_sub(a, m, one, n);
+            memcpy(b, a, n * 8);
+        } else {
+            a[n - 1] %= m[n - 1];
+            b[n - 1] %= m[n - 1];
+        }
+        uint64_t minv = bn_mont_minv(m[0]);
+        if (m[0] * minv != ~0ULL)
+            fail("bn_mont_minv", n);
+        ref_mul(shifted, a, b, n);
+        ref_mod(rhs, shifted, 2 * n, m, n);
+        for (int v = 0; v < nvariants[OP_MONT]; ++v) {
+            if (!variants[OP_MONT][v].supported)
+                continue;
+            bn_mont_fn fn = (bn_mont_fn)variants[OP_MONT][v].fn;
+            fn(r, a, b, m, minv, n);
+            if (bn_cmp(r, m, n) >= 0)
+                fail(variants[OP_MONT][v].name, n);
+            memset(shifted, 0, n * 8);
+            memcpy(shifted + n, r, n * 8);
+            ref_mod(lhs, shifted, 2 * n, m, n);
+            if (memcmp(lhs, rhs, n * 8) != 0)
+                fail(variants[OP_MONT][v].name, n);
+        }
+    }
+}
+
+/* ---- 性能 ---- */
+
+struct job {
+    enum op op;
+    void* fn;
+    size_t n;
+    uint64_t a[BN_MAX_LIMBS], b[BN_MAX_LIMBS], m[BN_MAX_LIMBS];
+    uint64_t r[2 * BN_MAX_LIMBS];
+    uint64_t minv;
+};
+
+static void run_job(void* arg) {
+    struct job* j = arg;
+    switch (j->op) {
+    case OP_ADD:
+    case OP_SUB:
+        ((bn_addsub_fn)j->fn)(j->r, j->a, j->b, j->n);
+        break;
+    case OP_MUL:
+        ((bn_mul_fn)j->fn)(j->r, j->a, j->b, j->n);
+        break;
+    default:
+        ((bn_mont_fn)j->fn)(j->r, j->a, j->b, j->m, j->minv, j->n);
+    }
+    __asm__ __volatile__("" : : "r"(j->r) : "memory");
+}
+
+int main(int argc, char* argv[]) {
+    int tests = argc > 1 ? atoi(argv[1]) : 200;
+    int adx = bn_has_adx();
+
+    add_variant(OP_ADD, "portable", (void*)bn_add_portable, 1);
+    add_variant(OP_ADD, "adc", (void*)bn_add_adc, 1);
+    add_variant(OP_SUB, "portable", (void*)bn_sub_portable, 1);
+    add_variant(OP_SUB, "sbb", (void*)bn_sub_sbb, 1);
+    add_variant(OP_MUL, "portable", (void*)bn_mul_portable, 1);
+    add_variant(OP_MUL, "mulq", (void*)bn_mul_mulq, 1);
+    add_variant(OP_MUL, "comba", (void*)bn_mul_comba, 1);
+    add_variant(OP_MUL, "adx", (void*)bn_mul_adx, adx);
+    add_variant(OP_MONT, "portable", (void*)bn_mont_mul_portable, 1);
+    add_variant(OP_MONT, "mulq", (void*)bn_mont_mul_mulq, 1);
+    add_variant(OP_MONT, "adx", (void*)bn_mont_mul_adx, adx);
+
+    const size_t test_sizes[] = {1, 2, 3, 4, 5, 7, 8, 12, 16, 31, 32, 64};
+    for (size_t i = 0; i < sizeof(test_sizes) / sizeof(test_sizes[0]); ++i)
+        test_size(test_sizes[i], tests);
+    printf("differential tests passed (%d per size)%s\n\n", tests,
+           adx ? "" : ", adx not supported");
+
+    bench_init(NULL);
+    static struct job job;
+    fill(job.a, BN_MAX_LIMBS, 0);
+    fill(job.b, BN_MAX_LIMBS, 0);
+    fill(job.m, BN_MAX_LIMBS, 0);
+    // 每个 limb 的最高位：m 为 1，a、b 为 0，任何长度下都有 a、b < m
+    for (int i = 0; i < BN_MAX_LIMBS; ++i) {
+        job.a[i] >>= 1;
+        job.b[i] >>= 1;
+        job.m[i] |= 1ULL << 63;
+    }
+    job.m[0] |= 1;
+    job.minv = bn_mont_minv(job.m[0]);
+    const size_t sizes[] = {2, 4, 8, 16, 32, 64};
+    const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (int op = 0; op < NOPS; ++op) {
+        if (bench_cfg.format == BENCH_TEXT) {
+            printf("%-9s", op == OP_ADD || op == OP_SUB ? "cyc/limb"
+                                                        : "cyc/limb^2");
+            for (int s = 0; s < nsizes; ++s)
+                printf(" %7zub", sizes[s] * 64);
+            printf("\n");
+        }
+        for (int v = 0; v < nvariants[op]; ++v) {
+            if (!variants[op][v].supported)
+                continue;
+            char row[256];
+            int len = snprintf(row, sizeof(row), "%-9s",
+                               variants[op][v].name);
+            for (int s = 0; s < nsizes; ++s) {
+                size_t n = sizes[s];
+                job.op = (enum op)op;
+                job.fn = variants[op][v].fn;
+                job.n = n;
+
+                char name[64];
+                snprintf(name, sizeof(name), "%s_%s_%zu", op_names[op],
+                         variants[op][v].name, n * 64);
+                struct bench_result r = bench_run(name, run_job, &job, 1);
+                if (bench_cfg.format != BENCH_TEXT)
+                    bench_report(&r);
+                double per = op == OP_ADD || op == OP_SUB ? (double)n
+                                                          : (double)(n * n);
+                len += snprintf(row + len, sizeof(row) - len, " %8.2f",
+                                r.tsc_cycles / per);
+            }
+            if (bench_cfg.format == BENCH_TEXT)
+                printf("%s  %s\n", row, op_names[op]);
+        }
+        if (bench_cfg.format == BENCH_TEXT)
+            printf("\n");
+    }
+    return 0;
+}
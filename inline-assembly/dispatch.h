@@ -0,0 +1,369 @@
+/**
+ * @brief 用 cpuid 检测 CPU 特性，程序启动时为每个内核选定一个版本
+ * @details
+ * ./first.c 里的例子都只有一种写法（x87 或 32 位整数指令），不检查 CPU 支持什么。
+ * ./gcd.h、./vmath.h、./bignum.h、./divider.h 的每个内核都有多个版本，
+ * 它们自带的 gcd_batch、bn_mul 等每次调用都用 __builtin_cpu_supports 判断一次。
+ * 这里换一种方式：
+ *
+ * cpu_probe()
+ *      直接执行 cpuid（叶 1 和叶 7），检测 SSE4.2、AVX、AVX2、FMA、BMI1、BMI2、
+ *      ADX、AVX-512F。AVX / AVX-512 还要看操作系统是否保存对应的寄存器状态：
+ *      CPUID.1:ECX.OSXSAVE 为 1 时用 xgetbv 读 XCR0，
+ *      AVX 需要 XMM | YMM（0x6），AVX-512 还需要 opmask | ZMM（0xe0）。
+ * kernel_variants_*
+ *      每个内核的版本表，最快的在前，最后一个是不需要任何扩展的参考实现。
+ * kernels
+ *      函数指针表，构造函数 kernels_init() 在 main 之前填好，
+ *      之后调用 kernels.gcd_batch(...) 只是一次间接调用，不再检测 CPU。
+ *      没有用 GNU ifunc：它的解析函数在重定位完成之前运行，不能安全地调用 getenv。
+ *
+ * 环境变量 KERNEL_VARIANT 可以强制选择某个版本，多项用逗号分隔：
+ *      KERNEL_VARIANT=scalar                    所有有 scalar 版本的内核都用它
+ *      KERNEL_VARIANT=bn_mul:comba,sse          bn_mul 用 comba，其余有 sse 的用 sse
+ * 指定内核的一项优先于不指定内核的一项，不指定内核的一项只对有这个版本的内核生效。
+ * 指定内核时写错的版本名，以及 CPU 不支持的版本，会打印警告并按默认规则选择
+ * （直接运行不支持的指令会 SIGILL）。
+ *
+ * 自检程序 ./dispatch_selftest.c 把每个版本和参考实现比较。
+ *
+ * @details
+ * https://www.felixcloutier.com/x86/cpuid
+ * https://www.felixcloutier.com/x86/xgetbv
+ * https://sourceware.org/glibc/wiki/GNU_IFUNC
+ */
+#pragma once
+
+#include "bignum.h"
+#include "divider.h"
+#include "gcd.h"
+#include "vmath.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum cpu_feature {
+    CPU_SSE42 = 1 << 0,
+    CPU_AVX = 1 << 1,
+    CPU_AVX2 = 1 << 2,
+    CPU_FMA = 1 << 3,
+    CPU_BMI1 = 1 << 4,
+    CPU_BMI2 = 1 << 5,
+    CPU_ADX = 1 << 6,
+    CPU_AVX512F = 1 << 7,
+};
+
+#define CPU_FEATURE_COUNT 8
+
+static const char* const cpu_feature_names[CPU_FEATURE_COUNT] = {
+    "sse4.2", "avx", "avx2", "fma", "bmi1", "bmi2", "adx", "avx512f"};
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+    __asm__ __volatile__("cpuid"
+                         : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]),
+                           "=d"(regs[3])
+                         : "a"(leaf), "c"(subleaf));
+}
+
+// XCR0：操作系统在上下文切换时保存哪些寄存器状态
+static inline uint64_t xgetbv(uint32_t index) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(index));
+    return (uint64_t)hi << 32 | lo;
+}
+
+static inline uint32_t cpu_probe(void) {
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    if (max_leaf < 1)
+        return 0;
+
+    uint32_t features = 0;
+    cpuid(1, 0, regs);
+    uint32_t ecx1 = regs[2];
+    if (ecx1 & (1u << 20))
+        features |= CPU_SSE42;
+    uint64_t xcr0 = 0;
+    if (ecx1 & (1u << 27)) /* OSXSAVE */
+        xcr0 = xgetbv(0);
+    int os_avx = (xcr0 & 0x6) == 0x6;
+    int os_avx512 = os_avx && (xcr0 & 0xe0) == 0xe0;
+    if (os_avx && (ecx1 & (1u << 28)))
+        features |= CPU_AVX;
+    if (os_avx && (ecx1 & (1u << 12)))
+        features |= CPU_FMA;
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        uint32_t ebx7 = regs[1];
+        if (ebx7 & (1u << 3))
+            features |= CPU_BMI1;
+        if (os_avx && (ebx7 & (1u << 5)))
+            features |= CPU_AVX2;
+        if (ebx7 & (1u << 8))
+            features |= CPU_BMI2;
+        if (os_avx512 && (ebx7 & (1u << 16)))
+            features |= CPU_AVX512F;
+        if (ebx7 & (1u << 19))
+            features |= CPU_ADX;
+    }
+    return features;
+}
+
+/* ---- 版本表 ---- */
+
+typedef void (*kernel_gcd_fn)(const uint32_t*, const uint32_t*, uint32_t*,
+                              size_t);
+typedef void (*kernel_vmath_fn)(const float*, float*, size_t);
+typedef void (*kernel_sincos_fn)(const float*, float*, float*, size_t);
+typedef uint64_t (*kernel_bn_addsub_fn)(uint64_t*, const uint64_t*,
+                                        const uint64_t*, size_t);
+typedef void (*kernel_bn_mul_fn)(uint64_t*, const uint64_t*, const uint64_t*,
+                                 size_t);
+typedef void (*kernel_bn_mont_fn)(uint64_t*, const uint64_t*, const uint64_t*,
+                                  const uint64_t*, uint64_t, size_t);
+#define KERNEL_DIVIDER_FNS(T, TYPE)                                            \
+    typedef void (*kernel_div_##TYPE##_fn)(const struct divider_##TYPE*,       \
+                                           const T*, T*, size_t);              \
+    typedef void (*kernel_divmod_##TYPE##_fn)(const struct divider_##TYPE*,    \
+                                              const T*, T*, T*, size_t);
+KERNEL_DIVIDER_FNS(uint32_t, u32)
+KERNEL_DIVIDER_FNS(int32_t, s32)
+KERNEL_DIVIDER_FNS(uint64_t, u64)
+KERNEL_DIVIDER_FNS(int64_t, s64)
+#undef KERNEL_DIVIDER_FNS
+
+struct kernel_variant {
+    const char* name;
+    uint32_t needs; /* 需要的 CPU_* */
+    void (*fn)(void);
+};
+
+#define KERNEL_VARIANT(name, needs, fn) {name, needs, (void (*)(void))(fn)}
+
+// vmath 的参考实现：逐个调用 libm
+static inline void sin_batch_scalar(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = sinf(x[i]);
+}
+
+static inline void cos_batch_scalar(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = cosf(x[i]);
+}
+
+static inline void sincos_batch_scalar(const float* x, float* sin_out,
+                                       float* cos_out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        sin_out[i] = sinf(x[i]);
+        cos_out[i] = cosf(x[i]);
+    }
+}
+
+static inline void sqrt_batch_scalar(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = sqrtf(x[i]);
+}
+
+static const struct kernel_variant kernel_variants_gcd_batch[] = {
+    KERNEL_VARIANT("avx2", CPU_AVX2, gcd_batch_avx2),
+    KERNEL_VARIANT("bmi", CPU_BMI1, gcd_batch_bmi),
+    KERNEL_VARIANT("scalar", 0, gcd_batch_scalar),
+};
+
+#define KERNEL_VMATH_VARIANTS(op)                                              \
+    static const struct kernel_variant kernel_variants_##op[] = {              \
+        KERNEL_VARIANT("avx512", CPU_AVX512F, op##_avx512),                    \
+        KERNEL_VARIANT("avx2", CPU_AVX2 | CPU_FMA, op##_avx2),                 \
+        KERNEL_VARIANT("sse", 0, op##_sse),                                    \
+        KERNEL_VARIANT("scalar", 0, op##_scalar),                              \
+    };
+KERNEL_VMATH_VARIANTS(sin_batch)
+KERNEL_VMATH_VARIANTS(cos_batch)
+KERNEL_VMATH_VARIANTS(sincos_batch)
+KERNEL_VMATH_VARIANTS(sqrt_batch)
+#undef KERNEL_VMATH_VARIANTS
+
+static const struct kernel_variant kernel_variants_bn_add[] = {
+    KERNEL_VARIANT("adc", 0, bn_add_adc),
+    KERNEL_VARIANT("scalar", 0, bn_add_portable),
+};
+
+static const struct kernel_variant kernel_variants_bn_sub[] = {
+    KERNEL_VARIANT("sbb", 0, bn_sub_sbb),
+    KERNEL_VARIANT("scalar", 0, bn_sub_portable),
+};
+
+static const struct kernel_variant kernel_variants_bn_mul[] = {
+    KERNEL_VARIANT("adx", CPU_ADX | CPU_BMI2, bn_mul_adx),
+    KERNEL_VARIANT("mulq", 0, bn_mul_mulq),
+    KERNEL_VARIANT("comba", 0, bn_mul_comba),
+    KERNEL_VARIANT("scalar", 0, bn_mul_portable),
+};
+
+static const struct kernel_variant kernel_variants_bn_mont_mul[] = {
+    KERNEL_VARIANT("adx", CPU_ADX | CPU_BMI2, bn_mont_mul_adx),
+    KERNEL_VARIANT("mulq", 0, bn_mont_mul_mulq),
+    KERNEL_VARIANT("scalar", 0, bn_mont_mul_portable),
+};
+
+#define KERNEL_DIVIDER_VARIANTS(op)                                            \
+    static const struct kernel_variant kernel_variants_##op[] = {              \
+        KERNEL_VARIANT("avx2", CPU_AVX2, op##_avx2),                           \
+        KERNEL_VARIANT("scalar", 0, op##_scalar),                              \
+    };
+#define KERNEL_DIVIDER_TYPE(TYPE)                                              \
+    KERNEL_DIVIDER_VARIANTS(div_##TYPE##_batch)                                \
+    KERNEL_DIVIDER_VARIANTS(mod_##TYPE##_batch)                                \
+    KERNEL_DIVIDER_VARIANTS(divmod_##TYPE##_batch)
+KERNEL_DIVIDER_TYPE(u32)
+KERNEL_DIVIDER_TYPE(s32)
+KERNEL_DIVIDER_TYPE(u64)
+KERNEL_DIVIDER_TYPE(s64)
+#undef KERNEL_DIVIDER_TYPE
+#undef KERNEL_DIVIDER_VARIANTS
+
+/* ---- 函数指针表 ---- */
+
+#define KERNEL_DIVIDER_LIST(X, TYPE)                                           \
+    X(div_##TYPE##_batch, kernel_div_##TYPE##_fn)                              \
+    X(mod_##TYPE##_batch, kernel_div_##TYPE##_fn)                              \
+    X(divmod_##TYPE##_batch, kernel_divmod_##TYPE##_fn)
+
+// X(内核名, 函数指针类型)
+#define KERNEL_LIST(X)                                                         \
+    X(gcd_batch, kernel_gcd_fn)                                                \
+    X(sin_batch, kernel_vmath_fn)                                              \
+    X(cos_batch, kernel_vmath_fn)                                              \
+    X(sincos_batch, kernel_sincos_fn)                                          \
+    X(sqrt_batch, kernel_vmath_fn)                                             \
+    X(bn_add, kernel_bn_addsub_fn)                                             \
+    X(bn_sub, kernel_bn_addsub_fn)                                             \
+    X(bn_mul, kernel_bn_mul_fn)                                                \
+    X(bn_mont_mul, kernel_bn_mont_fn)                                          \
+    KERNEL_DIVIDER_LIST(X, u32)                                                \
+    KERNEL_DIVIDER_LIST(X, s32)                                                \
+    KERNEL_DIVIDER_LIST(X, u64)                                                \
+    KERNEL_DIVIDER_LIST(X, s64)
+
+enum kernel_id {
+#define KERNEL_ID(name, type) KERNEL_##name,
+    KERNEL_LIST(KERNEL_ID)
+#undef KERNEL_ID
+        KERNEL_COUNT
+};
+
+struct kernel_table {
+    const char* name;
+    const struct kernel_variant* variants;
+    size_t nvariants;
+};
+
+static const struct kernel_table kernel_tables[KERNEL_COUNT] = {
+#define KERNEL_TABLE(name, type)                                               \
+    {#name, kernel_variants_##name,                                            \
+     sizeof(kernel_variants_##name) / sizeof(kernel_variants_##name[0])},
+    KERNEL_LIST(KERNEL_TABLE)
+#undef KERNEL_TABLE
+};
+
+static struct kernels {
+#define KERNEL_FIELD(name, type) type name;
+    KERNEL_LIST(KERNEL_FIELD)
+#undef KERNEL_FIELD
+} kernels;
+
+static uint32_t kernel_cpu_features;
+static const struct kernel_variant* kernel_chosen[KERNEL_COUNT];
+
+static inline int kernel_supported(const struct kernel_variant* v,
+                                   uint32_t features) {
+    return (v->needs & features) == v->needs;
+}
+
+/**
+ * @brief 在 override（KERNEL_VARIANT 的值）中找 kernel 要用的版本名
+ * @return 名字的长度，没有时为 0；*name 指向 override 中的名字，
+ *         *specific 表示这一项是否指定了内核
+ */
+static inline size_t kernel_override(const char* override, const char* kernel,
+                                     const char** name, int* specific) {
+    size_t found = 0;
+    size_t klen = strlen(kernel);
+    *specific = 0;
+    for (const char* p = override; p != NULL && *p != '\0';) {
+        const char* end = strchr(p, ',');
+        size_t len = end != NULL ? (size_t)(end - p) : strlen(p);
+        const char* colon = memchr(p, ':', len);
+        if (colon == NULL) {
+            if (found == 0) {
+                *name = p;
+                found = len;
+            }
+        } else if ((size_t)(colon - p) == klen &&
+                   strncmp(p, kernel, klen) == 0) {
+            *name = colon + 1;
+            *specific = 1;
+            return len - klen - 1;
+        }
+        p = end != NULL ? end + 1 : NULL;
+    }
+    return found;
+}
+
+static inline const struct kernel_variant*
+kernel_resolve(const struct kernel_table* table, uint32_t features,
+               const char* override) {
+    const struct kernel_variant* best = NULL;
+    for (size_t i = 0; i < table->nvariants && best == NULL; ++i)
+        if (kernel_supported(&table->variants[i], features))
+            best = &table->variants[i];
+
+    const char* name;
+    int specific;
+    size_t len = kernel_override(override, table->name, &name, &specific);
+    if (len == 0)
+        return best;
+    for (size_t i = 0; i < table->nvariants; ++i) {
+        const struct kernel_variant* v = &table->variants[i];
+        if (strlen(v->name) != len || strncmp(v->name, name, len) != 0)
+            continue;
+        if (kernel_supported(v, features))
+            return v;
+        fprintf(stderr, "KERNEL_VARIANT: %s: %s not supported, using %s\n",
+                table->name, v->name, best->name);
+        return best;
+    }
+    // 不指定内核的一项只对有这个版本的内核生效
+    if (specific)
+        fprintf(stderr, "KERNEL_VARIANT: %s: no variant %.*s, using %s\n",
+                table->name, (int)len, name, best->name);
+    return best;
+}
+
+__attribute__((constructor)) static void kernels_init(void) {
+    kernel_cpu_features = cpu_probe();
+    const char* override = getenv("KERNEL_VARIANT");
+    for (int id = 0; id < KERNEL_COUNT; ++id)
+        kernel_chosen[id] =
+            kernel_resolve(&kernel_tables[id], kernel_cpu_features, override);
+#define KERNEL_SET(name, type)                                                 \
+    kernels.name = (type)kernel_chosen[KERNEL_##name]->fn;
+    KERNEL_LIST(KERNEL_SET)
+#undef KERNEL_SET
+}
+
+// 打印检测到的 CPU 特性和每个内核选中的版本
+static inline void kernels_report(FILE* out) {
+    fprintf(out, "cpu:");
+    for (int i = 0; i < CPU_FEATURE_COUNT; ++i)
+        if (kernel_cpu_features & (1u << i))
+            fprintf(out, " %s", cpu_feature_names[i]);
+    fprintf(out, "\n");
+    for (int id = 0; id < KERNEL_COUNT; ++id)
+        fprintf(out, "%-20s %s\n", kernel_tables[id].name,
+                kernel_chosen[id]->name);
+}
@@ -0,0 +1,268 @@
+/**
+ * @brief ./dispatch.h 的自检：每个内核的每个版本都和参考实现比较
+ * @details
+ * 先打印 cpuid 检测到的特性和每个内核选中的版本（受 KERNEL_VARIANT 影响），
+ * 然后对 kernel_tables 中的每个内核，用同一组输入运行 CPU 支持的所有版本，
+ * 和表中最后一个版本（参考实现）比较：
+ *      gcd_batch               边界值和随机数对，结果完全一致
+ *      sin / cos / sincos      [-100, 100] 内的随机数，与 libm 的绝对误差不超过 VMATH_TOLERANCE
+ *      sqrt                    sqrtps 和 sqrtf 都是正确舍入的，结果完全一致
+ *      bn_*                    1 到 BN_MAX_LIMBS 个 limb 的随机数，结果和进位完全一致
+ *      div / mod / divmod      随机的除数和被除数，结果完全一致
+ * 最后通过 kernels 函数指针表调用一次选中的版本。
+ * 有不一致时打印内核和版本名，以失败状态退出。
+ *
+ * @note
+ * gcc inline-assembly/dispatch_selftest.c -o out/a.out -O2 -lm && out/a.out
+ * KERNEL_VARIANT=scalar,bn_mul:comba out/a.out
+ */
+
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 1000 /* 每组输入的个数，不是 8 的倍数 */
+#define VMATH_TOLERANCE 2e-6f
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t random64(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int failures;
+
+static void report(const struct kernel_table* table,
+                   const struct kernel_variant* v, int ok) {
+    printf("  %-20s %-8s %s\n", table->name, v->name,
+           !kernel_supported(v, kernel_cpu_features) ? "not supported"
+           : ok                                      ? "ok"
+                                                     : "MISMATCH");
+    if (!ok)
+        ++failures;
+}
+
+// 表中最后一个版本是参考实现
+static const struct kernel_variant* reference(const struct kernel_table* t) {
+    return &t->variants[t->nvariants - 1];
+}
+
+static void test_gcd(const struct kernel_table* table) {
+    static uint32_t a[N], b[N], expect[N], out[N];
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = i < 8 ? (uint32_t)i : (uint32_t)random64() >> (i % 32);
+        b[i] = i < 8 ? 0 : (uint32_t)random64() >> (i % 17);
+    }
+    ((kernel_gcd_fn)reference(table)->fn)(a, b, expect, N);
+    for (size_t v = 0; v < table->nvariants; ++v) {
+        const struct kernel_variant* var = &table->variants[v];
+        int ok = 1;
+        if (kernel_supported(var, kernel_cpu_features)) {
+            ((kernel_gcd_fn)var->fn)(a, b, out, N);
+            ok = memcmp(out, expect, sizeof(out)) == 0;
+        }
+        report(table, var, ok);
+    }
+}
+
+static int close_enough(const float* a, const float* b, int exact) {
+    for (size_t i = 0; i < N; ++i) {
+        float d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (exact ? a[i] != b[i] : !(d <= VMATH_TOLERANCE))
+            return 0;
+    }
+    return 1;
+}
+
+static void test_vmath(const struct kernel_table* table, int sincos,
+                       int exact) {
+    static float x[N], expect0[N], expect1[N], out0[N], out1[N];
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = (float)(random64() >> 11) / (float)(1ULL << 53) * 200 - 100;
+        if (exact)
+            x[i] = x[i] < 0 ? -x[i] : x[i];
+    }
+    const struct kernel_variant* ref = reference(table);
+    if (sincos)
+        ((kernel_sincos_fn)ref->fn)(x, expect0, expect1, N);
+    else
+        ((kernel_vmath_fn)ref->fn)(x, expect0, N);
+    for (size_t v = 0; v < table->nvariants; ++v) {
+        const struct kernel_variant* var = &table->variants[v];
+        int ok = 1;
+        if (kernel_supported(var, kernel_cpu_features)) {
+            if (sincos) {
+                ((kernel_sincos_fn)var->fn)(x, out0, out1, N);
+                ok = close_enough(out0, expect0, exact) &&
+                     close_enough(out1, expect1, exact);
+            } else {
+                ((kernel_vmath_fn)var->fn)(x, out0, N);
+                ok = close_enough(out0, expect0, exact);
+            }
+        }
+        report(table, var, ok);
+    }
+}
+
+enum bn_op { BN_ADDSUB, BN_MUL, BN_MONT };
+
+static int bn_run(const struct kernel_variant* var, enum bn_op op, size_t n,
+                  const uint64_t* a, const uint64_t* b, const uint64_t* m,
+                  uint64_t minv, uint64_t* r) {
+    memset(r, 0, 2 * BN_MAX_LIMBS * sizeof(uint64_t));
+    switch (op) {
+    case BN_ADDSUB:
+        return (int)((kernel_bn_addsub_fn)var->fn)(r, a, b, n);
+    case BN_MUL:
+        ((kernel_bn_mul_fn)var->fn)(r, a, b, n);
+        return 0;
+    default:
+        ((kernel_bn_mont_fn)var->fn)(r, a, b, m, minv, n);
+        return 0;
+    }
+}
+
+static void test_bn(const struct kernel_table* table, enum bn_op op) {
+    uint64_t a[BN_MAX_LIMBS], b[BN_MAX_LIMBS], m[BN_MAX_LIMBS];
+    uint64_t r[2 * BN_MAX_LIMBS], expect[2 * BN_MAX_LIMBS];
+    for (size_t v = 0; v < table->nvariants; ++v) {
+        const struct kernel_variant* var = &table->variants[v];
+        int ok = 1;
+        for (size_t n = 1; n <= BN_MAX_LIMBS && ok; ++n) {
+            if (!kernel_supported(var, kernel_cpu_features))
+                break;
+            for (size_t i = 0; i < n; ++i) {
+                m[i] = random64();
+                a[i] = random64() >> 1; /* 最高的 limb 小于 m 的，a、b < m */
+                b[i] = random64() >> 1;
+            }
+            m[0] |= 1;
+            m[n - 1] |= 1ULL << 63;
+            uint64_t minv = bn_mont_minv(m[0]);
+            int c = bn_run(reference(table), op, n, a, b, m, minv, expect);
+            int got = bn_run(var, op, n, a, b, m, minv, r);
+            ok = c == got &&
+                 memcmp(r, expect, (op == BN_MUL ? 2 : 1) * n * 8) == 0;
+        }
+        report(table, var, ok);
+    }
+}
+
+/**
+ * 除法内核：同一个除数、同一组被除数，和参考实现比较商和余数。
+ * 除数在 32 位和 64 位类型之间共用，只取低位；0 换成 7，-1 换成 -3（避免 MIN / -1）。
+ */
+#define DEFINE_TEST_DIV(TYPE, T)                                               \
+    static void test_##TYPE(const struct kernel_table* table, int divmod,      \
+                            int64_t d, int first) {                            \
+        static T n[N], q[N], r[N], expect_q[N], expect_r[N];                   \
+        T dt = (T)d == 0 ? 7 : (T)d == (T)-1 ? (T)-3 : (T)d;                   \
+        struct divider_##TYPE dv = divider_gen_##TYPE(dt);                     \
+        for (size_t i = 0; i < N; ++i)                                         \
+            n[i] = (T)(random64() >> (i % 64));                                \
+        const struct kernel_variant* ref = reference(table);                   \
+        if (divmod)                                                            \
+            ((kernel_divmod_##TYPE##_fn)ref->fn)(&dv, n, expect_q, expect_r,   \
+                                                 N);                           \
+        else                                                                   \
+            ((kernel_div_##TYPE##_fn)ref->fn)(&dv, n, expect_q, N);            \
+        for (size_t v = 0; v < table->nvariants; ++v) {                        \
+            const struct kernel_variant* var = &table->variants[v];            \
+            int ok = 1;                                                        \
+            if (kernel_supported(var, kernel_cpu_features)) {                  \
+                if (divmod)                                                    \
+                    ((kernel_divmod_##TYPE##_fn)var->fn)(&dv, n, q, r, N);     \
+                else                                                           \
+                    ((kernel_div_##TYPE##_fn)var->fn)(&dv, n, q, N);           \
+                ok = memcmp(q, expect_q, sizeof(q)) == 0 &&                    \
+                     (!divmod || memcmp(r, expect_r, sizeof(r)) == 0);         \
+            }                                                                  \
+            if (!ok || first)                                                  \
+                report(table, var, ok);                                        \
+        }                                                                      \
+    }
+
+DEFINE_TEST_DIV(u32, uint32_t)
+DEFINE_TEST_DIV(s32, int32_t)
+DEFINE_TEST_DIV(u64, uint64_t)
+DEFINE_TEST_DIV(s64, int64_t)
+
+// 对除法内核试很多个除数，只报告第一个除数的结果和所有不一致
+static void test_div(int id) {
+    const struct kernel_table* table = &kernel_tables[id];
+    int divmod = strncmp(table->name, "divmod_", 7) == 0;
+    const char* type = strchr(table->name, '_') + 1;
+    for (int t = 0; t < 2000; ++t) {
+        int64_t d = (int64_t)(random64() >> (random64() % 64));
+        if (t % 2)
+            d = -d;
+        if (strncmp(type, "u32", 3) == 0)
+            test_u32(table, divmod, d, t == 0);
+        else if (strncmp(type, "s32", 3) == 0)
+            test_s32(table, divmod, d, t == 0);
+        else if (strncmp(type, "u64", 3) == 0)
+            test_u64(table, divmod, d, t == 0);
+        else
+            test_s64(table, divmod, d, t == 0);
+    }
+}
+
+int main(void) {
+    kernels_report(stdout);
+    printf("\nvariants against the reference (last variant of each kernel):\n");
+    for (int id = 0; id < KERNEL_COUNT; ++id) {
+        const struct kernel_table* table = &kernel_tables[id];
+        switch (id) {
+        case KERNEL_gcd_batch:
+            test_gcd(table);
+            break;
+        case KERNEL_sin_batch:
+        case KERNEL_cos_batch:
+            test_vmath(table, 0, 0);
+            break;
+        case KERNEL_sincos_batch:
+            test_vmath(table, 1, 0);
+            break;
+        case KERNEL_sqrt_batch:
+            test_vmath(table, 0, 1);
+            break;
+        case KERNEL_bn_add:
+        case KERNEL_bn_sub:
+            test_bn(table, BN_ADDSUB);
+            break;
+        case KERNEL_bn_mul:
+            test_bn(table, BN_MUL);
+            break;
+        case KERNEL_bn_mont_mul:
+            test_bn(table, BN_MONT);
+            break;
+        default:
+            test_div(id);
+        }
+    }
+
+    // 通过函数指针表调用选中的版本
+    uint32_t a[3] = {12, 35, 0}, b[3] = {18, 49, 5}, g[3];
+    kernels.gcd_batch(a, b, g, 3);
+    uint64_t x[2] = {~0ULL, 1}, y[2] = {1, 0}, s[2];
+    uint64_t carry = kernels.bn_add(s, x, y, 2);
+    struct divider_u32 ten = divider_gen_u32(10);
+    uint32_t n[3] = {9, 10, 12345}, q[3];
+    kernels.div_u32_batch(&ten, n, q, 3);
+    if (g[0] != 6 || g[1] != 7 || g[2] != 5 || s[0] != 0 || s[1] != 2 ||
+        carry != 0 || q[0] != 0 || q[1] != 1 || q[2] != 1234) {
+        printf("kernels table: wrong result\n");
+        ++failures;
+    }
+
+    if (failures > 0) {
+        printf("\n%d mismatches\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("\nall variants agree with the reference\n");
+    return EXIT_SUCCESS;
+}
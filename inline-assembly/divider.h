@@ -0,0 +1,425 @@
+/**
+ * @brief 除数在运行时才确定、但之后保持不变的整数除法：预先算好乘数和移位
+ * @details
+ * ./first.c 的例 4 和 gcd() 用 idivl 求商和余数，一条 idivl / idivq 要 20 到 90 个周期，
+ * 而且不能向量化。除数固定时，n / d 可以换成一次乘法取高半部分再移位：
+ *      q = mulhi(n, magic) >> shift
+ * magic 约等于 2^(W + shift) / d（W 为位数），由 divider_gen_* 对每个除数算一次。
+ * 这和编译器对常量除数做的优化相同，只是挪到了运行时（与 libdivide 的做法相同）。
+ *
+ * 无符号（u32 / u64）
+ *      magic == 0          d 是 2 的幂（包括 1），q = n >> shift
+ *      没有 DIV_ADD_MARKER magic 为 W 位，q = mulhi(n, magic) >> shift
+ *      有 DIV_ADD_MARKER   准确的乘数需要 W + 1 位，magic 只保存低 W 位，
+ *                          t = mulhi(n, magic)，q = (((n - t) >> 1) + t) >> shift
+ * 有符号（s32 / s64）按 |d| 计算，结果向 0 取整，和 C 的 / 以及 idivl 一致
+ *      magic == 0          |d| 是 2 的幂：负数先加上 |d| - 1 再算术右移
+ *      否则                q = mulhi(n, magic)（有 DIV_ADD_MARKER 时再加上 ±n），
+ *                          算术右移后，负数的商加 1（从向下取整改为向 0 取整）
+ *      d < 0 时设置 DIV_NEGATIVE，结果取负。
+ * 余数 r = n - q * d。
+ *
+ * 每种类型提供：
+ *      divider_gen_T(d)                    d 不能为 0
+ *      div_T / mod_T(n, &dv)               单个数
+ *      div_T_batch / mod_T_batch / divmod_T_batch
+ *                                          数组，_scalar 逐个计算，_avx2 一次 8 个（32 位）
+ *                                          或 4 个（64 位），不带后缀的按 CPU 支持情况选择
+ * AVX2 没有 64 位乘法取高半部分的指令，u64 / s64 用 4 次 32 x 32 位乘法拼出来。
+ * 和 C 的 / 一样，s32 的 INT32_MIN / -1（s64 同理）溢出，这里得到 INT32_MIN，
+ * idivl 则会触发 SIGFPE。
+ *
+ * @details
+ * https://libdivide.com/
+ * https://gmplib.org/~tege/divcnst-pldi94.pdf
+ * https://www.felixcloutier.com/x86/idiv
+ */
+#pragma once
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DIV_SHIFT_MASK 0x3f
+#define DIV_ADD_MARKER 0x40
+#define DIV_NEGATIVE 0x80
+
+struct divider_u32 {
+    uint32_t magic;
+    uint8_t more; /* 低 6 位为 shift，再加上 DIV_ADD_MARKER / DIV_NEGATIVE */
+    uint32_t d;
+};
+
+struct divider_s32 {
+    int32_t magic;
+    uint8_t more;
+    int32_t d;
+};
+
+struct divider_u64 {
+    uint64_t magic;
+    uint8_t more;
+    uint64_t d;
+};
+
+struct divider_s64 {
+    int64_t magic;
+    uint8_t more;
+    int64_t d;
+};
+
+static inline void divider_check(int nonzero) {
+    if (!nonzero) {
+        fprintf(stderr, "divider: division by zero\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* ---- 生成 magic ---- */
+
+static inline struct divider_u32 divider_gen_u32(uint32_t d) {
+    divider_check(d != 0);
+    struct divider_u32 dv = {0, 0, d};
+    uint32_t l = 31 - __builtin_clz(d); /* 2^l <= d < 2^(l + 1) */
+    if ((d & (d - 1)) == 0) {
+        dv.more = (uint8_t)l;
+        return dv;
+    }
+    uint64_t num = (uint64_t)1 << (32 + l);
+    uint32_t m = (uint32_t)(num / d); /* d > 2^l，所以商小于 2^32 */
+    uint32_t rem = (uint32_t)(num % d);
+    if (d - rem < (1u << l)) {
+        dv.more = (uint8_t)l;
+    } else {
+        // 需要 33 位的乘数：再多算一位，最高位由 DIV_ADD_MARKER 代表
+        uint32_t twice = rem + rem;
+        m += m;
+        if (twice >= d || twice < rem)
+            m += 1;
+        dv.more = (uint8_t)(l | DIV_ADD_MARKER);
+    }
+    dv.magic = m + 1;
+    return dv;
+}
+
+static inline struct divider_u64 divider_gen_u64(uint64_t d) {
+    divider_check(d != 0);
+    struct divider_u64 dv = {0, 0, d};
+    uint32_t l = 63 - __builtin_clzll(d);
+    if ((d & (d - 1)) == 0) {
+        dv.more = (uint8_t)l;
+        return dv;
+    }
+    unsigned __int128 num = (unsigned __int128)1 << (64 + l);
+    uint64_t m = (uint64_t)(num / d);
+    uint64_t rem = (uint64_t)(num % d);
+    if (d - rem < (1ULL << l)) {
+        dv.more = (uint8_t)l;
+    } else {
+        uint64_t twice = rem + rem;
+        m += m;
+        if (twice >= d || twice < rem)
+            m += 1;
+        dv.more = (uint8_t)(l | DIV_ADD_MARKER);
+    }
+    dv.magic = m + 1;
+    return dv;
+}
+
+static inline struct divider_s32 divider_gen_s32(int32_t d) {
+    divider_check(d != 0);
+    struct divider_s32 dv = {0, 0, d};
+    uint32_t abs_d = d < 0 ? -(uint32_t)d : (uint32_t)d;
+    uint32_t l = 31 - __builtin_clz(abs_d);
+    uint8_t negative = d < 0 ? DIV_NEGATIVE : 0;
+    if ((abs_d & (abs_d - 1)) == 0) {
+        dv.more = (uint8_t)(l | negative);
+        return dv;
+    }
+    // |d| >= 3，l >= 1；乘数约为 2^(31 + l) / |d|
+    uint64_t num = (uint64_t)1 << (31 + l);
+    uint32_t m = (uint32_t)(num / abs_d);
+    uint32_t rem = (uint32_t)(num % abs_d);
+    if (abs_d - rem < (1u << l)) {
+        dv.more = (uint8_t)(l - 1);
+    } else {
+        uint32_t twice = rem + rem;
+        m += m;
+        if (twice >= abs_d || twice < rem)
+            m += 1;
+        dv.more = (uint8_t)(l | DIV_ADD_MARKER);
+    }
+    m += 1;
+    dv.magic = (int32_t)(negative ? -m : m);
+    dv.more |= negative;
+    return dv;
+}
+
+static inline struct divider_s64 divider_gen_s64(int64_t d) {
+    divider_check(d != 0);
+    struct divider_s64 dv = {0, 0, d};
+    uint64_t abs_d = d < 0 ? -(uint64_t)d : (uint64_t)d;
+    uint32_t l = 63 - __builtin_clzll(abs_d);
+    uint8_t negative = d < 0 ? DIV_NEGATIVE : 0;
+    if ((abs_d & (abs_d - 1)) == 0) {
+        dv.more = (uint8_t)(l | negative);
+        return dv;
+    }
+    unsigned __int128 num = (unsigned __int128)1 << (63 + l);
+    uint64_t m = (uint64_t)(num / abs_d);
+    uint64_t rem = (uint64_t)(num % abs_d);
+    if (abs_d - rem < (1ULL << l)) {
+        dv.more = (uint8_t)(l - 1);
+    } else {
+        uint64_t twice = rem + rem;
+        m += m;
+        if (twice >= abs_d || twice < rem)
+            m += 1;
+        dv.more = (uint8_t)(l | DIV_ADD_MARKER);
+    }
+    m += 1;
+    dv.magic = (int64_t)(negative ? -m : m);
+    dv.more |= negative;
+    return dv;
+}
+
+/* ---- 单个数 ---- */
+
+static inline uint32_t div_u32(uint32_t n, const struct divider_u32* dv) {
+    uint32_t shift = dv->more & DIV_SHIFT_MASK;
+    if (dv->magic == 0)
+        return n >> shift;
+    uint32_t t = (uint32_t)(((uint64_t)n * dv->magic) >> 32);
+    if (dv->more & DIV_ADD_MARKER)
+        return (((n - t) >> 1) + t) >> shift;
+    return t >> shift;
+}
+
+static inline uint64_t div_u64(uint64_t n, const struct divider_u64* dv) {
+    uint32_t shift = dv->more & DIV_SHIFT_MASK;
+    if (dv->magic == 0)
+        return n >> shift;
+    uint64_t t = (uint64_t)(((unsigned __int128)n * dv->magic) >> 64);
+    if (dv->more & DIV_ADD_MARKER)
+        return (((n - t) >> 1) + t) >> shift;
+    return t >> shift;
+}
+
+static inline int32_t div_s32(int32_t n, const struct divider_s32* dv) {
+    uint32_t shift = dv->more & DIV_SHIFT_MASK;
+    int32_t sign = (int8_t)dv->more >> 7; /* d < 0 时为 -1 */
+    if (dv->magic == 0) {
+        uint32_t mask = (1u << shift) - 1;
+        int32_t q = (int32_t)((uint32_t)n + ((uint32_t)(n >> 31) & mask));
+        q >>= shift;
+        return (int32_t)(((uint32_t)q ^ sign) - sign);
+    }
+    uint32_t uq = (uint32_t)(((int64_t)n * dv->magic) >> 32);
+    if (dv->more & DIV_ADD_MARKER)
+        uq += ((uint32_t)n ^ sign) - sign; /* d > 0 时加 n，d < 0 时减 n */
+    int32_t q = (int32_t)uq >> shift;
+    return q + (int32_t)((uint32_t)q >> 31);
+}
+
+static inline int64_t div_s64(int64_t n, const struct divider_s64* dv) {
+    uint32_t shift = dv->more & DIV_SHIFT_MASK;
+    int64_t sign = (int8_t)dv->more >> 7;
+    if (dv->magic == 0) {
+        uint64_t mask = (1ULL << shift) - 1;
+        int64_t q = (int64_t)((uint64_t)n + ((uint64_t)(n >> 63) & mask));
+        q >>= shift;
+        return (int64_t)(((uint64_t)q ^ sign) - sign);
+    }
+    uint64_t uq = (uint64_t)(((__int128)n * dv->magic) >> 64);
+    if (dv->more & DIV_ADD_MARKER)
+        uq += ((uint64_t)n ^ sign) - sign;
+    int64_t q = (int64_t)uq >> shift;
+    return q + (int64_t)((uint64_t)q >> 63);
+}
+
+static inline uint32_t mod_u32(uint32_t n, const struct divider_u32* dv) {
+    return n - div_u32(n, dv) * dv->d;
+}
+
+static inline uint64_t mod_u64(uint64_t n, const struct divider_u64* dv) {
+    return n - div_u64(n, dv) * dv->d;
+}
+
+static inline int32_t mod_s32(int32_t n, const struct divider_s32* dv) {
+    return (int32_t)((uint32_t)n - (uint32_t)div_s32(n, dv) * (uint32_t)dv->d);
+}
+
+static inline int64_t mod_s64(int64_t n, const struct divider_s64* dv) {
+    return (int64_t)((uint64_t)n - (uint64_t)div_s64(n, dv) * (uint64_t)dv->d);
+}
+
+/* ---- AVX2 ---- */
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// 每个 32 位通道 a * b 的高 32 位；mul_epu32 只乘偶数通道，奇数通道先右移
+static inline __m256i mulhi_epu32(__m256i a, __m256i b) {
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32),
+                                   _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+static inline __m256i mulhi_epi32(__m256i a, __m256i b) {
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), 32);
+    __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+                                   _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(even, odd, 0xaa);
+}
+
+// 每个 64 位通道 a * b 的高 64 位：拆成 32 位的四个部分积
+static inline __m256i mulhi_epu64(__m256i a, __m256i b) {
+    const __m256i low = _mm256_set1_epi64x(0xffffffff);
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i b_hi = _mm256_srli_epi64(b, 32);
+    __m256i ll = _mm256_mul_epu32(a, b);
+    __m256i lh = _mm256_mul_epu32(a, b_hi);
+    __m256i hl = _mm256_mul_epu32(a_hi, b);
+    __m256i hh = _mm256_mul_epu32(a_hi, b_hi);
+    __m256i mid = _mm256_add_epi64(lh, _mm256_srli_epi64(ll, 32));
+    __m256i mid2 = _mm256_add_epi64(hl, _mm256_and_si256(mid, low));
+    return _mm256_add_epi64(
+        hh, _mm256_add_epi64(_mm256_srli_epi64(mid, 32),
+                             _mm256_srli_epi64(mid2, 32)));
+}
+
+// 有符号的高 64 位 = 无符号的高 64 位 - (a < 0 ? b : 0) - (b < 0 ? a : 0)
+static inline __m256i mulhi_epi64(__m256i a, __m256i b) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i hi = mulhi_epu64(a, b);
+    hi = _mm256_sub_epi64(hi, _mm256_and_si256(_mm256_cmpgt_epi64(zero, a), b));
+    return _mm256_sub_epi64(hi,
+                            _mm256_and_si256(_mm256_cmpgt_epi64(zero, b), a));
+}
+
+// 每个 64 位通道 a * b 的低 64 位（AVX2 没有 vpmullq）
+static inline __m256i mullo_epi64(__m256i a, __m256i b) {
+    __m256i cross = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+        _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b),
+                            _mm256_slli_epi64(cross, 32));
+}
+
+// 64 位算术右移（AVX2 没有 vpsraq）：负数先取反，逻辑右移后再取反
+static inline __m256i sra_epi64(__m256i x, __m128i count) {
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+    return _mm256_xor_si256(_mm256_srl_epi64(_mm256_xor_si256(x, sign), count),
+                            sign);
+}
+
+static inline __m256i div_u32_avx2_8(__m256i n, const struct divider_u32* dv) {
+    __m128i shift = _mm_cvtsi32_si128(dv->more & DIV_SHIFT_MASK);
+    if (dv->magic == 0)
+        return _mm256_srl_epi32(n, shift);
+    __m256i t = mulhi_epu32(n, _mm256_set1_epi32((int32_t)dv->magic));
+    if (dv->more & DIV_ADD_MARKER) {
+        __m256i half = _mm256_srli_epi32(_mm256_sub_epi32(n, t), 1);
+        return _mm256_srl_epi32(_mm256_add_epi32(half, t), shift);
+    }
+    return _mm256_srl_epi32(t, shift);
+}
+
+static inline __m256i div_u64_avx2_4(__m256i n, const struct divider_u64* dv) {
+    __m128i shift = _mm_cvtsi32_si128(dv->more & DIV_SHIFT_MASK);
+    if (dv->magic == 0)
+        return _mm256_srl_epi64(n, shift);
+    __m256i t = mulhi_epu64(n, _mm256_set1_epi64x((int64_t)dv->magic));
+    if (dv->more & DIV_ADD_MARKER) {
+        __m256i half = _mm256_srli_epi64(_mm256_sub_epi64(n, t), 1);
+        return _mm256_srl_epi64(_mm256_add_epi64(half, t), shift);
+    }
+    return _mm256_srl_epi64(t, shift);
+}
+
+static inline __m256i div_s32_avx2_8(__m256i n, const struct divider_s32* dv) {
+    uint32_t s = dv->more & DIV_SHIFT_MASK;
+    __m128i shift = _mm_cvtsi32_si128(s);
+    __m256i sign = _mm256_set1_epi32((int8_t)dv->more >> 7);
+    __m256i q;
+    if (dv->magic == 0) {
+        __m256i mask = _mm256_set1_epi32((int32_t)((1u << s) - 1));
+        q = _mm256_add_epi32(n, _mm256_and_si256(_mm256_srai_epi32(n, 31),
+                                                 mask));
+        q = _mm256_sra_epi32(q, shift);
+        return _mm256_sub_epi32(_mm256_xor_si256(q, sign), sign);
+    }
+    q = mulhi_epi32(n, _mm256_set1_epi32(dv->magic));
+    if (dv->more & DIV_ADD_MARKER)
+        q = _mm256_add_epi32(q,
+                             _mm256_sub_epi32(_mm256_xor_si256(n, sign), sign));
+    q = _mm256_sra_epi32(q, shift);
+    return _mm256_add_epi32(q, _mm256_srli_epi32(q, 31));
+}
+
+static inline __m256i div_s64_avx2_4(__m256i n, const struct divider_s64* dv) {
+    uint32_t s = dv->more & DIV_SHIFT_MASK;
+    __m128i shift = _mm_cvtsi32_si128(s);
+    __m256i sign = _mm256_set1_epi64x((int8_t)dv->more >> 7);
+    __m256i q;
+    if (dv->magic == 0) {
+        __m256i mask = _mm256_set1_epi64x((int64_t)((1ULL << s) - 1));
+        __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), n);
+        q = _mm256_add_epi64(n, _mm256_and_si256(negative, mask));
+        q = sra_epi64(q, shift);
+        return _mm256_sub_epi64(_mm256_xor_si256(q, sign), sign);
+    }
+    q = mulhi_epi64(n, _mm256_set1_epi64x(dv->magic));
+    if (dv->more & DIV_ADD_MARKER)
+        q = _mm256_add_epi64(q,
+                             _mm256_sub_epi64(_mm256_xor_si256(n, sign), sign));
+    q = sra_epi64(q, shift);
+    return _mm256_add_epi64(q, _mm256_srli_epi64(q, 63));
+}
+
+#pragma GCC pop_options
+
+/* ---- 数组 ---- */
+
+#define DV_TYPE u32
+#define DV_T uint32_t
+#define DV_UT uint32_t
+#define DV_LANES 8
+#define DV_VEC_DIV div_u32_avx2_8
+#define DV_VEC_MULLO _mm256_mullo_epi32
+#define DV_VEC_SUB _mm256_sub_epi32
+#define DV_VEC_SET1(x) _mm256_set1_epi32((int32_t)(x))
+#include "divider_impl.h"
+
+#define DV_TYPE s32
+#define DV_T int32_t
+#define DV_UT uint32_t
+#define DV_LANES 8
+#define DV_VEC_DIV div_s32_avx2_8
+#define DV_VEC_MULLO _mm256_mullo_epi32
+#define DV_VEC_SUB _mm256_sub_epi32
+#define DV_VEC_SET1(x) _mm256_set1_epi32(x)
+#include "divider_impl.h"
+
+#define DV_TYPE u64
+#define DV_T uint64_t
+#define DV_UT uint64_t
+#define DV_LANES 4
+#define DV_VEC_DIV div_u64_avx2_4
+#define DV_VEC_MULLO mullo_epi64
+#define DV_VEC_SUB _mm256_sub_epi64
+#define DV_VEC_SET1(x) _mm256_set1_epi64x((int64_t)(x))
+#include "divider_impl.h"
+
+#define DV_TYPE s64
+#define DV_T int64_t
+#define DV_UT uint64_t
+#define DV_LANES 4
+#define DV_VEC_DIV div_s64_avx2_4
+#define DV_VEC_MULLO mullo_epi64
+#define DV_VEC_SUB _mm256_sub_epi64
+#define DV_VEC_SET1(x) _mm256_set1_epi64x(x)
+#include "divider_impl.h"
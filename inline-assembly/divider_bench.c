@@ -0,0 +1,344 @@
+/**
+ * @brief ./divider.h 与 div / idiv 指令的对比：正确性与吞吐量
+ * @details
+ * 正确性：参考结果直接用内联汇编的 divl / idivl / divq / idivq 计算。
+ * 除数取 ±1 到 ±1000、2 的幂和它们 ±1、类型的最大 / 最小值以及随机数；
+ * 被除数取 0、±1、最大 / 最小值、除数的倍数和它们 ±1，以及随机数。
+ * 对每个除数检查 div_T / mod_T 和 _scalar、_avx2 的 div / mod / divmod 数组版本
+ * （个数不是 8 的倍数，覆盖尾部）。有符号类型跳过 MIN / -1（idiv 会触发 SIGFPE）。
+ * 另外对 u32 的几个除数穷举全部 2^32 个被除数（参数 exhaustive）。
+ *
+ * 吞吐量：用 ../benchmark/bench.h 对 4096 个随机数测量每个元素的 TSC 周期数，
+ * 除数随机且运行时才知道：
+ *      idiv      C 的 / 与 %，编译器生成 div / idiv 指令
+ *      scalar    div_T_batch_scalar / divmod_T_batch_scalar
+ *      avx2      div_T_batch_avx2 / divmod_T_batch_avx2
+ *
+ * @note
+ * gcc inline-assembly/divider_bench.c -o out/a.out -O2 -lm && out/a.out [tests=20000] [exhaustive]
+ */
+
+#include "../benchmark/bench.h"
+#include "divider.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUMERATORS 300 /* 每个除数的被除数个数，不是 8 的倍数 */
+#define BENCH_COUNT 4096
+
+/* ---- 参考：div / idiv 指令 ---- */
+
+static void ref_u32(uint32_t n, uint32_t d, uint32_t* q, uint32_t* r) {
+    __asm__("xorl %%edx, %%edx;"
+            "divl %[d];"
+            : "=a"(*q), "=&d"(*r)
+            : "a"(n), [d] "r"(d)
+            : "cc");
+}
+
+static void ref_s32(int32_t n, int32_t d, int32_t* q, int32_t* r) {
+    __asm__("cltd;"
+            "idivl %[d];"
+            : "=a"(*q), "=&d"(*r)
+            : "a"(n), [d] "r"(d)
+            : "cc");
+}
+
+static void ref_u64(uint64_t n, uint64_t d, uint64_t* q, uint64_t* r) {
+    __asm__("xorl %%edx, %%edx;"
+            "divq %[d];"
+            : "=a"(*q), "=&d"(*r)
+            : "a"(n), [d] "r"(d)
+            : "cc");
+}
+
+static void ref_s64(int64_t n, int64_t d, int64_t* q, int64_t* r) {
+    __asm__("cqto;"
+            "idivq %[d];"
+            : "=a"(*q), "=&d"(*r)
+            : "a"(n), [d] "r"(d)
+            : "cc");
+}
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t random64(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// 随机数，位数也随机，使小数和大数都经常出现
+static uint64_t random_bits(void) {
+    return random64() >> (random64() % 64);
+}
+
+static void fail(const char* what, long long n, long long d,
+                 unsigned long long got, unsigned long long expect) {
+    fprintf(stderr, "%s: n = %lld, d = %lld: got %llu, expected %llu\n", what,
+            n, d, got, expect);
+    exit(EXIT_FAILURE);
+}
+
+/* ---- 正确性 ---- */
+
+/**
+ * 为每种类型生成一个检查函数：
+ * 对除数 d 准备 NUMERATORS 个被除数，与参考结果逐个比较。
+ * OVERFLOW(n, d) 为真的组合（有符号的 MIN / -1）idiv 会触发 SIGFPE，
+ * 按 ./divider.h 的约定期望商为 MIN、余数为 0。
+ */
+#define DEFINE_CHECK(TYPE, T, MIN, MAX, OVERFLOW)                                \
+    static void check_##TYPE(T d) {                                            \
+        struct divider_##TYPE dv = divider_gen_##TYPE(d);                      \
+        T n[NUMERATORS], q[NUMERATORS], r[NUMERATORS];                         \
+        T q2[NUMERATORS], r2[NUMERATORS];                                      \
+        T expect_q[NUMERATORS], expect_r[NUMERATORS];                          \
+        const T edges[] = {0, 1, (T)-1, MIN, MAX, (T)(MIN + 1), (T)(MAX - 1),  \
+                           d, (T)((uint64_t)d - 1), (T)((uint64_t)d + 1),      \
+                           (T)(MAX / d * d)};                                  \
+        size_t nedges = sizeof(edges) / sizeof(edges[0]);                      \
+        uint64_t abs_d = d > 0 ? (uint64_t)d : -(uint64_t)(int64_t)d;          \
+        for (size_t i = 0; i < NUMERATORS; ++i) {                              \
+            if (i < nedges) {                                                  \
+                n[i] = edges[i];                                               \
+            } else if (i % 3 == 0) {                                           \
+                /* k * d 以及它 ±1 */                                          \
+                uint64_t kmax = (uint64_t)MAX / abs_d;                         \
+                uint64_t k = kmax ? random_bits() % kmax : 0;                  \
+                uint64_t delta = i % 5 == 0 ? 1 : i % 5 == 1 ? -1ULL : 0;      \
+                n[i] = (T)(k * (uint64_t)(int64_t)d + delta);                  \
+            } else {                                                           \
+                n[i] = (T)random_bits();                                       \
+                if (i % 2)                                                     \
+                    n[i] = (T)(0 - (uint64_t)n[i]);                            \
+            }                                                                  \
+            if (OVERFLOW(n[i], d)) {                                           \
+                expect_q[i] = MIN;                                             \
+                expect_r[i] = 0;                                               \
+            } else {                                                           \
+                ref_##TYPE(n[i], d, &expect_q[i], &expect_r[i]);               \
+            }                                                                  \
+            T got = div_##TYPE(n[i], &dv);                                     \
+            if (got != expect_q[i])                                            \
+                fail("div_" #TYPE, (long long)n[i], (long long)d,              \
+                     (unsigned long long)got,                                  \
+                     (unsigned long long)expect_q[i]);                         \
+            got = mod_##TYPE(n[i], &dv);                                       \
+            if (got != expect_r[i])                                            \
+                fail("mod_" #TYPE, (long long)n[i], (long long)d,              \
+                     (unsigned long long)got,                                  \
+                     (unsigned long long)expect_r[i]);                         \
+        }                                                                      \
+        for (int avx2 = 0; avx2 <= !!__builtin_cpu_supports("avx2"); ++avx2) { \
+            if (avx2) {                                                        \
+                div_##TYPE##_batch_avx2(&dv, n, q, NUMERATORS);                \
+                mod_##TYPE##_batch_avx2(&dv, n, r, NUMERATORS);                \
+                divmod_##TYPE##_batch_avx2(&dv, n, q2, r2, NUMERATORS);        \
+            } else {                                                           \
+                div_##TYPE##_batch_scalar(&dv, n, q, NUMERATORS);              \
+                mod_##TYPE##_batch_scalar(&dv, n, r, NUMERATORS);              \
+                divmod_##TYPE##_batch_scalar(&dv, n, q2, r2, NUMERATORS);      \
+            }                                                                  \
+            for (size_t i = 0; i < NUMERATORS; ++i) {                          \
+                const char* batch = avx2 ? "batch_avx2" : "batch_scalar";     \
+                if (q[i] != expect_q[i] || q2[i] != expect_q[i])               \
+                    fail(batch, (long long)n[i], (long long)d,                 \
+                         (unsigned long long)(q[i] != expect_q[i] ? q[i]       \
+                                                                  : q2[i]),    \
+                         (unsigned long long)expect_q[i]);                     \
+                if (r[i] != expect_r[i] || r2[i] != expect_r[i])               \
+                    fail(batch, (long long)n[i], (long long)d,                 \
+                         (unsigned long long)(r[i] != expect_r[i] ? r[i]       \
+                                                                  : r2[i]),    \
+                         (unsigned long long)expect_r[i]);                     \
+            }                                                                  \
+        }                                                                      \
+    }
+
+#define NO_OVERFLOW(n, d) 0
+#define OVERFLOW_S32(n, d) ((n) == INT32_MIN && (d) == -1)
+#define OVERFLOW_S64(n, d) ((n) == INT64_MIN && (d) == -1)
+
+DEFINE_CHECK(u32, uint32_t, 0, UINT32_MAX, NO_OVERFLOW)
+DEFINE_CHECK(s32, int32_t, INT32_MIN, INT32_MAX, OVERFLOW_S32)
+DEFINE_CHECK(u64, uint64_t, 0, UINT64_MAX, NO_OVERFLOW)
+DEFINE_CHECK(s64, int64_t, INT64_MIN, INT64_MAX, OVERFLOW_S64)
+
+static void check_divisor(int64_t d) {
+    if ((uint32_t)d != 0) {
+        check_u32((uint32_t)d);
+        check_s32((int32_t)d);
+    }
+    if (d != 0) {
+        check_u64((uint64_t)d);
+        check_s64(d);
+    }
+}
+
+static void test_all(int tests) {
+    for (int64_t d = 1; d <= 1000; ++d) {
+        check_divisor(d);
+        check_divisor(-d);
+    }
+    for (int k = 1; k < 64; ++k) {
+        for (int64_t delta = -1; delta <= 1; ++delta) {
+            int64_t p = (int64_t)((1ULL << k) + (uint64_t)delta);
+            check_divisor(p);
+            check_divisor((int64_t)(0 - (uint64_t)p));
+        }
+    }
+    const int64_t extremes[] = {INT32_MAX, INT32_MIN, UINT32_MAX,
+                                INT64_MAX, INT64_MIN, -INT64_MAX};
+    for (size_t i = 0; i < sizeof(extremes) / sizeof(extremes[0]); ++i)
+        check_divisor(extremes[i]);
+    for (int t = 0; t < tests; ++t)
+        check_divisor((int64_t)random_bits() * (t % 2 ? 1 : -1));
+}
+
+// u32：对每个除数，所有 2^32 个被除数都和 divl 比较（AVX2 数组版本）
+static void test_exhaustive(void) {
+    const uint32_t divisors[] = {3, 7, 10, 641, 0x7fffffff, 0xfffffffb};
+    static uint32_t n[1 << 16], q[1 << 16];
+    for (size_t k = 0; k < sizeof(divisors) / sizeof(divisors[0]); ++k) {
+        struct divider_u32 dv = divider_gen_u32(divisors[k]);
+        for (uint64_t base = 0; base < (1ULL << 32); base += 1 << 16) {
+            for (uint32_t i = 0; i < 1 << 16; ++i)
+                n[i] = (uint32_t)base + i;
+            div_u32_batch(&dv, n, q, 1 << 16);
+            for (uint32_t i = 0; i < 1 << 16; ++i) {
+                if (q[i] != n[i] / divisors[k])
+                    fail("div_u32_batch", n[i], divisors[k], q[i],
+                         n[i] / divisors[k]);
+            }
+        }
+        printf("u32 / %u: all 2^32 numerators ok\n", divisors[k]);
+    }
+}
+
+/* ---- 吞吐量 ---- */
+
+enum kind { KIND_IDIV, KIND_SCALAR, KIND_AVX2, NKINDS };
+static const char* kind_names[NKINDS] = {"idiv", "scalar", "avx2"};
+
+struct job {
+    enum kind kind;
+    int divmod;
+    const void* dv;
+    const void* n;
+    void* q;
+    void* r;
+};
+
+/**
+ * 每种类型一个运行函数。idiv 版本的除数经过一个空的 asm，
+ * 编译器不知道它的值，只能生成除法指令。
+ */
+#define DEFINE_RUN(TYPE, T)                                                    \
+    static void run_##TYPE(void* arg) {                                        \
+        struct job* j = arg;                                                   \
+        const struct divider_##TYPE* dv = j->dv;                               \
+        const T* n = j->n;                                                     \
+        T* q = j->q;                                                           \
+        T* r = j->r;                                                           \
+        switch (j->kind) {                                                     \
+        case KIND_IDIV: {                                                      \
+            T d = dv->d;                                                       \
+            __asm__("" : "+r"(d));                                             \
+            for (size_t i = 0; i < BENCH_COUNT; ++i) {                         \
+                q[i] = n[i] / d;                                               \
+                if (j->divmod)                                                 \
+                    r[i] = n[i] % d;                                           \
+            }                                                                  \
+            break;                                                             \
+        }                                                                      \
+        case KIND_SCALAR:                                                      \
+            if (j->divmod)                                                     \
+                divmod_##TYPE##_batch_scalar(dv, n, q, r, BENCH_COUNT);        \
+            else                                                               \
+                div_##TYPE##_batch_scalar(dv, n, q, BENCH_COUNT);              \
+            break;                                                             \
+        default:                                                               \
+            if (j->divmod)                                                     \
+                divmod_##TYPE##_batch_avx2(dv, n, q, r, BENCH_COUNT);          \
+            else                                                               \
+                div_##TYPE##_batch_avx2(dv, n, q, BENCH_COUNT);                \
+        }                                                                      \
+        __asm__ __volatile__("" : : "r"(q), "r"(r) : "memory");                \
+    }
+
+DEFINE_RUN(u32, uint32_t)
+DEFINE_RUN(s32, int32_t)
+DEFINE_RUN(u64, uint64_t)
+DEFINE_RUN(s64, int64_t)
+
+int main(int argc, char* argv[]) {
+    int tests = argc > 1 ? atoi(argv[1]) : 20000;
+    int exhaustive = argc > 2 && strcmp(argv[2], "exhaustive") == 0;
+
+    test_all(tests);
+    printf("differential tests against div / idiv passed (%d random divisors)"
+           "%s\n",
+           tests, __builtin_cpu_supports("avx2") ? "" : ", avx2 not supported");
+    if (exhaustive)
+        test_exhaustive();
+    printf("\n");
+
+    bench_init(NULL);
+    static uint64_t n[BENCH_COUNT], q[BENCH_COUNT], r[BENCH_COUNT];
+    for (size_t i = 0; i < BENCH_COUNT; ++i)
+        n[i] = random64();
+    // 32 位类型使用数组的前一半（按 uint32_t 解释）
+    struct divider_u32 du32 = divider_gen_u32((uint32_t)random64() >> 8 | 1);
+    struct divider_s32 ds32 = divider_gen_s32(-(int32_t)(random64() >> 40) - 3);
+    struct divider_u64 du64 = divider_gen_u64(random64() >> 16 | 1);
+    struct divider_s64 ds64 = divider_gen_s64(-(int64_t)(random64() >> 32) - 3);
+    struct {
+        const char* name;
+        void (*run)(void*);
+        const void* dv;
+    } types[] = {
+        {"u32", run_u32, &du32},
+        {"s32", run_s32, &ds32},
+        {"u64", run_u64, &du64},
+        {"s64", run_s64, &ds64},
+    };
+    const int ntypes = sizeof(types) / sizeof(types[0]);
+    int avx2 = __builtin_cpu_supports("avx2");
+
+    if (bench_cfg.format == BENCH_TEXT) {
+        printf("%-6s", "cyc/n");
+        for (int divmod = 0; divmod <= 1; ++divmod)
+            for (int k = 0; k < NKINDS; ++k)
+                printf(" %7s_%s", divmod ? "dm" : "div", kind_names[k]);
+        printf("\n");
+    }
+    for (int t = 0; t < ntypes; ++t) {
+        char row[256];
+        int len = snprintf(row, sizeof(row), "%-6s", types[t].name);
+        for (int divmod = 0; divmod <= 1; ++divmod) {
+            for (int k = 0; k < NKINDS; ++k) {
+                if (k == KIND_AVX2 && !avx2) {
+                    len += snprintf(row + len, sizeof(row) - len, " %14s",
+                                    "-");
+                    continue;
+                }
+                struct job job = {(enum kind)k, divmod, types[t].dv, n, q, r};
+                char name[64];
+                snprintf(name, sizeof(name), "%s_%s_%s", types[t].name,
+                         divmod ? "divmod" : "div", kind_names[k]);
+                struct bench_result res = bench_run(name, types[t].run, &job,
+                                                    BENCH_COUNT);
+                if (bench_cfg.format != BENCH_TEXT)
+                    bench_report(&res);
+                len += snprintf(row + len, sizeof(row) - len, " %14.2f",
+                                res.tsc_cycles);
+            }
+        }
+        if (bench_cfg.format == BENCH_TEXT)
+            printf("%s\n", row);
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @brief ./divider.h 的数组版本 div / mod / divmod，不要直接包含
+ * @details
+ * 由 ./divider.h 对每种类型包含一次，每次定义：
+ * DV_TYPE        类型名后缀（u32 / s32 / u64 / s64）
+ * DV_T           元素类型
+ * DV_UT          同样宽度的无符号类型，余数用它计算，MIN / -1 时不会有符号溢出
+ * DV_LANES       一个 __m256i 中的元素个数
+ * DV_VEC_DIV     AVX2 的向量除法（div_u32_avx2_8 等）
+ * DV_VEC_MULLO / DV_VEC_SUB / DV_VEC_SET1
+ *                对应元素宽度的乘法低半部分、减法和广播
+ * 生成 div_T_batch_scalar / _avx2、mod_T_batch_*、divmod_T_batch_* 以及按 CPU 选择的版本，
+ * 末尾 #undef 上面这些宏。
+ */
+
+#define DV_CAT3(a, b, c) a##_##b##_##c
+#define DV_CAT(a, b, c) DV_CAT3(a, b, c)
+#define DV(op, suffix) DV_CAT(op, DV_TYPE, suffix)
+#define DV_CAT2(a, b) a##_##b
+#define DV_NAME(a, b) DV_CAT2(a, b)
+#define DV_DIVIDER struct DV_NAME(divider, DV_TYPE)
+
+// q[i] = n[i] / d，q 可以与 n 相同
+static inline void DV(div, batch_scalar)(const DV_DIVIDER* dv, const DV_T* n,
+                                         DV_T* q, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        q[i] = DV_NAME(div, DV_TYPE)(n[i], dv);
+}
+
+// r[i] = n[i] % d
+static inline void DV(mod, batch_scalar)(const DV_DIVIDER* dv, const DV_T* n,
+                                         DV_T* r, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        r[i] = DV_NAME(mod, DV_TYPE)(n[i], dv);
+}
+
+static inline void DV(divmod, batch_scalar)(const DV_DIVIDER* dv,
+                                            const DV_T* n, DV_T* q, DV_T* r,
+                                            size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        DV_T quot = DV_NAME(div, DV_TYPE)(n[i], dv);
+        r[i] = (DV_T)((DV_UT)n[i] - (DV_UT)quot * (DV_UT)dv->d);
+        q[i] = quot;
+    }
+}
+
+__attribute__((target("avx2"))) static inline void
+DV(div, batch_avx2)(const DV_DIVIDER* dv, const DV_T* n, DV_T* q,
+                    size_t count) {
+    size_t i = 0;
+    for (; i + DV_LANES <= count; i += DV_LANES) {
+        __m256i vn = _mm256_loadu_si256((const __m256i*)(n + i));
+        _mm256_storeu_si256((__m256i*)(q + i), DV_VEC_DIV(vn, dv));
+    }
+    DV(div, batch_scalar)(dv, n + i, q + i, count - i);
+}
+
+__attribute__((target("avx2"))) static inline void
+DV(mod, batch_avx2)(const DV_DIVIDER* dv, const DV_T* n, DV_T* r,
+                    size_t count) {
+    __m256i d = DV_VEC_SET1(dv->d);
+    size_t i = 0;
+    for (; i + DV_LANES <= count; i += DV_LANES) {
+        __m256i vn = _mm256_loadu_si256((const __m256i*)(n + i));
+        __m256i vq = DV_VEC_DIV(vn, dv);
+        _mm256_storeu_si256((__m256i*)(r + i),
+                            DV_VEC_SUB(vn, DV_VEC_MULLO(vq, d)));
+    }
+    DV(mod, batch_scalar)(dv, n + i, r + i, count - i);
+}
+
+__attribute__((target("avx2"))) static inline void
+DV(divmod, batch_avx2)(const DV_DIVIDER* dv, const DV_T* n, DV_T* q, DV_T* r,
+                       size_t count) {
+    __m256i d = DV_VEC_SET1(dv->d);
+    size_t i = 0;
+    for (; i + DV_LANES <= count; i += DV_LANES) {
+        __m256i vn = _mm256_loadu_si256((const __m256i*)(n + i));
+        __m256i vq = DV_VEC_DIV(vn, dv);
+        _mm256_storeu_si256((__m256i*)(q + i), vq);
+        _mm256_storeu_si256((__m256i*)(r + i),
+                            DV_VEC_SUB(vn, DV_VEC_MULLO(vq, d)));
+    }
+    DV(divmod, batch_scalar)(dv, n + i, q + i, r + i, count - i);
+}
+
+static inline void DV_NAME(DV_NAME(div, DV_TYPE), batch)(const DV_DIVIDER* dv,
+                                                         const DV_T* n,
+                                                         DV_T* q,
+                                                         size_t count) {
+    if (__builtin_cpu_supports("avx2"))
+        DV(div, batch_avx2)(dv, n, q, count);
+    else
+        DV(div, batch_scalar)(dv, n, q, count);
+}
+
+static inline void DV_NAME(DV_NAME(mod, DV_TYPE), batch)(const DV_DIVIDER* dv,
+                                                         const DV_T* n,
+                                                         DV_T* r,
+                                                         size_t count) {
+    if (__builtin_cpu_supports("avx2"))
+        DV(mod, batch_avx2)(dv, n, r, count);
+    else
+        DV(mod, batch_scalar)(dv, n, r, count);
+}
+
+static inline void DV_NAME(DV_NAME(divmod, DV_TYPE),
+                           batch)(const DV_DIVIDER* dv, const DV_T* n, DV_T* q,
+                                  DV_T* r, size_t count) {
+    if (__builtin_cpu_supports("avx2"))
+        DV(divmod, batch_avx2)(dv, n, q, r, count);
+    else
+        DV(divmod, batch_scalar)(dv, n, q, r, count);
+}
+
+#undef DV_DIVIDER
+#undef DV_NAME
+#undef DV_CAT2
+#undef DV
+#undef DV_CAT
+#undef DV_CAT3
+#undef DV_TYPE
+#undef DV_T
+#undef DV_UT
+#undef DV_LANES
+#undef DV_VEC_DIV
+#undef DV_VEC_MULLO
+#undef DV_VEC_SUB
+#undef DV_VEC_SET1
@@ -0,0 +1,149 @@
+/**
+ * @brief 批量最大公约数 Stein 二进制算法
+ * @details
+ * ./first.c 中的 gcd() 每次循环执行一条 idivl，这是 x86 上最慢的指令之一。
+ * Stein 算法只用移位、比较和减法：
+ *      gcd(a, b) = 2^k * gcd(a', b')，k 为 a | b 末尾 0 的个数；
+ *      a、b 都变成奇数后，反复令 b = |b - a| 并去掉 b 末尾的 0。
+ *
+ * gcd_batch_scalar   可移植 C 实现，末尾 0 用 __builtin_ctz
+ * gcd_batch_bmi      内联汇编 tzcnt + cmov，没有分支预测失败
+ *                    （不支持 BMI 的 CPU 把 tzcnt 当作 bsf 执行，
+ *                    输入非 0 时结果相同）
+ * gcd_batch_avx2     8 个 32 位通道同时计算，
+ *                    末尾 0 的个数由 x & -x 转成 float 后取指数得到，
+ *                    所有通道都结束才退出循环
+ * gcd_batch          按 CPU 支持情况选择最快的版本
+ *
+ * @details
+ * https://en.wikipedia.org/wiki/Binary_GCD_algorithm
+ * https://www.felixcloutier.com/x86/tzcnt
+ */
+#pragma once
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static inline uint32_t gcd_scalar(uint32_t a, uint32_t b) {
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    int shift = __builtin_ctz(a | b);
+    a >>= __builtin_ctz(a);
+    do {
+        b >>= __builtin_ctz(b);
+        if (a > b) {
+            uint32_t t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    } while (b != 0);
+    return a << shift;
+}
+
+static inline uint32_t tzcnt32(uint32_t x) {
+    uint32_t n;
+    __asm__("tzcntl %1, %0" : "=r"(n) : "rm"(x) : "cc");
+    return n;
+}
+
+static inline uint32_t gcd_bmi(uint32_t a, uint32_t b) {
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    uint32_t shift = tzcnt32(a | b);
+    a >>= tzcnt32(a);
+    do {
+        b >>= tzcnt32(b);
+        /* a, b = min(a, b), max(a, b) - min(a, b) */
+        uint32_t d1, d2;
+        __asm__("movl %1, %2;"
+                "subl %0, %2;"   /* d1 = b - a */
+                "movl %0, %3;"
+                "subl %1, %3;"   /* d2 = a - b */
+                "cmpl %0, %1;"
+                "cmovbl %1, %0;" /* b < a 时 a = b */
+                "cmovbl %3, %2;" /* b < a 时 d1 = a - b */
+                "movl %2, %1;"
+                : "+r"(a), "+r"(b), "=&r"(d1), "=&r"(d2)
+                :
+                : "cc");
+    } while (b != 0);
+    return a << shift;
+}
+
+static inline void gcd_batch_scalar(const uint32_t* a, const uint32_t* b,
+                                    uint32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = gcd_scalar(a[i], b[i]);
+}
+
+static inline void gcd_batch_bmi(const uint32_t* a, const uint32_t* b,
+                                 uint32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = gcd_bmi(a[i], b[i]);
+}
+
+// 每个通道末尾 0 的个数；x 为 0 的通道得到一个大于 31 的数，移位后为 0
+__attribute__((target("avx2"))) static inline __m256i
+tzcnt_epi32(__m256i x) {
+    __m256i neg = _mm256_sub_epi32(_mm256_setzero_si256(), x);
+    __m256i lowest = _mm256_and_si256(x, neg);
+    __m256i bits = _mm256_castps_si256(_mm256_cvtepi32_ps(lowest));
+    __m256i exponent = _mm256_and_si256(_mm256_srli_epi32(bits, 23),
+                                        _mm256_set1_epi32(0xff));
+    return _mm256_sub_epi32(exponent, _mm256_set1_epi32(127));
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+gcd_avx2_8(__m256i a, __m256i b) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i shift = tzcnt_epi32(_mm256_or_si256(a, b));
+    // a 为 0 时结果是 b：把 b 换到 a，再让 b 为 0 结束该通道
+    __m256i a_zero = _mm256_cmpeq_epi32(a, zero);
+    __m256i b_zero = _mm256_cmpeq_epi32(b, zero);
+    a = _mm256_blendv_epi8(a, b, a_zero);
+    b = _mm256_andnot_si256(_mm256_or_si256(a_zero, b_zero), b);
+    a = _mm256_srlv_epi32(a, tzcnt_epi32(a));
+
+    for (;;) {
+        __m256i active = _mm256_xor_si256(_mm256_cmpeq_epi32(b, zero),
+                                          _mm256_set1_epi32(-1));
+        if (_mm256_testz_si256(active, active))
+            break;
+        b = _mm256_srlv_epi32(b, tzcnt_epi32(b));
+        __m256i lo = _mm256_min_epu32(a, b);
+        __m256i hi = _mm256_max_epu32(a, b);
+        a = _mm256_blendv_epi8(a, lo, active);
+        b = _mm256_blendv_epi8(b, _mm256_sub_epi32(hi, lo), active);
+    }
+    return _mm256_sllv_epi32(a, shift);
+}
+
+__attribute__((target("avx2"))) static inline void
+gcd_batch_avx2(const uint32_t* a, const uint32_t* b, uint32_t* out,
+               size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(out + i), gcd_avx2_8(va, vb));
+    }
+    for (; i < n; ++i)
+        out[i] = gcd_scalar(a[i], b[i]);
+}
+
+// out[i] = gcd(a[i], b[i])
+static inline void gcd_batch(const uint32_t* a, const uint32_t* b,
+                             uint32_t* out, size_t n) {
+    if (__builtin_cpu_supports("avx2"))
+        gcd_batch_avx2(a, b, out, n);
+    else if (__builtin_cpu_supports("bmi"))
+        gcd_batch_bmi(a, b, out, n);
+    else
+        gcd_batch_scalar(a, b, out, n);
+}
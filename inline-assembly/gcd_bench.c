@@ -0,0 +1,121 @@
+/**
+ * @brief ./gcd.h 批量最大公约数的正确性检查与吞吐量
+ * @details
+ * 先用 ./first.c 中基于 idivl 的欧几里得算法 gcd() 作为参考，
+ * 检查各个版本在边界值和随机数对上的结果完全一致，
+ * 再测量每秒能处理多少对数。
+ *
+ * @note
+ * gcc inline-assembly/gcd_bench.c -o out/a.out -O2 && out/a.out [pairs]
+ */
+
+#include "gcd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 与 ./first.c 中的 gcd() 相同，补上了被修改的寄存器
+int gcd(int a, int b) {
+    int result;
+    /* Compute Greatest Common Divisor using Euclid's Algorithm */
+    __asm__ __volatile__("movl %1, %%eax;"
+                         "movl %2, %%ebx;"
+                         "CONTD%=: cmpl $0, %%ebx;"
+                         "je DONE%=;"
+                         "xorl %%edx, %%edx;"
+                         "idivl %%ebx;"
+                         "movl %%ebx, %%eax;"
+                         "movl %%edx, %%ebx;"
+                         "jmp CONTD%=;"
+                         "DONE%=: movl %%eax, %0;"
+                         : "=g"(result)
+                         : "g"(a), "g"(b)
+                         : "eax", "ebx", "edx", "cc");
+
+    return result;
+}
+
+typedef void (*gcd_batch_fn)(const uint32_t*, const uint32_t*, uint32_t*,
+                             size_t);
+
+static void gcd_batch_idivl(const uint32_t* a, const uint32_t* b,
+                            uint32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = gcd(a[i], b[i]);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t random31(void) {
+    return ((uint32_t)rand() << 16 ^ (uint32_t)rand()) & 0x7fffffff;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1 << 22;
+    struct {
+        const char* name;
+        gcd_batch_fn fn;
+        int supported;
+    } variants[] = {
+        {"idivl", gcd_batch_idivl, 1},
+        {"scalar", gcd_batch_scalar, 1},
+        {"bmi", gcd_batch_bmi, __builtin_cpu_supports("bmi")},
+        {"avx2", gcd_batch_avx2, __builtin_cpu_supports("avx2")},
+    };
+    const int nvariants = sizeof(variants) / sizeof(variants[0]);
+
+    uint32_t* a = malloc(n * sizeof(uint32_t));
+    uint32_t* b = malloc(n * sizeof(uint32_t));
+    uint32_t* expect = malloc(n * sizeof(uint32_t));
+    uint32_t* out = malloc(n * sizeof(uint32_t));
+
+    // 前面放一些边界值：0、1、2 的幂、相等、互为倍数、最大值
+    const uint32_t edges[] = {0, 1, 2, 3, 12, 18, 1u << 30, 0x7fffffff};
+    const size_t nedges = sizeof(edges) / sizeof(edges[0]);
+    srand(1);
+    for (size_t i = 0; i < n; ++i) {
+        if (i < nedges * nedges) {
+            a[i] = edges[i / nedges];
+            b[i] = edges[i % nedges];
+        } else if (i % 4 == 0) {
+            // 公因子较大的数对，循环次数更少
+            uint32_t f = random31() % 1000 + 1;
+            a[i] = random31() % (0x7fffffff / f) * f;
+            b[i] = random31() % (0x7fffffff / f) * f;
+        } else {
+            a[i] = random31();
+            b[i] = random31();
+        }
+    }
+    gcd_batch_idivl(a, b, expect, n);
+
+    for (int v = 0; v < nvariants; ++v) {
+        if (!variants[v].supported) {
+            printf("%-8s not supported\n", variants[v].name);
+            continue;
+        }
+        variants[v].fn(a, b, out, n);
+        for (size_t i = 0; i < n; ++i) {
+            if (out[i] != expect[i]) {
+                printf("%s: gcd(%u, %u) = %u, expected %u\n", variants[v].name,
+                       a[i], b[i], out[i], expect[i]);
+                return 1;
+            }
+        }
+
+        double begin = now_sec();
+        variants[v].fn(a, b, out, n);
+        double elapsed = now_sec() - begin;
+        printf("%-8s %8.1f M pairs/s\n", variants[v].name, n / elapsed / 1e6);
+    }
+
+    free(a);
+    free(b);
+    free(expect);
+    free(out);
+    return 0;
+}
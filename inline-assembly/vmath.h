@@ -0,0 +1,108 @@
+/**
+ * @brief 批量 sin / cos / sincos / sqrt
+ * @details
+ * ./first.c 中的 sinx()、cosx()、square_root() 每次调用只算一个 float，
+ * 走 x87 浮点栈（fld / fsin / fstp），fsin 大约要 100 个周期，也无法向量化。
+ * 这里对 float 数组批量计算，输入为弧度：
+ *
+ * 1. 区间约简：j = round(x * 2/π)，r = x - j * π/2，
+ *    π/2 拆成三段（Cody-Waite），|j| < 2^15（|x| 约小于 5e4）时误差很小。
+ * 2. 在 [-π/4, π/4] 上用多项式同时算 sin r、cos r（Cephes sinf 的系数）。
+ * 3. 按象限 j & 3 选择 ±sin r 或 ±cos r；cos x 就是象限加一的 sin。
+ * sqrt 直接使用 sqrtps 指令。
+ *
+ * 同一份实现（./vmath_impl.h）按三种指令集编译：
+ * _sse       4 路，x86-64 都支持（SSE2）
+ * _avx2      8 路，AVX2 + FMA
+ * _avx512    16 路，AVX-512F
+ * 不带后缀的 sin_batch 等按 CPU 支持情况选择。
+ *
+ * @details
+ * https://www.netlib.org/cephes/
+ * https://www.felixcloutier.com/x86/fsin
+ */
+#pragma once
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define VM_2_PI 0.636619772367581343f
+#define VM_ROUND 12582912.0f /* 1.5 * 2^23 */
+#define VM_PIO2_1 1.5703125f
+#define VM_PIO2_2 4.83751296997070312500e-04f
+#define VM_PIO2_3 7.54978995489188216e-08f
+#define VM_S1 -1.6666654611e-1f
+#define VM_S2 8.3321608736e-3f
+#define VM_S3 -1.9515295891e-4f
+#define VM_C1 4.166664568298827e-2f
+#define VM_C2 -1.388731625493765e-3f
+#define VM_C3 2.443315711809948e-5f
+
+#define VM_WIDTH 4
+#define VM_SUFFIX sse
+#define VM_SQRT _mm_sqrt_ps
+#include "vmath_impl.h"
+#undef VM_WIDTH
+#undef VM_SUFFIX
+#undef VM_SQRT
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define VM_WIDTH 8
+#define VM_SUFFIX avx2
+#define VM_SQRT _mm256_sqrt_ps
+#include "vmath_impl.h"
+#undef VM_WIDTH
+#undef VM_SUFFIX
+#undef VM_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VM_WIDTH 16
+#define VM_SUFFIX avx512
+#define VM_SQRT _mm512_sqrt_ps
+#include "vmath_impl.h"
+#undef VM_WIDTH
+#undef VM_SUFFIX
+#undef VM_SQRT
+#pragma GCC pop_options
+
+static inline void sin_batch(const float* x, float* out, size_t n) {
+    if (__builtin_cpu_supports("avx512f"))
+        sin_batch_avx512(x, out, n);
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        sin_batch_avx2(x, out, n);
+    else
+        sin_batch_sse(x, out, n);
+}
+
+static inline void cos_batch(const float* x, float* out, size_t n) {
+    if (__builtin_cpu_supports("avx512f"))
+        cos_batch_avx512(x, out, n);
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        cos_batch_avx2(x, out, n);
+    else
+        cos_batch_sse(x, out, n);
+}
+
+static inline void sincos_batch(const float* x, float* sin_out,
+                                float* cos_out, size_t n) {
+    if (__builtin_cpu_supports("avx512f"))
+        sincos_batch_avx512(x, sin_out, cos_out, n);
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        sincos_batch_avx2(x, sin_out, cos_out, n);
+    else
+        sincos_batch_sse(x, sin_out, cos_out, n);
+}
+
+static inline void sqrt_batch(const float* x, float* out, size_t n) {
+    if (__builtin_cpu_supports("avx512f"))
+        sqrt_batch_avx512(x, out, n);
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        sqrt_batch_avx2(x, out, n);
+    else
+        sqrt_batch_sse(x, out, n);
+}
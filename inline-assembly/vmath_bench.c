@@ -0,0 +1,217 @@
+/**
+ * @brief ./vmath.h 的精度（ULP）检查与速度
+ * @details
+ * 精度：在几个区间上均匀取点，与 libm 的 sinf / cosf / sqrtf 比较，
+ * 统计最大 ULP 误差（两个 float 之间可以表示的 float 个数）。
+ * |x| 很大且结果接近 0 时，区间约简的绝对误差（约 1e-11）
+ * 会表现为较大的 ULP 误差。
+ * 速度：用 rdtsc 计时，报告每个时钟周期处理的元素个数，
+ * 并与 ./first.c 中基于 x87 的 sinx / cosx / square_root 比较。
+ * x87 版本的输入是角度，这里先换算好，不计入时间。
+ *
+ * @note
+ * gcc inline-assembly/vmath_bench.c -o out/a.out -O2 -lm && out/a.out
+ */
+
+#include "vmath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <x86intrin.h> // __rdtsc
+
+#define N (1 << 20)
+
+/***
+ * 与 ./first.c 中的 x87 版本相同，
+ * 操作数约束改为内存（fld 只接受内存或 st 寄存器），并写明操作数大小
+ */
+float sinx(float degree) {
+    float result, two_right_angles = 180.0f;
+    /* Convert angle from degrees to radians and then calculate sin value */
+    __asm__ __volatile__("flds %1;"
+                         "flds %2;"
+                         "fldpi;"
+                         "fmulp;"
+                         "fdivp;"
+                         "fsin;"
+                         "fstps %0;"
+                         : "=m"(result)
+                         : "m"(two_right_angles), "m"(degree));
+    return result;
+}
+
+float cosx(float degree) {
+    float result, two_right_angles = 180.0f, radians;
+    /* Convert angle from degrees to radians and then calculate cos value */
+    __asm__ __volatile__("flds %1;"
+                         "flds %2;"
+                         "fldpi;"
+                         "fmulp;"
+                         "fdivp;"
+                         "fstps %0;"
+                         : "=m"(radians)
+                         : "m"(two_right_angles), "m"(degree));
+    __asm__ __volatile__("flds %1;"
+                         "fcos;"
+                         "fstps %0;"
+                         : "=m"(result)
+                         : "m"(radians));
+    return result;
+}
+
+float square_root(float val) {
+    float result;
+    __asm__ __volatile__("flds %1;"
+                         "fsqrt;"
+                         "fstps %0;"
+                         : "=m"(result)
+                         : "m"(val));
+    return result;
+}
+
+typedef void (*batch_fn)(const float*, float*, size_t);
+
+struct variant {
+    const char* name;
+    batch_fn sin, cos, sqrt;
+    int supported;
+};
+
+static void sin_libm(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = sinf(x[i]);
+}
+
+static void cos_libm(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = cosf(x[i]);
+}
+
+static void sqrt_libm(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = sqrtf(x[i]);
+}
+
+// x87 版本，输入为角度
+static void sin_x87(const float* deg, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = sinx(deg[i]);
+}
+
+static void cos_x87(const float* deg, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = cosx(deg[i]);
+}
+
+static void sqrt_x87(const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = square_root(x[i]);
+}
+
+// 把 float 的位模式映射成单调递增的整数，两者之差就是 ULP 距离
+static int64_t ordered(float f) {
+    int32_t i;
+    memcpy(&i, &f, sizeof(i));
+    return i < 0 ? (int64_t)INT32_MIN - i : i;
+}
+
+static int64_t max_ulp(const float* a, const float* b, size_t n) {
+    int64_t worst = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t d = llabs(ordered(a[i]) - ordered(b[i]));
+        if (d > worst)
+            worst = d;
+    }
+    return worst;
+}
+
+static double per_cycle(batch_fn fn, const float* x, float* out, size_t n) {
+    fn(x, out, n); // 预热
+    uint64_t begin = __rdtsc();
+    fn(x, out, n);
+    return (double)n / (__rdtsc() - begin);
+}
+
+int main() {
+    struct variant variants[] = {
+        {"sse", sin_batch_sse, cos_batch_sse, sqrt_batch_sse, 1},
+        {"avx2", sin_batch_avx2, cos_batch_avx2, sqrt_batch_avx2,
+         __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")},
+        {"avx512", sin_batch_avx512, cos_batch_avx512, sqrt_batch_avx512,
+         __builtin_cpu_supports("avx512f")},
+    };
+    const int nvariants = sizeof(variants) / sizeof(variants[0]);
+    const float ranges[] = {3.14159265f, 100.0f, 10000.0f};
+
+    float* x = malloc(N * sizeof(float));
+    float* deg = malloc(N * sizeof(float));
+    float* ref = malloc(N * sizeof(float));
+    float* out = malloc(N * sizeof(float));
+    float* out2 = malloc(N * sizeof(float));
+
+    printf("max ULP error against libm\n");
+    printf("%-8s %10s %10s %10s %10s\n", "variant", "range", "sin", "cos",
+           "sqrt");
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+        for (size_t i = 0; i < N; ++i)
+            x[i] = ((float)i / N * 2 - 1) * ranges[r];
+        for (int v = 0; v < nvariants; ++v) {
+            if (!variants[v].supported)
+                continue;
+            int64_t ulp[3];
+            sin_libm(x, ref, N);
+            variants[v].sin(x, out, N);
+            ulp[0] = max_ulp(out, ref, N);
+            cos_libm(x, ref, N);
+            variants[v].cos(x, out, N);
+            ulp[1] = max_ulp(out, ref, N);
+            // sqrt 只对非负数有意义
+            for (size_t i = 0; i < N; ++i)
+                out2[i] = fabsf(x[i]);
+            sqrt_libm(out2, ref, N);
+            variants[v].sqrt(out2, out, N);
+            ulp[2] = max_ulp(out, ref, N);
+            printf("%-8s %10g %10lld %10lld %10lld\n", variants[v].name,
+                   ranges[r], (long long)ulp[0], (long long)ulp[1],
+                   (long long)ulp[2]);
+        }
+    }
+
+    // sincos 与分别计算的结果应当完全一致
+    sincos_batch(x, out, out2, N);
+    sin_batch(x, ref, N);
+    int64_t sincos_ulp = max_ulp(out, ref, N);
+    cos_batch(x, ref, N);
+    if (max_ulp(out2, ref, N) > sincos_ulp)
+        sincos_ulp = max_ulp(out2, ref, N);
+    printf("sincos_batch vs sin_batch/cos_batch: %lld ULP\n",
+           (long long)sincos_ulp);
+
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = ((float)i / N * 2 - 1) * 100.0f;
+        deg[i] = x[i] * 180.0f / 3.14159265f;
+    }
+    printf("\nelements per cycle, %d elements\n", N);
+    printf("%-8s %10s %10s %10s\n", "variant", "sin", "cos", "sqrt");
+    printf("%-8s %10.3f %10.3f %10.3f\n", "x87",
+           per_cycle(sin_x87, deg, out, N), per_cycle(cos_x87, deg, out, N),
+           per_cycle(sqrt_x87, x, out, N));
+    printf("%-8s %10.3f %10.3f %10.3f\n", "libm",
+           per_cycle(sin_libm, x, out, N), per_cycle(cos_libm, x, out, N),
+           per_cycle(sqrt_libm, x, out, N));
+    for (int v = 0; v < nvariants; ++v) {
+        if (!variants[v].supported)
+            continue;
+        printf("%-8s %10.3f %10.3f %10.3f\n", variants[v].name,
+               per_cycle(variants[v].sin, x, out, N),
+               per_cycle(variants[v].cos, x, out, N),
+               per_cycle(variants[v].sqrt, x, out, N));
+    }
+
+    free(x);
+    free(deg);
+    free(ref);
+    free(out);
+    free(out2);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @brief ./vmath.h 的向量实现，不要直接包含
+ * @details
+ * 由 ./vmath.h 在不同的 #pragma GCC target 下包含多次，
+ * 每次定义 VM_WIDTH（每个向量的 float 个数）、VM_SUFFIX（函数名后缀）
+ * 和 VM_SQRT（对应指令集的开方指令）。
+ * 代码用 GCC 向量扩展写成，编译器按当前 target 生成 SSE / AVX2 / AVX-512 指令，
+ * 所以区间约简和多项式只有这一份。
+ */
+
+#define VM_CAT2(a, b) a##_##b
+#define VM_CAT(a, b) VM_CAT2(a, b)
+#define VM(name) VM_CAT(name, VM_SUFFIX)
+
+typedef float VM(vf) __attribute__((vector_size(VM_WIDTH * 4)));
+typedef int32_t VM(vi) __attribute__((vector_size(VM_WIDTH * 4)));
+
+// x = j * π/2 + r，|r| <= π/4，返回象限 j
+static inline VM(vi) VM(reduce)(VM(vf) x, VM(vf)* r) {
+    // 加减 1.5 * 2^23 得到最近的整数
+    VM(vf) j = (x * VM_2_PI + VM_ROUND) - VM_ROUND;
+    *r = ((x - j * VM_PIO2_1) - j * VM_PIO2_2) - j * VM_PIO2_3;
+    return __builtin_convertvector(j, VM(vi));
+}
+
+// [-π/4, π/4] 上 sin r 与 cos r 的多项式近似
+static inline void VM(poly)(VM(vf) r, VM(vf)* s, VM(vf)* c) {
+    VM(vf) z = r * r;
+    *s = r + r * z * (VM_S1 + z * (VM_S2 + z * VM_S3));
+    *c = 1.0f - 0.5f * z + z * z * (VM_C1 + z * (VM_C2 + z * VM_C3));
+}
+
+// sin(r + q * π/2)：q 为奇数时换成 cos，q & 2 时取负
+static inline VM(vf) VM(quadrant)(VM(vi) q, VM(vf) s, VM(vf) c) {
+    VM(vi) swap = -(q & 1);
+    VM(vi) bits = ((VM(vi))s & ~swap) | ((VM(vi))c & swap);
+    bits ^= (q & 2) << 30;
+    return (VM(vf))bits;
+}
+
+// op：0 sin，1 cos，2 sincos，3 sqrt；内联后分支在编译期消除
+static inline void VM(kernel)(VM(vf) x, VM(vf)* out0, VM(vf)* out1, int op) {
+    if (op == 3) {
+        *out0 = VM_SQRT(x);
+        return;
+    }
+    VM(vf) r, s, c;
+    VM(vi) q = VM(reduce)(x, &r);
+    VM(poly)(r, &s, &c);
+    if (op != 1)
+        *out0 = VM(quadrant)(q, s, c);
+    if (op == 1)
+        *out0 = VM(quadrant)(q + 1, s, c);
+    if (op == 2)
+        *out1 = VM(quadrant)(q + 1, s, c);
+}
+
+static inline void VM(apply)(const float* in, float* out0, float* out1,
+                             size_t n, int op) {
+    VM(vf) x, y0, y1;
+    size_t i = 0;
+    for (; i + VM_WIDTH <= n; i += VM_WIDTH) {
+        memcpy(&x, in + i, sizeof(x));
+        VM(kernel)(x, &y0, &y1, op);
+        memcpy(out0 + i, &y0, sizeof(y0));
+        if (op == 2)
+            memcpy(out1 + i, &y1, sizeof(y1));
+    }
+    if (i < n) {
+        // 不足一个向量的尾部：补 0 凑成一个向量计算
+        size_t rest = (n - i) * sizeof(float);
+        x = (VM(vf)){0};
+        memcpy(&x, in + i, rest);
+        VM(kernel)(x, &y0, &y1, op);
+        memcpy(out0 + i, &y0, rest);
+        if (op == 2)
+            memcpy(out1 + i, &y1, rest);
+    }
+}
+
+static inline void VM(sin_batch)(const float* x, float* out, size_t n) {
+    VM(apply)(x, out, NULL, n, 0);
+}
+
+static inline void VM(cos_batch)(const float* x, float* out, size_t n) {
+    VM(apply)(x, out, NULL, n, 1);
+}
+
+static inline void VM(sincos_batch)(const float* x, float* sin_out,
+                                    float* cos_out, size_t n) {
+    VM(apply)(x, sin_out, cos_out, n, 2);
+}
+
+static inline void VM(sqrt_batch)(const float* x, float* out, size_t n) {
+    VM(apply)(x, out, NULL, n, 3);
+}
+
+#undef VM
+#undef VM_CAT
+#undef VM_CAT2
@@ -0,0 +1,517 @@
+/***
+ * @brief 文件映射的环形日志：多个生产者追加，每个消费者有自己的读游标
+ * @include sys/mman.h
+ * @ref void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+ * @ref int msync(void* addr, size_t length, int flags);
+ *
+ * @details
+ * ../pipe/second.c 的 /tmp/my_fifo 只在内核里缓冲约 64 KB，
+ * 读者不在时写者要么阻塞，要么（O_NONBLOCK）只能丢掉数据；读者退出后数据也就没了。
+ * 这里把消息写进一个 MAP_SHARED 映射的普通文件，读者可以随时退出、重启后接着读。
+ *
+ * 文件布局：RINGLOG_HEADER_SIZE 字节的 struct ringlog_header，之后是 capacity 字节的数据区。
+ * 位置（pos）是从 0 开始单调增加的 64 位字节数，在数据区中的偏移为 pos & (capacity - 1)，
+ * 写满一圈之后覆盖最旧的数据。数据区分成若干段（segment），记录不跨段：
+ * 段内剩余空间放不下时，写一条 RINGLOG_PAD 记录把这一段填满，从下一段开头继续。
+ * 所以段的开头总是一条记录的开头，落后太多的读者可以直接跳到某一段的开头。
+ *
+ * 记录：8 字节 struct ringlog_record（长度、类型）+ 负载，按 8 字节对齐。
+ *
+ * 写（ringlog_reserve / ringlog_commit，或者两者合起来的 ringlog_append）
+ *      1. 对 reserve 做 CAS 预留空间（需要时顺便预留填充），多个生产者互不阻塞地填写各自的记录；
+ *         预留的终点不超过 commit + capacity，否则等前面的生产者发布，
+ *         快的生产者不会绕一圈覆盖慢的生产者还没发布的记录；
+ *      2. 按预留的顺序发布：等 commit 追上自己的起点后，把 commit 推到自己的终点。
+ *      读者只读 commit 之前的数据，不会看到写了一半的记录。
+ *      生产者在 1 和 2 之间崩溃，之后的生产者会一直等待；
+ *      确认没有生产者在运行时，ringlog_recover() 丢弃未发布的预留。
+ * 读（ringlog_consumer_open / ringlog_read）
+ *      每个消费者按名字占用头部的一个槽，槽里保存它的游标，
+ *      ringlog_read() 处理完一批记录后把游标写回槽里，重启后从这里继续。
+ *      回调直接拿到映射中负载的指针，没有拷贝。
+ *      一条记录 [pos, pos + len) 在 reserve <= pos + capacity 时还没有被覆盖；
+ *      读出记录头之后、回调之前再检查一次，发现已被覆盖（长度可能是正在写入的垃圾）
+ *      就跳到仍然完整的最旧一段，跳过的字节数计入 lost；
+ *      回调期间才被覆盖的记录回调已经看到了，返回后同样计入 lost，
+ *      所以 capacity 要大于读者可能落后的最大距离。
+ * 等待（ringlog_wait）
+ *      和 ../shm/ring.h 一样：读者登记后在 notify 上 futex 睡眠，
+ *      生产者发布之后只在有读者等待时才 FUTEX_WAKE。
+ *
+ * 持久化（ringlog_set_sync）
+ *      RINGLOG_SYNC_NONE   只写页缓存：进程崩溃不丢数据，掉电可能丢
+ *      RINGLOG_SYNC_BATCH  本生产者写了 batch_bytes 字节或过了 batch_ms 毫秒之后，
+ *                          msync(MS_SYNC) 一次这段时间写过的范围
+ *      RINGLOG_SYNC_EVERY  每条记录之后都 msync
+ *      先同步本生产者写过的数据，再同步头部。只有一个生产者时，头部里的 commit
+ *      不会指向还没落盘的数据；有多个生产者时，每个生产者只同步自己的记录，
+ *      落盘的 commit 可能越过其他生产者还没同步的记录，掉电后它们的内容不可信。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/mmap.2.html
+ * https://man7.org/linux/man-pages/man2/msync.2.html
+ * https://lmax-exchange.github.io/disruptor/disruptor.html
+ */
+#pragma once
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RINGLOG_MAGIC 0x31474f4c474e4952ULL /* "RINGLOG1" */
+#define RINGLOG_HEADER_SIZE 4096
+#define RINGLOG_ALIGN 8
+#define RINGLOG_CONSUMERS 32
+#define RINGLOG_NAME_MAX 48
+#define RINGLOG_SPIN 256
+#define RINGLOG_OPEN_TIMEOUT_MS 1000 /* 等创建者写好头部的最长时间 */
+
+enum ringlog_type { RINGLOG_DATA = 1, RINGLOG_PAD = 2 };
+
+struct ringlog_record {
+    uint32_t len;  // 负载字节数
+    uint32_t type; // enum ringlog_type
+};
+
+// 消费者槽，64 字节
+struct ringlog_slot {
+    uint32_t state; // 0 空闲，1 正在占用，2 已占用
+    uint32_t reserved;
+    uint64_t cursor;
+    char name[RINGLOG_NAME_MAX];
+};
+
+struct ringlog_header {
+    uint64_t magic;
+    uint64_t capacity; // 数据区字节数，2 的幂
+    uint64_t segment;  // 段的字节数，2 的幂，不大于 capacity
+    uint64_t reserve __attribute__((aligned(64))); // 已预留到的位置
+    uint64_t commit __attribute__((aligned(64)));  // 已发布到的位置
+    uint32_t notify __attribute__((aligned(64)));  // futex 字，每次唤醒加一
+    uint32_t waiters;                              // 正在等待的读者数
+    struct ringlog_slot slots[RINGLOG_CONSUMERS] __attribute__((aligned(64)));
+};
+
+_Static_assert(sizeof(struct ringlog_header) <= RINGLOG_HEADER_SIZE,
+               "ringlog header does not fit");
+
+enum ringlog_sync { RINGLOG_SYNC_NONE, RINGLOG_SYNC_BATCH, RINGLOG_SYNC_EVERY };
+
+struct ringlog {
+    int fd;
+    struct ringlog_header* hdr;
+    char* data;
+    uint64_t mask;
+    size_t map_size;
+    // 本进程作为生产者的同步状态
+    enum ringlog_sync sync;
+    uint64_t batch_bytes;
+    uint64_t batch_ns;
+    uint64_t dirty_begin; // 上次同步之后写过的范围
+    uint64_t dirty_end;
+    uint64_t last_sync_ns;
+};
+
+struct ringlog_consumer {
+    struct ringlog* log;
+    struct ringlog_slot* slot;
+    uint64_t pos;
+    uint64_t lost; // 被覆盖而跳过的字节数
+};
+
+// 回调中 payload 指向映射中的数据，只在本次调用期间有效
+typedef void (*ringlog_fn)(const void* payload, uint32_t len, uint64_t pos,
+                           void* arg);
+
+static inline uint64_t ringlog_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint64_t ringlog_align(uint64_t n) {
+    return (n + RINGLOG_ALIGN - 1) & ~(uint64_t)(RINGLOG_ALIGN - 1);
+}
+
+/**
+ * @brief 打开 path 处的日志，不存在时以 capacity、segment 创建
+ * @return 成功，0；失败，-1（errno）
+ * @details
+ * capacity 和 segment 必须是 2 的幂，segment 不大于 capacity；打开已有的文件时忽略这两个参数。
+ * 创建者最后才写 magic，同时打开的其他进程等它写好；
+ * 已有的文件不是 ringlog，或者 RINGLOG_OPEN_TIMEOUT_MS 内还没有 magic（创建者崩溃留下的文件）时，
+ * 返回 -1（EINVAL）。
+ */
+static inline int ringlog_open(struct ringlog* log, const char* path,
+                               uint64_t capacity, uint64_t segment) {
+    memset(log, 0, sizeof(*log));
+    int created = 1;
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd == -1 && errno == EEXIST) {
+        created = 0;
+        fd = open(path, O_RDWR);
+    }
+    if (fd == -1)
+        return -1;
+
+    if (created) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            segment < 2 * RINGLOG_ALIGN || (segment & (segment - 1)) != 0 ||
+            segment > capacity) {
+            close(fd);
+            unlink(path);
+            errno = EINVAL;
+            return -1;
+        }
+        if (ftruncate(fd, RINGLOG_HEADER_SIZE + capacity) == -1) {
+            close(fd);
+            unlink(path);
+            return -1;
+        }
+    } else {
+        // 等创建者 ftruncate 并写好 magic，再从头部读出真正的大小
+        struct ringlog_header h;
+        uint64_t deadline =
+            ringlog_now_ns() + (uint64_t)RINGLOG_OPEN_TIMEOUT_MS * 1000000;
+        for (;;) {
+            ssize_t n = pread(fd, &h, sizeof(h.magic) + sizeof(h.capacity), 0);
+            if (n == (ssize_t)(sizeof(h.magic) + sizeof(h.capacity)) &&
+                h.magic == RINGLOG_MAGIC)
+                break;
+            // 创建者写 magic 之前文件全是 0，其他内容说明不是 ringlog
+            if ((n == (ssize_t)(sizeof(h.magic) + sizeof(h.capacity)) &&
+                 h.magic != 0) ||
+                ringlog_now_ns() >= deadline) {
+                close(fd);
+                errno = EINVAL;
+                return -1;
+            }
+            usleep(100);
+        }
+        capacity = h.capacity;
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            close(fd);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    size_t size = RINGLOG_HEADER_SIZE + capacity;
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    log->fd = fd;
+    log->hdr = p;
+    log->data = (char*)p + RINGLOG_HEADER_SIZE;
+    log->mask = capacity - 1;
+    log->map_size = size;
+    if (created) {
+        log->hdr->capacity = capacity;
+        log->hdr->segment = segment;
+        __atomic_store_n(&log->hdr->magic, RINGLOG_MAGIC, __ATOMIC_RELEASE);
+        msync(p, RINGLOG_HEADER_SIZE, MS_SYNC);
+    }
+    return 0;
+}
+
+static inline int ringlog_sync(struct ringlog* log);
+
+static inline void ringlog_close(struct ringlog* log) {
+    if (log->sync != RINGLOG_SYNC_NONE)
+        ringlog_sync(log);
+    munmap(log->hdr, log->map_size);
+    close(log->fd);
+}
+
+static inline void ringlog_set_sync(struct ringlog* log,
+                                    enum ringlog_sync policy,
+                                    uint64_t batch_bytes, uint64_t batch_ms) {
+    log->sync = policy;
+    log->batch_bytes = batch_bytes;
+    log->batch_ns = batch_ms * 1000000;
+    log->last_sync_ns = ringlog_now_ns();
+}
+
+// msync 数据区中 [begin, end) 对应的页，跨过数据区末尾时分两段
+static inline int ringlog_msync_range(struct ringlog* log, uint64_t begin,
+                                      uint64_t end) {
+    uint64_t capacity = log->mask + 1;
+    if (end - begin >= capacity)
+        return msync(log->data, capacity, MS_SYNC);
+    long page = sysconf(_SC_PAGESIZE);
+    uint64_t from = begin & log->mask;
+    uint64_t to = from + (end - begin);
+    if (to > capacity) {
+        if (msync(log->data, to - capacity, MS_SYNC) == -1)
+            return -1;
+        to = capacity;
+    }
+    // 数据区从页边界开始（头部正好一页），向下对齐到页即可
+    uint64_t aligned = from & ~(uint64_t)(page - 1);
+    return msync(log->data + aligned, to - aligned, MS_SYNC);
+}
+
+// 把本进程写过的范围和头部同步到磁盘
+static inline int ringlog_sync(struct ringlog* log) {
+    if (log->dirty_end != log->dirty_begin &&
+        ringlog_msync_range(log, log->dirty_begin, log->dirty_end) == -1)
+        return -1;
+    log->dirty_begin = log->dirty_end;
+    log->last_sync_ns = ringlog_now_ns();
+    return msync(log->hdr, RINGLOG_HEADER_SIZE, MS_SYNC);
+}
+
+/**
+ * @brief 预留一条 len 字节的记录
+ * @return 负载的地址，填好后调用 ringlog_commit(log, *pos)；
+ *         len 超过一段能放下的长度时返回 NULL（EMSGSIZE）
+ * @details 未发布的预留加起来超过 capacity 时等待，同一个生产者不要在发布之前连续预留
+ */
+static inline void* ringlog_reserve(struct ringlog* log, uint32_t len,
+                                    uint64_t* pos) {
+    struct ringlog_header* h = log->hdr;
+    uint64_t size = ringlog_align(sizeof(struct ringlog_record) + len);
+    if (size > h->segment) {
+        errno = EMSGSIZE;
+        return NULL;
+    }
+    uint64_t begin = __atomic_load_n(&h->reserve, __ATOMIC_RELAXED);
+    uint64_t start;
+    for (int spins = 0;; ++spins) {
+        uint64_t left = h->segment - (begin & (h->segment - 1));
+        start = size <= left ? begin : begin + left; /* 放不下就跳到下一段 */
+        // 不覆盖 commit 之后还没发布的记录
+        if (start + size >
+            __atomic_load_n(&h->commit, __ATOMIC_ACQUIRE) + h->capacity) {
+            if (spins >= RINGLOG_SPIN)
+                sched_yield();
+            begin = __atomic_load_n(&h->reserve, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&h->reserve, &begin, start + size, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            break;
+    }
+    if (start != begin) {
+        struct ringlog_record* pad =
+            (struct ringlog_record*)(log->data + (begin & log->mask));
+        pad->len = (uint32_t)(start - begin - sizeof(*pad));
+        pad->type = RINGLOG_PAD;
+    }
+    struct ringlog_record* rec =
+        (struct ringlog_record*)(log->data + (start & log->mask));
+    rec->len = len;
+    rec->type = RINGLOG_DATA;
+    *pos = begin; /* 发布时从填充开始 */
+    return rec + 1;
+}
+
+static inline void ringlog_commit(struct ringlog* log, uint64_t pos) {
+    struct ringlog_header* h = log->hdr;
+    // 从 pos 开始：可能是填充，之后是记录本身
+    const struct ringlog_record* rec =
+        (const struct ringlog_record*)(log->data + (pos & log->mask));
+    uint64_t end = pos + ringlog_align(sizeof(*rec) + rec->len);
+    if (rec->type == RINGLOG_PAD) {
+        rec = (const struct ringlog_record*)(log->data + (end & log->mask));
+        end += ringlog_align(sizeof(*rec) + rec->len);
+    }
+
+    // 按预留顺序发布：等前面的生产者发布完
+    for (int spins = 0; __atomic_load_n(&h->commit, __ATOMIC_ACQUIRE) != pos;
+         ++spins)
+        if (spins >= RINGLOG_SPIN)
+            sched_yield();
+    __atomic_store_n(&h->commit, end, __ATOMIC_RELEASE);
+
+    // 与 ringlog_wait 中 waiters 加一之后的检查配对
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&h->waiters, __ATOMIC_RELAXED) > 0) {
+        __atomic_fetch_add(&h->notify, 1, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &h->notify, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+
+    if (log->sync == RINGLOG_SYNC_NONE)
+        return;
+    if (log->dirty_begin == log->dirty_end)
+        log->dirty_begin = pos;
+    log->dirty_end = end;
+    if (log->sync == RINGLOG_SYNC_EVERY ||
+        log->dirty_end - log->dirty_begin >= log->batch_bytes ||
+        ringlog_now_ns() - log->last_sync_ns >= log->batch_ns)
+        ringlog_sync(log);
+}
+
+// 追加一条记录，返回它的位置；失败返回 -1（errno 为 EMSGSIZE）
+static inline int64_t ringlog_append(struct ringlog* log, const void* data,
+                                     uint32_t len) {
+    uint64_t pos;
+    void* p = ringlog_reserve(log, len, &pos);
+    if (p == NULL)
+        return -1;
+    memcpy(p, data, len);
+    ringlog_commit(log, pos);
+    return (int64_t)pos;
+}
+
+// 没有生产者在运行时调用：丢弃预留了但没有发布的空间
+static inline void ringlog_recover(struct ringlog* log) {
+    __atomic_store_n(&log->hdr->reserve,
+                     __atomic_load_n(&log->hdr->commit, __ATOMIC_ACQUIRE),
+                     __ATOMIC_RELEASE);
+}
+
+// 还没有被覆盖的最旧位置（某一段的开头）
+static inline uint64_t ringlog_oldest(const struct ringlog* log) {
+    const struct ringlog_header* h = log->hdr;
+    uint64_t reserve = __atomic_load_n(&h->reserve, __ATOMIC_ACQUIRE);
+    if (reserve <= h->capacity)
+        return 0;
+    // 多留一段，给读的过程中继续写入的生产者
+    uint64_t oldest = reserve - h->capacity + h->segment;
+    return (oldest + h->segment - 1) & ~(h->segment - 1);
+}
+
+/**
+ * @brief 按名字打开一个消费者：已有同名的槽就从它保存的游标继续，否则占用一个空闲槽，
+ *        从最旧的数据开始
+ * @return 成功，0；没有空闲槽，-1（ENOSPC）
+ */
+static inline int ringlog_consumer_open(struct ringlog* log, const char* name,
+                                        struct ringlog_consumer* c) {
+    struct ringlog_header* h = log->hdr;
+    c->log = log;
+    c->lost = 0;
+    for (int i = 0; i < RINGLOG_CONSUMERS; ++i) {
+        struct ringlog_slot* s = &h->slots[i];
+        if (__atomic_load_n(&s->state, __ATOMIC_ACQUIRE) == 2 &&
+            strncmp(s->name, name, RINGLOG_NAME_MAX) == 0) {
+            c->slot = s;
+            c->pos = __atomic_load_n(&s->cursor, __ATOMIC_ACQUIRE);
+            return 0;
+        }
+    }
+    for (int i = 0; i < RINGLOG_CONSUMERS; ++i) {
+        struct ringlog_slot* s = &h->slots[i];
+        uint32_t expected = 0;
+        if (!__atomic_compare_exchange_n(&s->state, &expected, 1, 0,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+        strncpy(s->name, name, RINGLOG_NAME_MAX - 1);
+        s->name[RINGLOG_NAME_MAX - 1] = '\0';
+        c->slot = s;
+        c->pos = ringlog_oldest(log);
+        __atomic_store_n(&s->cursor, c->pos, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->state, 2, __ATOMIC_RELEASE);
+        return 0;
+    }
+    errno = ENOSPC;
+    return -1;
+}
+
+// 释放消费者的槽，之后同名的消费者从最旧的数据开始
+static inline void ringlog_consumer_remove(struct ringlog_consumer* c) {
+    memset(c->slot->name, 0, RINGLOG_NAME_MAX);
+    __atomic_store_n(&c->slot->state, 0, __ATOMIC_RELEASE);
+}
+
+// 还有多少字节没读
+static inline uint64_t ringlog_backlog(const struct ringlog_consumer* c) {
+    return __atomic_load_n(&c->log->hdr->commit, __ATOMIC_ACQUIRE) - c->pos;
+}
+
+/**
+ * @brief 对最多 max 条已发布的记录调用 fn，然后保存游标
+ * @return 处理的记录条数（不含填充）
+ */
+static inline size_t ringlog_read(struct ringlog_consumer* c, ringlog_fn fn,
+                                  void* arg, size_t max) {
+    struct ringlog* log = c->log;
+    struct ringlog_header* h = log->hdr;
+    uint64_t commit = __atomic_load_n(&h->commit, __ATOMIC_ACQUIRE);
+    size_t n = 0;
+    while (c->pos < commit && n < max) {
+        uint64_t reserve = __atomic_load_n(&h->reserve, __ATOMIC_ACQUIRE);
+        if (reserve > c->pos + h->capacity) { /* 已被覆盖 */
+            uint64_t oldest = ringlog_oldest(log);
+            c->lost += oldest - c->pos;
+            c->pos = oldest;
+            continue;
+        }
+        const struct ringlog_record* rec =
+            (const struct ringlog_record*)(log->data + (c->pos & log->mask));
+        uint32_t len = __atomic_load_n(&rec->len, __ATOMIC_RELAXED);
+        uint32_t type = __atomic_load_n(&rec->type, __ATOMIC_RELAXED);
+        uint64_t size = ringlog_align(sizeof(*rec) + len);
+        // 读记录头期间可能已被覆盖，先确认长度可信再交给回调
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->reserve, __ATOMIC_RELAXED) >
+            c->pos + h->capacity)
+            continue;
+        if (size > h->segment) { /* 文件损坏：放弃这一段 */
+            uint64_t next = (c->pos + h->segment) & ~(h->segment - 1);
+            c->lost += next - c->pos;
+            c->pos = next;
+            continue;
+        }
+        if (type == RINGLOG_DATA) {
+            fn(rec + 1, len, c->pos, arg);
+            ++n;
+        }
+        // 读完之后再检查一次，回调期间被覆盖的记录记为丢失
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->reserve, __ATOMIC_RELAXED) >
+            c->pos + h->capacity) {
+            c->lost += size;
+            n -= type == RINGLOG_DATA;
+        }
+        c->pos += size;
+    }
+    __atomic_store_n(&c->slot->cursor, c->pos, __ATOMIC_RELEASE);
+    return n;
+}
+
+/**
+ * @brief 等到有新数据（commit 超过游标）
+ * @param timeout_ms 小于 0 表示一直等
+ * @return 有数据，1；超时，0
+ */
+static inline int ringlog_wait(struct ringlog_consumer* c, int timeout_ms) {
+    struct ringlog_header* h = c->log->hdr;
+    for (int spins = 0; spins < RINGLOG_SPIN; ++spins) {
+        if (__atomic_load_n(&h->commit, __ATOMIC_ACQUIRE) > c->pos)
+            return 1;
+    }
+    uint64_t deadline = ringlog_now_ns() + (uint64_t)timeout_ms * 1000000;
+    int ready = 0;
+    __atomic_fetch_add(&h->waiters, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&h->notify, __ATOMIC_ACQUIRE);
+        ready = __atomic_load_n(&h->commit, __ATOMIC_SEQ_CST) > c->pos;
+        if (ready)
+            break;
+        // 唤醒可能是为了更早的发布，或者 seq 已经变了：重新检查
+        struct timespec ts, *tp = NULL;
+        if (timeout_ms >= 0) {
+            uint64_t now = ringlog_now_ns();
+            if (now >= deadline)
+                break;
+            ts.tv_sec = (time_t)((deadline - now) / 1000000000);
+            ts.tv_nsec = (long)((deadline - now) % 1000000000);
+            tp = &ts;
+        }
+        syscall(SYS_futex, &h->notify, FUTEX_WAIT, seq, tp, NULL, 0);
+    }
+    __atomic_fetch_sub(&h->waiters, 1, __ATOMIC_RELAXED);
+    return ready;
+}
@@ -0,0 +1,470 @@
+/***
+ * @brief ./ringlog.h 与命名管道（../pipe/second.c 的 FIFO）的对比
+ * @details
+ * 每条消息 size 字节，开头是 8 字节的序号，读者检查序号连续、没有重复和缺失。
+ *
+ * 持续吞吐量：父进程写 records 条消息，子进程边收边检查，计时到子进程收完。
+ *      fifo          每条消息一次 write()，读者一次 read() 尽量多读
+ *      ringlog/none  ringlog_append()，读者 ringlog_wait() + ringlog_read()
+ *      ringlog/batch 同上，每 1 MB 或 10 ms msync 一次
+ *      ringlog/every 同上，每条消息 msync 一次（消息数减少到 sync_records 条）
+ *
+ * 追赶：读者不在的时候写完所有消息，再启动读者，计时到读完。
+ *      fifo          读端打开但不读，写端 O_NONBLOCK：管道缓冲满之后的消息只能丢掉
+ *      ringlog       没有读者进程也照样写入；第一个读者读一半就退出，
+ *                    第二个读者（新进程，同名）从保存的游标继续，检查没有重复和缺失
+ *
+ * 绕圈：日志只有 WRAP_SEGMENTS 段、每段 WRAP_SEGMENT 字节，消息放不满一段，会写填充。
+ *      lapped        一个生产者，读者每读 WRAP_BATCH 条睡一会儿，被生产者套圈
+ *      producers     WRAP_PRODUCERS 个生产者进程同时 reserve / commit，读者不睡；
+ *                    每条记录占一整段，生产者比段多，未发布的预留加起来会超过 capacity；
+ *                    0 号生产者每 WRAP_BATCH 条在 reserve 和 commit 之间睡一会儿，
+ *                    其他生产者在这期间必须等它发布，不能绕一圈覆盖它的预留
+ *      读者逐条检查每个生产者的序号：lost 没有增加时必须连续，增加了也只能变大；
+ *      每个生产者的最后一条都要读到，lapped 的 lost 必须大于 0。
+ *      读者每次只读一条，回调期间被覆盖的记录（ringlog_read 返回 0）不检查。
+ *
+ * 日志文件默认在 /tmp，msync 的代价取决于它所在的文件系统（tmpfs 上几乎没有代价）。
+ *
+ * @note
+ * gcc interprocess-communications/mmap/ringlog_bench.c -o out/a.out -O2
+ * out/a.out [records=1000000] [size=64] [path=/tmp/ringlog_bench.log]
+ */
+
+#include "ringlog.h"
+#include <errno.h>    // errno
+#include <fcntl.h>    // open
+#include <limits.h>   // PIPE_BUF
+#include <stdint.h>   // uint64_t
+#include <stdio.h>    // printf
+#include <stdlib.h>   // exit
+#include <string.h>   // memcpy
+#include <sys/stat.h> // mkfifo
+#include <sys/wait.h> // waitpid
+#include <unistd.h>   // fork
+
+#define FIFO "/tmp/ringlog_bench_fifo"
+#define READ_BUF (64 * 1024)
+#define SEGMENT (1 << 20)
+#define READER_TIMEOUT_MS 30000 /* 写者 msync 时可能要等磁盘很久 */
+#define WRAP_SEGMENT 4096
+#define WRAP_SEGMENTS 4
+#define WRAP_PAYLOAD 60 /* 加上 8 字节记录头对齐到 72，一段放不整 */
+#define WRAP_BIG_PAYLOAD (WRAP_SEGMENT / 2) /* 一段只放得下一条 */
+#define WRAP_PRODUCERS 6
+#define WRAP_BATCH 64
+#define WRAP_SLEEP_US 200
+#define WRAP_RECORDS 100000 /* 与 records 无关，保证绕很多圈 */
+
+static double now_sec(void) {
+    return ringlog_now_ns() * 1e-9;
+}
+
+static void die(const char* what) {
+    perror(what);
+    exit(EXIT_FAILURE);
+}
+
+static pid_t fork_or_die(void) {
+    pid_t pid = fork();
+    if (pid == -1)
+        die("fork");
+    return pid;
+}
+
+// 等子进程正常退出，返回它的退出码
+static int wait_child(pid_t pid) {
+    int status;
+    if (waitpid(pid, &status, 0) == -1)
+        die("waitpid");
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* ---- FIFO ---- */
+
+// 读到 EOF，检查序号；返回收到的消息数
+static uint64_t fifo_consume(int fd, size_t size) {
+    static char buf[READ_BUF];
+    size_t have = 0;
+    uint64_t expect = 0;
+    ssize_t n;
+    while ((n = read(fd, buf + have, sizeof(buf) - have)) > 0) {
+        have += (size_t)n;
+        size_t k = have / size;
+        for (size_t i = 0; i < k; ++i) {
+            uint64_t seq;
+            memcpy(&seq, buf + i * size, sizeof(seq));
+            if (seq != expect)
+                _exit(EXIT_FAILURE);
+            ++expect;
+        }
+        have -= k * size;
+        memmove(buf, buf + k * size, have);
+    }
+    return expect;
+}
+
+static double fifo_throughput(uint64_t records, size_t size) {
+    unlink(FIFO);
+    if (mkfifo(FIFO, 0666) == -1)
+        die("mkfifo");
+    double begin = now_sec();
+    pid_t pid = fork_or_die();
+    if (pid == 0) {
+        int fd = open(FIFO, O_RDONLY);
+        _exit(fifo_consume(fd, size) == records ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int fd = open(FIFO, O_WRONLY);
+    if (fd == -1)
+        die("open fifo");
+    char* msg = calloc(1, size);
+    for (uint64_t seq = 0; seq < records; ++seq) {
+        memcpy(msg, &seq, sizeof(seq));
+        if (write(fd, msg, size) != (ssize_t)size)
+            die("write fifo");
+    }
+    close(fd);
+    if (wait_child(pid) != EXIT_SUCCESS) {
+        fprintf(stderr, "fifo reader failed\n");
+        exit(EXIT_FAILURE);
+    }
+    free(msg);
+    unlink(FIFO);
+    return records / (now_sec() - begin);
+}
+
+/**
+ * 读端打开但暂不读，写端 O_NONBLOCK 写入所有消息，EAGAIN 的就丢掉；
+ * 然后让读者开始读（通过一个管道通知），返回读完用的秒数
+ */
+static double fifo_catch_up(uint64_t records, size_t size, uint64_t* kept) {
+    unlink(FIFO);
+    if (mkfifo(FIFO, 0666) == -1)
+        die("mkfifo");
+    int go[2];
+    if (pipe(go) == -1)
+        die("pipe");
+    pid_t pid = fork_or_die();
+    if (pid == 0) {
+        int fd = open(FIFO, O_RDONLY);
+        char c;
+        if (read(go[0], &c, 1) != 1)
+            _exit(EXIT_FAILURE);
+        // 丢掉消息后序号不再连续，这里只数条数
+        static char buf[READ_BUF];
+        uint64_t bytes = 0;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0)
+            bytes += (uint64_t)n;
+        _exit(bytes % size == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int fd = open(FIFO, O_WRONLY); /* 等读端打开 */
+    if (fd == -1)
+        die("open fifo");
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    char* msg = calloc(1, size);
+    *kept = 0;
+    for (uint64_t seq = 0; seq < records; ++seq) {
+        memcpy(msg, &seq, sizeof(seq));
+        if (write(fd, msg, size) == (ssize_t)size)
+            ++*kept;
+        else if (errno != EAGAIN)
+            die("write fifo");
+    }
+    close(fd);
+    double begin = now_sec();
+    if (write(go[1], "g", 1) != 1)
+        die("write");
+    if (wait_child(pid) != EXIT_SUCCESS) {
+        fprintf(stderr, "fifo reader failed\n");
+        exit(EXIT_FAILURE);
+    }
+    free(msg);
+    unlink(FIFO);
+    return now_sec() - begin;
+}
+
+/* ---- ringlog ---- */
+
+struct check {
+    uint64_t expect;
+    int bad;
+};
+
+static void on_record(const void* payload, uint32_t len, uint64_t pos,
+                      void* arg) {
+    struct check* ck = arg;
+    uint64_t seq;
+    (void)pos;
+    (void)len;
+    memcpy(&seq, payload, sizeof(seq));
+    ck->bad |= seq != ck->expect;
+    ++ck->expect;
+}
+
+/**
+ * 子进程：以 name 打开消费者，从保存的游标继续读到第 until 条（序号）为止；
+ * first 为第一条应有的序号。成功以 0 退出
+ */
+static void ringlog_reader(const char* path, const char* name, uint64_t first,
+                           uint64_t until) {
+    struct ringlog log;
+    struct ringlog_consumer c;
+    if (ringlog_open(&log, path, 0, 0) == -1 ||
+        ringlog_consumer_open(&log, name, &c) == -1)
+        _exit(2);
+    struct check ck = {first, 0};
+    while (ck.expect < until && !ck.bad) {
+        if (!ringlog_wait(&c, READER_TIMEOUT_MS))
+            _exit(3);
+        ringlog_read(&c, on_record, &ck, until - ck.expect);
+    }
+    _exit(ck.bad || c.lost != 0 ? 4 : 0);
+}
+
+static uint64_t capacity_for(uint64_t records, size_t size) {
+    uint64_t need =
+        2 * records * ringlog_align(sizeof(struct ringlog_record) + size);
+    uint64_t capacity = 4 * SEGMENT;
+    while (capacity < need)
+        capacity <<= 1;
+    return capacity;
+}
+
+static void ringlog_create(struct ringlog* log, const char* path,
+                           uint64_t records, size_t size) {
+    unlink(path);
+    if (ringlog_open(log, path, capacity_for(records, size), SEGMENT) == -1)
+        die("ringlog_open");
+}
+
+static void ringlog_produce(struct ringlog* log, uint64_t records,
+                            size_t size) {
+    char* msg = calloc(1, size);
+    for (uint64_t seq = 0; seq < records; ++seq) {
+        memcpy(msg, &seq, sizeof(seq));
+        if (ringlog_append(log, msg, (uint32_t)size) == -1)
+            die("ringlog_append");
+    }
+    free(msg);
+}
+
+static double ringlog_throughput(const char* path, uint64_t records,
+                                 size_t size, enum ringlog_sync policy) {
+    struct ringlog log;
+    ringlog_create(&log, path, records, size);
+    ringlog_set_sync(&log, policy, SEGMENT, 10);
+    // 先建好消费者槽，读者从 0 开始
+    struct ringlog_consumer c;
+    if (ringlog_consumer_open(&log, "reader", &c) == -1)
+        die("ringlog_consumer_open");
+
+    double begin = now_sec();
+    pid_t pid = fork_or_die();
+    if (pid == 0)
+        ringlog_reader(path, "reader", 0, records);
+    ringlog_produce(&log, records, size);
+    if (ringlog_sync(&log) == -1)
+        die("msync");
+    int status = wait_child(pid);
+    double elapsed = now_sec() - begin;
+    if (status != 0) {
+        fprintf(stderr, "ringlog reader failed (%d)\n", status);
+        exit(EXIT_FAILURE);
+    }
+    ringlog_close(&log);
+    return records / elapsed;
+}
+
+/**
+ * 先写完所有消息（没有读者进程），再依次启动两个同名读者：
+ * 第一个读一半后退出，第二个从保存的游标读完。返回两个读者一共用的秒数
+ */
+static double ringlog_catch_up(const char* path, uint64_t records,
+                               size_t size) {
+    struct ringlog log;
+    ringlog_create(&log, path, records, size);
+    ringlog_produce(&log, records, size);
+    ringlog_close(&log);
+
+    double begin = now_sec();
+    for (int round = 0; round < 2; ++round) {
+        uint64_t first = round == 0 ? 0 : records / 2;
+        uint64_t until = round == 0 ? records / 2 : records;
+        pid_t pid = fork_or_die();
+        if (pid == 0)
+            ringlog_reader(path, "catch-up", first, until);
+        int status = wait_child(pid);
+        if (status != 0) {
+            fprintf(stderr, "ringlog reader %d failed (%d)\n", round, status);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return now_sec() - begin;
+}
+
+/* ---- 绕圈 ---- */
+
+struct wrap_msg {
+    uint64_t producer;
+    uint64_t seq;
+};
+
+struct wrap_check {
+    uint32_t payload;
+    struct wrap_msg got; // 本次 ringlog_read 最后一次回调看到的消息
+    uint64_t next[WRAP_PRODUCERS];      // 每个生产者下一条的序号
+    uint64_t lost_at[WRAP_PRODUCERS];   // 读到该生产者上一条时的 lost
+    uint64_t received;
+    int bad;
+};
+
+static void on_wrap_record(const void* payload, uint32_t len, uint64_t pos,
+                           void* arg) {
+    struct wrap_check* ck = arg;
+    (void)pos;
+    ck->bad |= len != ck->payload;
+    memcpy(&ck->got, payload, sizeof(ck->got));
+}
+
+// 读者子进程：读到每个生产者的最后一条为止；slow 的读者 lost 为 0 时以 5 退出
+static void wrap_reader(const char* path, uint64_t producers,
+                        uint64_t records, uint32_t payload, int slow) {
+    struct ringlog log;
+    struct ringlog_consumer c;
+    if (ringlog_open(&log, path, 0, 0) == -1 ||
+        ringlog_consumer_open(&log, "wrap", &c) == -1)
+        _exit(2);
+    struct wrap_check ck = {payload, {0, 0}, {0}, {0}, 0, 0};
+    uint64_t done = 0;
+    while (done < producers && !ck.bad) {
+        if (!ringlog_wait(&c, READER_TIMEOUT_MS))
+            _exit(3);
+        while (done < producers && !ck.bad) {
+            uint64_t lost = c.lost;
+            size_t n = ringlog_read(&c, on_wrap_record, &ck, 1);
+            if (n == 0 && c.lost == lost)
+                break; /* 暂时没有新记录 */
+            if (n == 0)
+                continue; /* 回调期间被覆盖，内容不可信 */
+            uint64_t p = ck.got.producer;
+            if (p >= producers || ck.got.seq < ck.next[p] ||
+                (c.lost == ck.lost_at[p] && ck.got.seq != ck.next[p])) {
+                ck.bad = 1;
+                break;
+            }
+            ck.next[p] = ck.got.seq + 1;
+            ck.lost_at[p] = c.lost;
+            done += ck.next[p] == records;
+            if (++ck.received % WRAP_BATCH == 0 && slow)
+                usleep(WRAP_SLEEP_US);
+        }
+    }
+    if (ck.bad)
+        _exit(4);
+    if (slow && c.lost == 0)
+        _exit(5);
+    printf("%-14s %12llu %12llu\n", slow ? "lapped" : "producers",
+           (unsigned long long)ck.received, (unsigned long long)c.lost);
+    fflush(stdout);
+    _exit(0);
+}
+
+static void wrap_run(const char* path, uint64_t producers, uint64_t records,
+                     uint32_t payload, int slow) {
+    struct ringlog log;
+    unlink(path);
+    if (ringlog_open(&log, path, WRAP_SEGMENTS * WRAP_SEGMENT, WRAP_SEGMENT) ==
+        -1)
+        die("ringlog_open");
+    struct ringlog_consumer c;
+    if (ringlog_consumer_open(&log, "wrap", &c) == -1)
+        die("ringlog_consumer_open");
+
+    pid_t reader = fork_or_die();
+    if (reader == 0)
+        wrap_reader(path, producers, records, payload, slow);
+    pid_t writers[WRAP_PRODUCERS];
+    for (uint64_t p = 0; p < producers; ++p) {
+        writers[p] = fork_or_die();
+        if (writers[p] == 0) {
+            for (uint64_t seq = 0; seq < records; ++seq) {
+                uint64_t pos;
+                char* msg = ringlog_reserve(&log, payload, &pos);
+                if (msg == NULL)
+                    _exit(EXIT_FAILURE);
+                struct wrap_msg m = {p, seq};
+                memcpy(msg, &m, sizeof(m));
+                memset(msg + sizeof(m), 0, payload - sizeof(m));
+                if (producers > 1 && p == 0 && seq % WRAP_BATCH == 0)
+                    usleep(WRAP_SLEEP_US);
+                ringlog_commit(&log, pos);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+    for (uint64_t p = 0; p < producers; ++p) {
+        if (wait_child(writers[p]) != EXIT_SUCCESS) {
+            fprintf(stderr, "wrap producer %llu failed\n",
+                    (unsigned long long)p);
+            exit(EXIT_FAILURE);
+        }
+    }
+    int status = wait_child(reader);
+    if (status != 0) {
+        fprintf(stderr, "wrap reader failed (%d)\n", status);
+        exit(EXIT_FAILURE);
+    }
+    ringlog_close(&log);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t records = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t size = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+    const char* path = argc > 3 ? argv[3] : "/tmp/ringlog_bench.log";
+    uint64_t sync_records = records < 2000 ? records : 2000;
+    if (size < sizeof(uint64_t) || size > PIPE_BUF) {
+        fprintf(stderr, "size must be between 8 and %d\n", PIPE_BUF);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%llu records x %zu bytes, log %s\n\n", (unsigned long long)records,
+           size, path);
+    printf("%-14s %12s %10s\n", "throughput", "records/s", "MB/s");
+    struct {
+        const char* name;
+        enum ringlog_sync policy;
+        uint64_t records;
+    } rows[] = {
+        {"fifo", RINGLOG_SYNC_NONE, records},
+        {"ringlog/none", RINGLOG_SYNC_NONE, records},
+        {"ringlog/batch", RINGLOG_SYNC_BATCH, records},
+        {"ringlog/every", RINGLOG_SYNC_EVERY, sync_records},
+    };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); ++i) {
+        double rate = i == 0 ? fifo_throughput(records, size)
+                             : ringlog_throughput(path, rows[i].records, size,
+                                                  rows[i].policy);
+        printf("%-14s %12.0f %10.1f\n", rows[i].name, rate, rate * size / 1e6);
+        fflush(stdout);
+    }
+
+    uint64_t kept;
+    double fifo_s = fifo_catch_up(records, size, &kept);
+    double log_s = ringlog_catch_up(path, records, size);
+    printf("\n%-14s %12s %12s\n", "catch-up", "kept", "drain_ms");
+    printf("%-14s %12llu %12.2f  (%llu dropped)\n", "fifo",
+           (unsigned long long)kept, fifo_s * 1e3,
+           (unsigned long long)(records - kept));
+    printf("%-14s %12llu %12.2f  (two reader processes, resumed by name)\n",
+           "ringlog", (unsigned long long)records, log_s * 1e3);
+
+    printf("\n%-14s %12s %12s  (%d x %d byte segments)\n", "wrap-around",
+           "checked", "lost_bytes", WRAP_SEGMENTS, WRAP_SEGMENT);
+    fflush(stdout);
+    wrap_run(path, 1, WRAP_RECORDS, WRAP_PAYLOAD, 1);
+    wrap_run(path, WRAP_PRODUCERS, WRAP_RECORDS / WRAP_PRODUCERS,
+             WRAP_BIG_PAYLOAD, 0);
+    unlink(path);
+    return 0;
+}
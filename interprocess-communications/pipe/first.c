@@ -9,6 +9,7 @@
  * pipefd[0] 指的是管道的读取端。 pipefd[1] 指的是管道的写端。
  * 写入管道写入端的数据由内核缓冲，直到从管道的读取端读取。
  * 如果 flags 为 0，则 pipe2() 与 pipe() 相同。
+ * 数据的收发使用 ./transfer.h，不再一次一个字节地 read/write。
  *
  * @return
  * 成功时，返回零。 出错时，返回 -1，并适当设置 errno。
@@ -20,6 +21,7 @@
  * gcc interprocess-communications/pipe/first.c -o out/a.out && out/a.out 123
  */
 
+#include "transfer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,17 +47,17 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    char buf;
     if (cpid == 0) {      /* Child reads from pipe */
         close(pipefd[1]); /* Close unused write end */
-        while (read(pipefd[0], &buf, 1) > 0)
-            write(STDOUT_FILENO, &buf, 1);
+        if (pipe_drain(pipefd[0], STDOUT_FILENO, PIPE_SPLICE, 0) == -1)
+            perror("pipe_drain");
         write(STDOUT_FILENO, "\n", 1);
         close(pipefd[0]);
         _exit(EXIT_SUCCESS);
     } else {              /* Parent writes argv[1] to pipe */
         close(pipefd[0]); /* Close unused read end */
-        write(pipefd[1], argv[1], strlen(argv[1]));
+        if (pipe_send(pipefd[1], argv[1], strlen(argv[1]), PIPE_WRITE, 0))
+            perror("pipe_send");
         close(pipefd[1]); /* Reader will see EOF */
         wait(NULL);       /* Wait for child */
         exit(EXIT_SUCCESS);
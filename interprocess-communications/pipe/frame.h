@@ -0,0 +1,199 @@
+/***
+ * @brief 管道上的消息帧：多个写者、批量 writev、readv 环形缓冲区
+ * @include sys/uio.h
+ * @ref ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+ * @ref ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+ *
+ * @details
+ * ./first.c 直接写字节流，没有消息边界；多个进程同时写同一个管道时，
+ * 超过 PIPE_BUF 的 write() 不保证原子性，内容会交错。
+ *
+ * 帧格式：8 字节 struct frame_hdr（长度、写者编号、序号）+ 负载。
+ *
+ * 写端 struct frame_writer：
+ *      frame_write() 只把帧头和负载指针追加到 iovec 数组，
+ *      攒到下一帧放不进 PIPE_BUF 时，用一次 writev() 全部写出。
+ *      一次 writev() 的总长不超过 PIPE_BUF，对管道是原子的，
+ *      所以多个写者共用一个管道时，每批帧都完整地连在一起。
+ *      负载在 frame_flush() 之前不能修改或释放。
+ * 读端 struct frame_reader：
+ *      一块固定的环形缓冲区，初始化时分配一次，之后不再分配。
+ *      环中空闲空间最多分成两段（尾部到末尾、开头到头部），
+ *      一次 readv() 把两段都填满，读到的所有完整帧依次交给回调。
+ *      跨越环末尾的帧，把绕回开头的部分复制到末尾之后的溢出区，
+ *      回调看到的负载总是连续的。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man7/pipe.7.html
+ * https://man7.org/linux/man-pages/man2/readv.2.html
+ */
+#pragma once
+
+#include <errno.h>
+#include <limits.h> // PIPE_BUF
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct frame_hdr {
+    uint16_t len;    // 负载字节数
+    uint16_t writer; // 写者编号
+    uint32_t seq;    // 该写者的帧序号
+};
+
+#define FRAME_MAX PIPE_BUF
+#define FRAME_PAYLOAD_MAX (FRAME_MAX - sizeof(struct frame_hdr))
+#define FRAME_BATCH_MAX (FRAME_MAX / sizeof(struct frame_hdr))
+#define FRAME_RING_SIZE (64 * 1024)
+
+struct frame_writer {
+    int fd;
+    uint16_t id;
+    uint32_t seq;
+    int nframes;
+    int iovcnt;
+    size_t bytes; // 当前批次的总字节数
+    struct frame_hdr hdrs[FRAME_BATCH_MAX];
+    struct iovec iov[2 * FRAME_BATCH_MAX];
+};
+
+struct frame_reader {
+    int fd;
+    uint64_t head; // 下一帧的位置（累计字节数）
+    uint64_t tail; // 已读入的位置（累计字节数）
+    char* ring;    // FRAME_RING_SIZE 字节 + FRAME_MAX 字节溢出区
+};
+
+// 回调中 payload 只在本次调用期间有效
+typedef void (*frame_fn)(const struct frame_hdr* hdr, const char* payload,
+                         void* arg);
+
+static inline void frame_writer_init(struct frame_writer* w, int fd,
+                                     uint16_t id) {
+    w->fd = fd;
+    w->id = id;
+    w->seq = 0;
+    w->nframes = 0;
+    w->iovcnt = 0;
+    w->bytes = 0;
+}
+
+// 把攒下的帧用一次 writev() 写出，成功返回 0，失败返回 -1
+static inline int frame_flush(struct frame_writer* w) {
+    if (w->iovcnt == 0)
+        return 0;
+    // 不超过 PIPE_BUF 的写要么全部写入，要么什么都不写
+    while (writev(w->fd, w->iov, w->iovcnt) == -1) {
+        if (errno != EINTR)
+            return -1;
+    }
+    w->nframes = 0;
+    w->iovcnt = 0;
+    w->bytes = 0;
+    return 0;
+}
+
+/**
+ * @brief 追加一帧，当前批次放不下时先 frame_flush()
+ * @return 成功，0；失败，-1（len 超过 FRAME_PAYLOAD_MAX 时 errno 为 EMSGSIZE）
+ */
+static inline int frame_write(struct frame_writer* w, const void* data,
+                              size_t len) {
+    if (len > FRAME_PAYLOAD_MAX) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    size_t size = sizeof(struct frame_hdr) + len;
+    if (w->bytes + size > FRAME_MAX && frame_flush(w) == -1)
+        return -1;
+
+    struct frame_hdr* hdr = &w->hdrs[w->nframes++];
+    hdr->len = (uint16_t)len;
+    hdr->writer = w->id;
+    hdr->seq = w->seq++;
+    w->iov[w->iovcnt].iov_base = hdr;
+    w->iov[w->iovcnt++].iov_len = sizeof(*hdr);
+    if (len > 0) {
+        w->iov[w->iovcnt].iov_base = (void*)data;
+        w->iov[w->iovcnt++].iov_len = len;
+    }
+    w->bytes += size;
+    return 0;
+}
+
+// 成功返回 0，失败返回 -1
+static inline int frame_reader_init(struct frame_reader* r, int fd) {
+    r->fd = fd;
+    r->head = 0;
+    r->tail = 0;
+    r->ring = (char*)malloc(FRAME_RING_SIZE + FRAME_MAX);
+    return r->ring == NULL ? -1 : 0;
+}
+
+static inline void frame_reader_destroy(struct frame_reader* r) {
+    free(r->ring);
+    r->ring = NULL;
+}
+
+/**
+ * @brief 一次 readv() 尽量填满环形缓冲区，对每个完整的帧调用 fn
+ * @details 没有读到完整的帧时继续读，直到至少交付一帧
+ * @return 交付的帧数；写端全部关闭时返回 0；
+ *         失败返回 -1，EOF 时残留半个帧或帧头非法时 errno 为 EPROTO
+ */
+static inline ssize_t frame_read(struct frame_reader* r, frame_fn fn,
+                                 void* arg) {
+    ssize_t count = 0;
+    while (count == 0) {
+        size_t used = (size_t)(r->tail - r->head);
+        size_t free_bytes = FRAME_RING_SIZE - used;
+        size_t t = (size_t)(r->tail % FRAME_RING_SIZE);
+        size_t first = FRAME_RING_SIZE - t < free_bytes ? FRAME_RING_SIZE - t
+                                                        : free_bytes;
+        struct iovec iov[2] = {{r->ring + t, first},
+                               {r->ring, free_bytes - first}};
+
+        ssize_t n = readv(r->fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0) {
+            if (r->head == r->tail)
+                return 0;
+            errno = EPROTO;
+            return -1;
+        }
+        r->tail += n;
+
+        for (;;) {
+            size_t avail = (size_t)(r->tail - r->head);
+            size_t h = (size_t)(r->head % FRAME_RING_SIZE);
+            size_t contig = FRAME_RING_SIZE - h;
+            if (avail < sizeof(struct frame_hdr))
+                break;
+            // 帧跨越环末尾：绕回的部分复制到溢出区
+            if (contig < avail && contig < FRAME_MAX) {
+                size_t want = avail < FRAME_MAX ? avail : FRAME_MAX;
+                memcpy(r->ring + FRAME_RING_SIZE, r->ring, want - contig);
+            }
+
+            struct frame_hdr hdr;
+            memcpy(&hdr, r->ring + h, sizeof(hdr));
+            if (hdr.len > FRAME_PAYLOAD_MAX) {
+                errno = EPROTO;
+                return -1;
+            }
+            size_t size = sizeof(hdr) + hdr.len;
+            if (avail < size)
+                break;
+            fn(&hdr, r->ring + h + sizeof(hdr), arg);
+            r->head += size;
+            ++count;
+        }
+    }
+    return count;
+}
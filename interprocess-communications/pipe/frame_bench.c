@@ -0,0 +1,155 @@
+/***
+ * @brief ./frame.h 的多写者汇聚（fan-in）测试
+ * @details
+ * writers 个子进程共用一个管道，各自发送 messages 条 size 字节的消息，
+ * 父进程用 frame_reader 读出全部消息，并检查：
+ * 每个写者的序号连续递增（帧没有交错、丢失），负载内容正确。
+ *
+ * batched    frame_write() 攒满 PIPE_BUF 再 writev()
+ * unbatched  每条消息都 frame_flush()，一条消息一次 writev()
+ *
+ * 用 benchmark/bench.h 计时，报告每秒消息数和平均每次 readv 读到的帧数。
+ *
+ * @note
+ * gcc interprocess-communications/pipe/frame_bench.c -o out/a.out -O2 -lm
+ * out/a.out [writers=4] [messages=100000] [size=32]
+ */
+
+#include "../../benchmark/bench.h"
+#include "frame.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct fanin {
+    int writers;
+    int messages;
+    size_t size;
+    int batched;
+    uint32_t* next_seq; // 每个写者期望的下一个序号
+    long frames;
+    long reads;
+};
+
+static void writer_main(int fd, uint16_t id, const struct fanin* f) {
+    static struct frame_writer w;
+    // 一批最多 FRAME_BATCH_MAX 帧，按序号轮流使用这么多个槽位，
+    // 改写一个槽位时，上一次使用它的帧一定已经 flush 了
+    char* payload = malloc(FRAME_BATCH_MAX * f->size + 1);
+    frame_writer_init(&w, fd, id);
+    for (int i = 0; i < f->messages; ++i) {
+        char* p = payload + (w.seq % FRAME_BATCH_MAX) * f->size;
+        memset(p, (char)(w.seq + id), f->size);
+        if (frame_write(&w, p, f->size) == -1 ||
+            (!f->batched && frame_flush(&w) == -1)) {
+            perror("frame_write");
+            _exit(EXIT_FAILURE);
+        }
+    }
+    if (frame_flush(&w) == -1) {
+        perror("frame_flush");
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+static void on_frame(const struct frame_hdr* hdr, const char* payload,
+                     void* arg) {
+    struct fanin* f = arg;
+    if (hdr->writer >= f->writers || hdr->seq != f->next_seq[hdr->writer] ||
+        hdr->len != f->size ||
+        (f->size > 0 && payload[0] != (char)(hdr->seq + hdr->writer))) {
+        fprintf(stderr, "bad frame: writer %u seq %u len %u\n", hdr->writer,
+                hdr->seq, hdr->len);
+        exit(EXIT_FAILURE);
+    }
+    ++f->next_seq[hdr->writer];
+    ++f->frames;
+}
+
+// 一轮：writers 个子进程写，父进程读完并回收子进程
+static void fanin_round(void* arg) {
+    struct fanin* f = arg;
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < f->writers; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(pipefd[0]);
+            writer_main(pipefd[1], (uint16_t)i, f);
+        }
+    }
+    close(pipefd[1]);
+
+    memset(f->next_seq, 0, f->writers * sizeof(uint32_t));
+    struct frame_reader r;
+    if (frame_reader_init(&r, pipefd[0]) == -1) {
+        perror("frame_reader_init");
+        exit(EXIT_FAILURE);
+    }
+    ssize_t n;
+    while ((n = frame_read(&r, on_frame, f)) > 0)
+        ++f->reads;
+    if (n == -1) {
+        perror("frame_read");
+        exit(EXIT_FAILURE);
+    }
+    frame_reader_destroy(&r);
+    close(pipefd[0]);
+    while (wait(NULL) > 0)
+        ;
+
+    for (int i = 0; i < f->writers; ++i) {
+        if (f->next_seq[i] != (uint32_t)f->messages) {
+            fprintf(stderr, "writer %d: %u of %d messages\n", i,
+                    f->next_seq[i], f->messages);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    struct fanin f = {0};
+    f.writers = argc > 1 ? atoi(argv[1]) : 4;
+    f.messages = argc > 2 ? atoi(argv[2]) : 100000;
+    f.size = argc > 3 ? strtoul(argv[3], NULL, 10) : 32;
+    if (f.size > FRAME_PAYLOAD_MAX) {
+        fprintf(stderr, "size must be at most %zu\n", FRAME_PAYLOAD_MAX);
+        exit(EXIT_FAILURE);
+    }
+    f.next_seq = calloc(f.writers, sizeof(uint32_t));
+
+    bench_init(NULL);
+    const char* names[] = {"unbatched", "batched"};
+    double msgs_per_s[2], frames_per_read[2];
+    for (int batched = 0; batched < 2; ++batched) {
+        f.batched = batched;
+        f.frames = 0;
+        f.reads = 0;
+        struct bench_result r = bench_run(names[batched], fanin_round, &f,
+                                          (double)f.writers * f.messages);
+        bench_report(&r);
+        msgs_per_s[batched] = 1e9 / r.median_ns;
+        frames_per_read[batched] = (double)f.frames / f.reads;
+    }
+
+    if (bench_cfg.format == BENCH_TEXT) {
+        printf("\n%d writers x %d messages x %zu bytes\n", f.writers,
+               f.messages, f.size);
+        printf("%-10s %14s %16s\n", "mode", "msgs_per_s", "frames_per_readv");
+        for (int i = 0; i < 2; ++i)
+            printf("%-10s %14.0f %16.1f\n", names[i], msgs_per_s[i],
+                   frames_per_read[i]);
+    }
+    free(f.next_seq);
+    return 0;
+}
@@ -6,51 +6,242 @@
  * @details
  * https://www.cnblogs.com/xianghang123/archive/2012/03/31/2427731.html
  *
+ * @brief 用 epoll 同时读取多个 FIFO
+ * @include sys/epoll.h
+ * @details
+ * 每个 FIFO 以 O_NONBLOCK 打开，并以 EPOLLET（边沿触发）注册到同一个 epoll，
+ * 收到通知后一直 read() 到 EAGAIN，把数据读干净再回到 epoll_wait()。
+ * 没有 sleep()，消息一到就被处理。
+ *
+ * 所有写者都关闭后，读端会一直读到 EOF，
+ * 所以读者自己再以写方式打开一次每个 FIFO，让 FIFO 始终“有写者”。
+ *
+ * 读取由 ./uring.h 的 uring_reader 完成，默认就是上面的 epoll 后端；
+ * -u 改用 io_uring（多次读取，内核不支持时依次退回注册缓冲区读取、epoll）。
+ *
+ * 延迟模式（-l）：fork 出若干生产者，轮流写入各个 FIFO，
+ * 每条消息带上发送时刻（CLOCK_MONOTONIC），读者统计投递延迟的直方图。
+ * 消息长度远小于 PIPE_BUF，多个生产者同时写也不会交错。
+ *
+ * https://man7.org/linux/man-pages/man7/epoll.7.html
+ * https://man7.org/linux/man-pages/man7/fifo.7.html
+ *
  * @note
  * gcc interprocess-communications/pipe/second.c -o out/a.out && out/a.out
+ * echo hello >> /tmp/my_fifo
  * echo Q >> /tmp/my_fifo
  * rm /tmp/my_fifo
+ *
+ * 同时读 4 个 FIFO（/tmp/my_fifo、/tmp/my_fifo.1 …）：
+ * out/a.out -n 4
+ * 延迟模式，4 个 FIFO，200 个生产者，每个发送 100 条消息：
+ * out/a.out -n 4 -l 200 -c 100
+ * 使用 io_uring：
+ * out/a.out -n 4 -l 200 -c 100 -u
  */
 
+#include "uring.h"
 #include <errno.h>    // errno
-#include <fcntl.h>    // O_CREAT
+#include <fcntl.h>    // O_NONBLOCK
+#include <stdint.h>   // uint64_t
 #include <stdio.h>    // printf
 #include <stdlib.h>   // exit
+#include <string.h>   // memchr
 #include <sys/stat.h> // mkfifo
+#include <sys/wait.h> // wait
+#include <time.h>     // clock_gettime
 #include <unistd.h>   // read
 
 #define FIFO "/tmp/my_fifo"
+#define MAX_FIFOS 1024
+#define HIST_BUCKETS 64
+
+// 延迟模式下的消息，16 字节
+struct message {
+    uint64_t send_ns;
+    uint32_t producer;
+    uint32_t seq;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void fifo_path(char* buf, size_t len, int index) {
+    if (index == 0)
+        snprintf(buf, len, "%s", FIFO);
+    else
+        snprintf(buf, len, "%s.%d", FIFO, index);
+}
+
+// 生产者：轮流向各个 FIFO 写 count 条消息，每条之间间隔 100 微秒
+static void producer(int id, int nfifo, int count) {
+    int fds[MAX_FIFOS];
+    char path[64];
+    for (int i = 0; i < nfifo; ++i) {
+        fifo_path(path, sizeof(path), i);
+        fds[i] = open(path, O_WRONLY);
+        if (fds[i] == -1) {
+            perror("生产者打开FIFO");
+            _exit(1);
+        }
+    }
+    for (int seq = 0; seq < count; ++seq) {
+        struct message msg = {now_ns(), (uint32_t)id, (uint32_t)seq};
+        write(fds[(id + seq) % nfifo], &msg, sizeof(msg));
+        usleep(100);
+    }
+    _exit(0);
+}
+
+struct reader_state {
+    int latency_mode;
+    int quit;
+    uint64_t hist[HIST_BUCKETS];
+    uint64_t received;
+    uint64_t max_ns;
+};
+
+// 读到一块数据
+static void on_data(int index, const char* data, size_t len, void* arg) {
+    struct reader_state* st = arg;
+    (void)index;
+    if (len == 0)
+        return;
+
+    if (!st->latency_mode) {
+        // 假设取到Q的时候退出
+        if (data[0] == 'Q') {
+            st->quit = 1;
+            return;
+        }
+        printf("从FIFO读取的数据为：%.*s", (int)len, data);
+        if (data[len - 1] != '\n')
+            printf("\n");
+        return;
+    }
+
+    // 缓冲区是消息大小的整数倍，每次读到的都是完整消息
+    uint64_t now = now_ns();
+    for (size_t m = 0; m < len / sizeof(struct message); ++m) {
+        struct message msg;
+        memcpy(&msg, data + m * sizeof(msg), sizeof(msg));
+        uint64_t lat = now - msg.send_ns;
+        int b = lat ? 64 - __builtin_clzll(lat) : 0;
+        ++st->hist[b < HIST_BUCKETS ? b : HIST_BUCKETS - 1];
+        if (lat > st->max_ns)
+            st->max_ns = lat;
+    }
+    st->received += len / sizeof(struct message);
+}
+
+// 打印 log2 直方图以及 p50 / p99 / max
+static void print_histogram(const uint64_t* hist, uint64_t total,
+                            uint64_t max_ns) {
+    uint64_t p50 = 0, p99 = 0, seen = 0;
+    printf("%20s %10s\n", "latency(ns)", "count");
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+        if (hist[b] == 0)
+            continue;
+        seen += hist[b];
+        if (p50 == 0 && seen * 2 >= total)
+            p50 = 1ULL << b;
+        if (p99 == 0 && seen * 100 >= total * 99)
+            p99 = 1ULL << b;
+        printf("%9llu - %-9llu %10llu\n", b ? 1ULL << (b - 1) : 0ULL,
+               1ULL << b, (unsigned long long)hist[b]);
+    }
+    printf("messages %llu, p50 < %llu ns, p99 < %llu ns, max %llu ns\n",
+           (unsigned long long)total, (unsigned long long)p50,
+           (unsigned long long)p99, (unsigned long long)max_ns);
+}
 
-// 本程序从一个FIFO读数据，并把读到的数据打印到标准输出
-// 如果读到字符“Q”，则退出
 int main(int argc, char** argv) {
-    char buf_r[100];
-    int fd;
-    int nread;
-    if ((mkfifo(FIFO, O_CREAT) < 0) && (errno != EEXIST)) {
-        printf("不能创建FIFO\n");
+    int nfifo = 1;
+    int producers = 0;
+    int count = 100;
+    enum uring_backend backend = URING_EPOLL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:c:u")) != -1) {
+        switch (opt) {
+        case 'n':
+            nfifo = atoi(optarg);
+            break;
+        case 'l':
+            producers = atoi(optarg);
+            break;
+        case 'c':
+            count = atoi(optarg);
+            break;
+        case 'u':
+            backend = URING_MULTISHOT;
+            break;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-n fifos] [-l producers] [-c count] [-u]\n",
+                    argv[0]);
+            exit(1);
+        }
+    }
+    if (nfifo < 1 || nfifo > MAX_FIFOS) {
+        fprintf(stderr, "FIFO 数量必须在 1 到 %d 之间\n", MAX_FIFOS);
         exit(1);
     }
 
-    printf("准备读取数据\n");
-    fd = open(FIFO, O_RDONLY, 0);
-    if (fd == -1) {
-        perror("打开FIFO");
+    static int fds[MAX_FIFOS];
+    char path[64];
+    for (int i = 0; i < nfifo; ++i) {
+        fifo_path(path, sizeof(path), i);
+        if ((mkfifo(path, 0666) < 0) && (errno != EEXIST)) {
+            printf("不能创建FIFO %s\n", path);
+            exit(1);
+        }
+
+        // O_NONBLOCK 让 open 不必等待写者；之后由 uring_reader 决定是否保留
+        fds[i] = open(path, O_RDONLY | O_NONBLOCK);
+        if (fds[i] == -1 || open(path, O_WRONLY) == -1) {
+            perror("打开FIFO");
+            exit(1);
+        }
+    }
+
+    struct uring_reader reader;
+    if (uring_reader_init(&reader, fds, nfifo, backend, 0) == -1) {
+        perror("uring_reader_init");
         exit(1);
     }
 
-    while (1) {
-        if ((nread = read(fd, buf_r, 100)) == -1) {
-            if (errno == EAGAIN)
-                printf("没有数据\n");
+    for (int i = 0; i < producers; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(1);
         }
+        if (pid == 0)
+            producer(i, nfifo, count);
+    }
 
-        //假设取到Q的时候退出
-        if (buf_r[0] == 'Q')
-            break;
+    printf("准备读取数据（%s）\n", uring_backend_name(reader.backend));
+    static struct reader_state st;
+    st.latency_mode = producers > 0;
+    uint64_t expected = (uint64_t)producers * count;
+
+    while (!st.quit) {
+        if (uring_reader_poll(&reader, on_data, &st) == -1) {
+            perror("uring_reader_poll");
+            exit(1);
+        }
+        if (producers > 0 && st.received >= expected)
+            st.quit = 1;
+    }
+    uring_reader_destroy(&reader);
 
-        buf_r[nread] = 0;
-        printf("从FIFO读取的数据为：%s\n", buf_r);
-        sleep(1);
+    if (producers > 0) {
+        while (wait(NULL) > 0)
+            ;
+        print_histogram(st.hist, st.received, st.max_ns);
     }
-}
\ No newline at end of file
+    return 0;
+}
@@ -0,0 +1,152 @@
+/***
+ * @brief 管道批量传输 read/write、vmsplice、splice
+ * @include fcntl.h
+ * @ref ssize_t vmsplice(int fd, const struct iovec* iov, size_t nr_segs,
+ *                       unsigned int flags);
+ * @ref ssize_t splice(int fd_in, off64_t* off_in, int fd_out,
+ *                     off64_t* off_out, size_t len, unsigned int flags);
+ *
+ * @details
+ * 写端：
+ * PIPE_WRITE     write() 把用户缓冲区拷贝进管道，每次最多 chunk 字节。
+ * PIPE_VMSPLICE  vmsplice() 把用户页直接挂到管道上，不拷贝。
+ *                读端读完之前，这段内存不能修改或释放。
+ * 读端：
+ * PIPE_READ      read() 到 chunk 大小的缓冲区，再 write() 到输出 fd。
+ * PIPE_SPLICE    splice() 从管道直接送到输出 fd，数据不经过用户态。
+ *                输出 fd 不支持 splice 时（例如终端）自动退回 PIPE_READ。
+ *
+ * 管道默认只有 64 KB，pipe_grow() 用 F_SETPIPE_SZ 扩大它，
+ * 非特权进程最大为 /proc/sys/fs/pipe-max-size。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/vmsplice.2.html
+ * https://man7.org/linux/man-pages/man2/splice.2.html
+ */
+#pragma once
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>  // errno
+#include <fcntl.h>  // splice, vmsplice, F_SETPIPE_SZ
+#include <stdlib.h> // malloc
+#include <sys/uio.h>
+#include <unistd.h> // read, write
+
+#define PIPE_DEFAULT_CHUNK (64 * 1024)
+
+enum pipe_write_mode {
+    PIPE_WRITE,
+    PIPE_VMSPLICE
+};
+
+enum pipe_read_mode {
+    PIPE_READ,
+    PIPE_SPLICE
+};
+
+// 把管道容量调整为 size 字节，返回实际容量，失败返回 -1
+static inline int pipe_grow(int fd, int size) {
+    if (fcntl(fd, F_SETPIPE_SZ, size) == -1)
+        return -1;
+    return fcntl(fd, F_GETPIPE_SZ);
+}
+
+// 把 buf 中的 len 字节全部写到 fd，成功返回 0，失败返回 -1
+static inline int write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * @brief 把 buf 的 len 字节送进管道写端 pipe_wr
+ * @param chunk 每次系统调用最多传输的字节数，0 表示 PIPE_DEFAULT_CHUNK
+ * @return 成功，0；失败，-1
+ */
+static inline int pipe_send(int pipe_wr, const void* buf, size_t len,
+                            enum pipe_write_mode mode, size_t chunk) {
+    const char* p = (const char*)buf;
+    if (chunk == 0)
+        chunk = PIPE_DEFAULT_CHUNK;
+
+    while (len > 0) {
+        size_t n = len < chunk ? len : chunk;
+        ssize_t done;
+        if (mode == PIPE_VMSPLICE) {
+            struct iovec iov = {(void*)p, n};
+            done = vmsplice(pipe_wr, &iov, 1, 0);
+        } else {
+            done = write(pipe_wr, p, n);
+        }
+        if (done == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += done;
+        len -= done;
+    }
+    return 0;
+}
+
+/**
+ * @brief 把管道读端 pipe_rd 中的数据全部转到 out_fd，直到读到 EOF
+ * @param chunk 每次系统调用最多传输的字节数，0 表示 PIPE_DEFAULT_CHUNK
+ * @return 传输的总字节数，失败返回 -1
+ */
+static inline ssize_t pipe_drain(int pipe_rd, int out_fd,
+                                 enum pipe_read_mode mode, size_t chunk) {
+    ssize_t total = 0;
+    if (chunk == 0)
+        chunk = PIPE_DEFAULT_CHUNK;
+
+    if (mode == PIPE_SPLICE) {
+        for (;;) {
+            ssize_t n = splice(pipe_rd, NULL, out_fd, NULL, chunk,
+                               SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n == 0)
+                return total;
+            if (n == -1) {
+                if (errno == EINTR)
+                    continue;
+                // 输出端不支持 splice，改用 read/write 搬运
+                if (errno == EINVAL && total == 0)
+                    break;
+                return -1;
+            }
+            total += n;
+        }
+    }
+
+    char* buf = (char*)malloc(chunk);
+    if (buf == NULL)
+        return -1;
+    for (;;) {
+        ssize_t n = read(pipe_rd, buf, chunk);
+        if (n == 0)
+            break;
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            total = -1;
+            break;
+        }
+        if (write_all(out_fd, buf, n) == -1) {
+            total = -1;
+            break;
+        }
+        total += n;
+    }
+    free(buf);
+    return total;
+}
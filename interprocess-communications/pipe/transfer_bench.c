@@ -0,0 +1,107 @@
+/***
+ * @brief 比较 ./transfer.h 中各种管道传输方式的吞吐量
+ * @details
+ * 父进程 → 管道 → 子进程 → /dev/null，
+ * 负载从 1 KB 增长到 max_payload（默认 1 GB），每次乘 4，最后一轮总是 max_payload。
+ * 小负载重复发送，使每一轮至少传输 256 MB，减少 fork 开销的影响。
+ * 组合：write/vmsplice（写端） × read/splice（读端）。
+ *
+ * @note
+ * gcc interprocess-communications/pipe/transfer_bench.c -o out/a.out -O2
+ * out/a.out [max_payload_mb=1024] [chunk_kb=64] [pipe_kb=1024]
+ */
+
+#include "transfer.h"
+#include <fcntl.h>    // open
+#include <stdio.h>    // printf
+#include <stdlib.h>   // exit
+#include <string.h>   // memset
+#include <sys/mman.h> // mmap
+#include <sys/wait.h> // waitpid
+#include <time.h>     // clock_gettime
+#include <unistd.h>   // fork
+
+#define MIN_ROUND_BYTES (256UL << 20)
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 一轮测试：发送 reps 次 payload，返回 GB/s
+static double run(const char* payload, size_t len, size_t reps,
+                  enum pipe_write_mode wmode, enum pipe_read_mode rmode,
+                  size_t chunk, int pipe_size) {
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pipe_grow(pipefd[1], pipe_size);
+
+    double begin = now_sec();
+    pid_t cpid = fork();
+    if (cpid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (cpid == 0) {
+        close(pipefd[1]);
+        int null_fd = open("/dev/null", O_WRONLY);
+        ssize_t n = pipe_drain(pipefd[0], null_fd, rmode, chunk);
+        _exit(n == (ssize_t)(len * reps) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(pipefd[0]);
+    for (size_t i = 0; i < reps; ++i) {
+        if (pipe_send(pipefd[1], payload, len, wmode, chunk) == -1) {
+            perror("pipe_send");
+            exit(EXIT_FAILURE);
+        }
+    }
+    close(pipefd[1]);
+
+    int status;
+    waitpid(cpid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "child lost data\n");
+        exit(EXIT_FAILURE);
+    }
+    return len * reps / (now_sec() - begin) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    size_t max_payload = (argc > 1 ? strtoul(argv[1], NULL, 10) : 1024) << 20;
+    size_t chunk = (argc > 2 ? strtoul(argv[2], NULL, 10) : 64) << 10;
+    int pipe_size = (argc > 3 ? atoi(argv[3]) : 1024) << 10;
+
+    // vmsplice 要求发送期间缓冲区不变，这里整个测试只写一次
+    char* payload = mmap(NULL, max_payload, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (payload == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    memset(payload, 'x', max_payload);
+
+    printf("chunk %zu KB, pipe size %d KB\n", chunk >> 10, pipe_size >> 10);
+    printf("%12s %14s %14s %14s %14s\n", "payload", "write+read",
+           "write+splice", "vmsplice+read", "vmsplice+splc");
+    for (size_t len = 1024; len <= max_payload;
+         len = len < max_payload && len * 4 > max_payload ? max_payload
+                                                          : len * 4) {
+        size_t reps = len < MIN_ROUND_BYTES ? MIN_ROUND_BYTES / len : 1;
+        printf("%10zuKB", len >> 10);
+        printf(" %14.2f", run(payload, len, reps, PIPE_WRITE, PIPE_READ, chunk,
+                              pipe_size));
+        printf(" %14.2f", run(payload, len, reps, PIPE_WRITE, PIPE_SPLICE,
+                              chunk, pipe_size));
+        printf(" %14.2f", run(payload, len, reps, PIPE_VMSPLICE, PIPE_READ,
+                              chunk, pipe_size));
+        printf(" %14.2f", run(payload, len, reps, PIPE_VMSPLICE, PIPE_SPLICE,
+                              chunk, pipe_size));
+        printf("  GB/s\n");
+    }
+    return 0;
+}
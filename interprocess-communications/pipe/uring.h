@@ -0,0 +1,624 @@
+/***
+ * @brief 管道 / FIFO 的 io_uring 读写引擎（不依赖 liburing）
+ * @include linux/io_uring.h
+ * @ref int io_uring_setup(u32 entries, struct io_uring_params* p);
+ * @ref int io_uring_enter(unsigned int fd, u32 to_submit, u32 min_complete,
+ *                         u32 flags, const void* arg, size_t argsz);
+ * @ref int io_uring_register(unsigned int fd, unsigned int opcode,
+ *                            void* arg, unsigned int nr_args);
+ *
+ * @details
+ * ./first.c、./second.c 每次传输都是一次 read() / write() 系统调用。
+ * io_uring 把请求（SQE）和完成（CQE）放在与内核共享的两个环形队列里，
+ * 一次 io_uring_enter() 可以提交任意多个请求并等待完成。
+ *
+ * 读端 struct uring_reader，同时读多个管道 / FIFO，三种后端：
+ * URING_MULTISHOT  每个 fd 只提交一次 IORING_OP_READ_MULTISHOT（Linux 6.7+），
+ *                  数据到达就产生一个 CQE，缓冲区从“提供缓冲区环”中取，
+ *                  回调处理完后放回环中，不需要重新提交。
+ * URING_FIXED      每个 fd 一个 IORING_OP_READ_FIXED，缓冲区预先注册
+ *                  （io_uring_register(IORING_REGISTER_BUFFERS)），
+ *                  内核不必每次都 pin 用户页；完成后重新提交的请求攒到
+ *                  下一次 io_uring_enter() 一起提交，同时等待新的完成。
+ * URING_EPOLL      退回 ./second.c 的做法：O_NONBLOCK + epoll 边沿触发 + read()。
+ * uring_reader_init() 按 MULTISHOT → FIXED → EPOLL 的顺序退回到内核支持的后端。
+ *
+ * 写端 struct uring_writer：消息先复制到已注册的缓冲区槽位，
+ * 攒满后用 IOSQE_IO_LINK 串成一条链（保证按顺序写入），一次 io_uring_enter() 提交。
+ * 每条消息仍是一次独立的写，长度不超过 PIPE_BUF 时对多写者是原子的。
+ * io_uring 不可用时退回每条消息一次 write()。
+ *
+ * URING_SQPOLL：由内核线程轮询提交队列，提交本身不需要系统调用，
+ * 只有内核线程空闲睡眠后才需要 IORING_ENTER_SQ_WAKEUP 唤醒；
+ * 等待完成仍然要 io_uring_enter(IORING_ENTER_GETEVENTS)。
+ *
+ * syscalls 字段统计引擎发出的系统调用次数（io_uring_enter / epoll_wait / read / write）。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man7/io_uring.7.html
+ * https://kernel.dk/io_uring.pdf
+ */
+#pragma once
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// 系统头文件比内核旧时没有这个操作码
+#define URING_OP_READ_MULTISHOT 49
+
+#define URING_BUF_SIZE (16 * 1024)
+#define URING_PBUF_COUNT 64 /* 提供缓冲区环的大小，2 的幂 */
+#define URING_SQPOLL 1      /* uring_reader_init / uring_writer_init 的 flags */
+
+enum uring_backend {
+    URING_EPOLL,
+    URING_FIXED,
+    URING_MULTISHOT
+};
+
+struct uring {
+    int fd;
+    unsigned setup_flags;
+    unsigned sq_entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+    unsigned sqe_tail; // 已填写、尚未发布给内核的位置
+    unsigned submitted; // 已发布给内核的位置
+    struct io_uring_sqe* sqes;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe* cqes;
+    void* ring_ptr;
+    size_t ring_len;
+    size_t sqes_len;
+    long syscalls;
+};
+
+static inline const char* uring_backend_name(enum uring_backend b) {
+    switch (b) {
+    case URING_EPOLL:
+        return "epoll";
+    case URING_FIXED:
+        return "uring_fixed";
+    case URING_MULTISHOT:
+        return "uring_multishot";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 创建 io_uring 并映射提交、完成队列
+ * @param flags 可以为 URING_SQPOLL
+ * @return 成功，0；失败，-1，errno 为 io_uring_setup 的错误
+ */
+static inline int uring_init(struct uring* u, unsigned entries,
+                             unsigned flags) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    if (flags & URING_SQPOLL) {
+        p.flags |= IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = 100; // 毫秒
+    }
+    u->fd = (int)syscall(SYS_io_uring_setup, entries, &p);
+    if (u->fd == -1)
+        return -1;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        close(u->fd);
+        errno = ENOSYS;
+        return -1;
+    }
+    u->setup_flags = p.flags;
+    u->sq_entries = p.sq_entries;
+
+    // 提交队列和完成队列共用一次 mmap（IORING_FEAT_SINGLE_MMAP）
+    size_t sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    u->ring_len = sq_len > cq_len ? sq_len : cq_len;
+    u->ring_ptr = mmap(NULL, u->ring_len, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->ring_ptr == MAP_FAILED) {
+        close(u->fd);
+        return -1;
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = (struct io_uring_sqe*)mmap(NULL, u->sqes_len,
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE, u->fd,
+                                         IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        munmap(u->ring_ptr, u->ring_len);
+        close(u->fd);
+        return -1;
+    }
+
+    char* ring = (char*)u->ring_ptr;
+    u->sq_head = (unsigned*)(ring + p.sq_off.head);
+    u->sq_tail = (unsigned*)(ring + p.sq_off.tail);
+    u->sq_mask = (unsigned*)(ring + p.sq_off.ring_mask);
+    u->sq_flags = (unsigned*)(ring + p.sq_off.flags);
+    u->sq_array = (unsigned*)(ring + p.sq_off.array);
+    u->cq_head = (unsigned*)(ring + p.cq_off.head);
+    u->cq_tail = (unsigned*)(ring + p.cq_off.tail);
+    u->cq_mask = (unsigned*)(ring + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+    // SQE 下标与提交队列位置一一对应
+    for (unsigned i = 0; i < p.sq_entries; ++i)
+        u->sq_array[i] = i;
+    u->sqe_tail = u->submitted = *u->sq_tail;
+    return 0;
+}
+
+static inline void uring_exit(struct uring* u) {
+    munmap(u->sqes, u->sqes_len);
+    munmap(u->ring_ptr, u->ring_len);
+    close(u->fd);
+}
+
+// 取一个空闲的 SQE 并清零，队列满时返回 NULL
+static inline struct io_uring_sqe* uring_get_sqe(struct uring* u) {
+    unsigned head = __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+    if (u->sqe_tail - head >= u->sq_entries)
+        return NULL;
+    struct io_uring_sqe* sqe = &u->sqes[u->sqe_tail & *u->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    ++u->sqe_tail;
+    return sqe;
+}
+
+/**
+ * @brief 把填好的 SQE 一次性交给内核，并可选地等待 wait_nr 个完成
+ * @details SQPOLL 模式下不需要等待时，只在内核线程睡眠时才进入内核
+ * @return 成功，0；失败，-1
+ */
+static inline int uring_submit(struct uring* u, unsigned wait_nr) {
+    unsigned to_submit = u->sqe_tail - u->submitted;
+    __atomic_store_n(u->sq_tail, u->sqe_tail, __ATOMIC_RELEASE);
+    u->submitted = u->sqe_tail;
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (u->setup_flags & IORING_SETUP_SQPOLL) {
+        // 发布 tail 与读取 NEED_WAKEUP 之间需要完整的内存屏障
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(u->sq_flags, __ATOMIC_RELAXED) &
+            IORING_SQ_NEED_WAKEUP)
+            flags |= IORING_ENTER_SQ_WAKEUP;
+        to_submit = 0;
+        if (flags == 0)
+            return 0;
+    } else if (to_submit == 0 && wait_nr == 0) {
+        return 0;
+    }
+
+    for (;;) {
+        ++u->syscalls;
+        if (syscall(SYS_io_uring_enter, u->fd, to_submit, wait_nr, flags,
+                    NULL, 0) != -1)
+            return 0;
+        if (errno != EINTR)
+            return -1;
+        to_submit = 0; // 被信号打断时内核已经取走了 SQE
+    }
+}
+
+// 取出下一个 CQE，没有时返回 NULL；处理完后调用 uring_cqe_seen()
+static inline struct io_uring_cqe* uring_peek_cqe(struct uring* u) {
+    unsigned head = *u->cq_head;
+    if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &u->cqes[head & *u->cq_mask];
+}
+
+static inline void uring_cqe_seen(struct uring* u) {
+    __atomic_store_n(u->cq_head, *u->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+static inline int uring_register(struct uring* u, unsigned opcode, void* arg,
+                                 unsigned nr_args) {
+    ++u->syscalls;
+    return (int)syscall(SYS_io_uring_register, u->fd, opcode, arg, nr_args);
+}
+
+// 内核是否支持操作码 op
+static inline int uring_op_supported(struct uring* u, int op) {
+    size_t len = sizeof(struct io_uring_probe) +
+                 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = (struct io_uring_probe*)calloc(1, len);
+    int ok = probe != NULL &&
+             uring_register(u, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+             op <= probe->last_op &&
+             (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok;
+}
+
+static inline void uring_set_nonblock(int fd, int nonblock) {
+    int fl = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, nonblock ? fl | O_NONBLOCK : fl & ~O_NONBLOCK);
+}
+
+/* ------------------------------ 读端 ------------------------------ */
+
+// len 为 0 表示 fds[index] 的所有写端都已关闭
+typedef void (*uring_read_fn)(int index, const char* data, size_t len,
+                              void* arg);
+
+struct uring_reader {
+    enum uring_backend backend;
+    int nfds;
+    int open_fds;
+    const int* fds;
+    char* bufs;
+    struct uring ring;
+    struct io_uring_buf_ring* pbuf; // URING_MULTISHOT
+    unsigned short pbuf_tail;
+    int epfd; // URING_EPOLL
+    long syscalls;
+};
+
+static inline int uring_reader_arm(struct uring_reader* r, int index) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&r->ring);
+    if (sqe == NULL) {
+        errno = EBUSY;
+        return -1;
+    }
+    sqe->fd = r->fds[index];
+    sqe->off = (uint64_t)-1; // 管道没有文件偏移
+    sqe->user_data = (uint64_t)index;
+    if (r->backend == URING_MULTISHOT) {
+        sqe->opcode = URING_OP_READ_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = 0;
+    } else {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)(r->bufs + (size_t)index * URING_BUF_SIZE);
+        sqe->len = URING_BUF_SIZE;
+        sqe->buf_index = (uint16_t)index;
+    }
+    return 0;
+}
+
+// 把提供缓冲区 bid 放回环中
+static inline void uring_reader_recycle(struct uring_reader* r, unsigned bid) {
+    struct io_uring_buf* buf =
+        &r->pbuf->bufs[r->pbuf_tail & (URING_PBUF_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(r->bufs + (size_t)bid * URING_BUF_SIZE);
+    buf->len = URING_BUF_SIZE;
+    buf->bid = (uint16_t)bid;
+    ++r->pbuf_tail;
+    __atomic_store_n(&r->pbuf->tail, r->pbuf_tail, __ATOMIC_RELEASE);
+}
+
+static inline int uring_reader_setup_multishot(struct uring_reader* r) {
+    if (!uring_op_supported(&r->ring, URING_OP_READ_MULTISHOT))
+        return -1;
+    size_t ring_len = URING_PBUF_COUNT * sizeof(struct io_uring_buf);
+    void* ring = mmap(NULL, ring_len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED)
+        return -1;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = URING_PBUF_COUNT;
+    reg.bgid = 0;
+    r->bufs = (char*)malloc((size_t)URING_PBUF_COUNT * URING_BUF_SIZE);
+    if (r->bufs == NULL ||
+        uring_register(&r->ring, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+        free(r->bufs);
+        r->bufs = NULL;
+        munmap(ring, ring_len);
+        return -1;
+    }
+    r->pbuf = (struct io_uring_buf_ring*)ring;
+    r->pbuf_tail = 0;
+    for (unsigned i = 0; i < URING_PBUF_COUNT; ++i)
+        uring_reader_recycle(r, i);
+    return 0;
+}
+
+static inline int uring_reader_setup_fixed(struct uring_reader* r) {
+    r->bufs = (char*)malloc((size_t)r->nfds * URING_BUF_SIZE);
+    struct iovec* iov = (struct iovec*)malloc(r->nfds * sizeof(struct iovec));
+    int ret = -1;
+    if (r->bufs != NULL && iov != NULL) {
+        for (int i = 0; i < r->nfds; ++i) {
+            iov[i].iov_base = r->bufs + (size_t)i * URING_BUF_SIZE;
+            iov[i].iov_len = URING_BUF_SIZE;
+        }
+        ret = uring_register(&r->ring, IORING_REGISTER_BUFFERS, iov,
+                             (unsigned)r->nfds);
+    }
+    free(iov);
+    if (ret == -1) {
+        free(r->bufs);
+        r->bufs = NULL;
+    }
+    return ret;
+}
+
+static inline int uring_reader_setup_epoll(struct uring_reader* r) {
+    r->backend = URING_EPOLL;
+    r->bufs = (char*)malloc(URING_BUF_SIZE);
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (r->bufs == NULL || r->epfd == -1)
+        return -1;
+    for (int i = 0; i < r->nfds; ++i) {
+        uring_set_nonblock(r->fds[i], 1);
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.u64 = (uint64_t)i;
+        if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->fds[i], &ev) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 准备读取 fds 中的管道 / FIFO
+ * @param want 希望使用的后端，内核不支持时依次退回
+ * @param flags 可以为 URING_SQPOLL
+ * @return 成功，0，实际使用的后端见 r->backend；失败，-1
+ */
+static inline int uring_reader_init(struct uring_reader* r, const int* fds,
+                                    int nfds, enum uring_backend want,
+                                    unsigned flags) {
+    memset(r, 0, sizeof(*r));
+    r->fds = fds;
+    r->nfds = nfds;
+    r->open_fds = nfds;
+    r->epfd = -1;
+    r->backend = want;
+
+    if (want != URING_EPOLL &&
+        uring_init(&r->ring, (unsigned)(nfds < 64 ? 64 : nfds), flags) == 0) {
+        if (r->backend == URING_MULTISHOT &&
+            uring_reader_setup_multishot(r) == -1)
+            r->backend = URING_FIXED;
+        if (r->backend == URING_FIXED && uring_reader_setup_fixed(r) == -1) {
+            uring_exit(&r->ring);
+            r->backend = URING_EPOLL;
+        }
+    } else {
+        r->backend = URING_EPOLL;
+    }
+    if (r->backend == URING_EPOLL)
+        return uring_reader_setup_epoll(r);
+
+    for (int i = 0; i < nfds; ++i) {
+        // 阻塞的 fd 由 io_uring 自己等待数据，O_NONBLOCK 会让请求直接返回 EAGAIN
+        uring_set_nonblock(fds[i], 0);
+        if (uring_reader_arm(r, i) == -1)
+            return -1;
+    }
+    return uring_submit(&r->ring, 0);
+}
+
+static inline void uring_reader_destroy(struct uring_reader* r) {
+    if (r->backend == URING_EPOLL) {
+        if (r->epfd != -1)
+            close(r->epfd);
+    } else {
+        uring_exit(&r->ring);
+    }
+    if (r->pbuf != NULL)
+        munmap(r->pbuf, URING_PBUF_COUNT * sizeof(struct io_uring_buf));
+    free(r->bufs);
+}
+
+static inline int uring_reader_poll_epoll(struct uring_reader* r,
+                                          uring_read_fn fn, void* arg) {
+    struct epoll_event events[64];
+    int delivered = 0;
+    while (delivered == 0 && r->open_fds > 0) {
+        ++r->syscalls;
+        int n = epoll_wait(r->epfd, events, 64, -1);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        for (int i = 0; i < n; ++i) {
+            int index = (int)events[i].data.u64;
+            // 边沿触发：必须读到 EAGAIN 为止
+            for (;;) {
+                ++r->syscalls;
+                ssize_t nread = read(r->fds[index], r->bufs, URING_BUF_SIZE);
+                if (nread == -1) {
+                    if (errno == EINTR)
+                        continue;
+                    if (errno == EAGAIN)
+                        break;
+                    return -1;
+                }
+                fn(index, r->bufs, (size_t)nread, arg);
+                ++delivered;
+                if (nread == 0) {
+                    epoll_ctl(r->epfd, EPOLL_CTL_DEL, r->fds[index], NULL);
+                    --r->open_fds;
+                    break;
+                }
+            }
+        }
+    }
+    return delivered;
+}
+
+/**
+ * @brief 等待数据并对读到的每一块调用 fn
+ * @return 回调次数；所有 fd 都已 EOF 时返回 0；失败返回 -1
+ */
+static inline int uring_reader_poll(struct uring_reader* r, uring_read_fn fn,
+                                    void* arg) {
+    if (r->backend == URING_EPOLL)
+        return uring_reader_poll_epoll(r, fn, arg);
+
+    int delivered = 0;
+    while (delivered == 0 && r->open_fds > 0) {
+        // 提交上一轮重新挂上的读请求，CQ 为空时同时等待至少一个完成
+        long before = r->ring.syscalls;
+        unsigned wait_nr = uring_peek_cqe(&r->ring) == NULL ? 1 : 0;
+        if (uring_submit(&r->ring, wait_nr) == -1)
+            return -1;
+        r->syscalls += r->ring.syscalls - before;
+
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(&r->ring)) != NULL) {
+            int index = (int)cqe->user_data;
+            int res = cqe->res;
+            unsigned cflags = cqe->flags;
+            uring_cqe_seen(&r->ring);
+
+            if (res > 0) {
+                if (cflags & IORING_CQE_F_BUFFER) {
+                    unsigned bid = cflags >> IORING_CQE_BUFFER_SHIFT;
+                    fn(index, r->bufs + (size_t)bid * URING_BUF_SIZE,
+                       (size_t)res, arg);
+                    uring_reader_recycle(r, bid);
+                } else {
+                    fn(index, r->bufs + (size_t)index * URING_BUF_SIZE,
+                       (size_t)res, arg);
+                }
+                ++delivered;
+            } else if (res == 0) {
+                fn(index, NULL, 0, arg);
+                ++delivered;
+                --r->open_fds;
+                continue;
+            } else if (res != -EINTR && res != -EAGAIN && res != -ENOBUFS) {
+                errno = -res;
+                return -1;
+            }
+            // 单次读取每次都要重新提交；多次读取只在内核结束它时重新提交
+            if ((r->backend == URING_FIXED || !(cflags & IORING_CQE_F_MORE)) &&
+                uring_reader_arm(r, index) == -1)
+                return -1;
+        }
+    }
+    return delivered;
+}
+
+/* ------------------------------ 写端 ------------------------------ */
+
+struct uring_writer {
+    int fd;
+    int use_uring;
+    unsigned slots;     // 一批最多几条消息
+    unsigned used;      // 当前批次的消息数
+    size_t slot_size;
+    size_t* lens;
+    char* bufs;
+    struct uring ring;
+    long syscalls;
+};
+
+/**
+ * @brief 准备向 fd 写消息，每条最多 slot_size 字节，每 slots 条提交一次
+ * @param flags 可以为 URING_SQPOLL；io_uring 不可用时退回 write()
+ * @return 成功，0；失败，-1
+ */
+static inline int uring_writer_init(struct uring_writer* w, int fd,
+                                    unsigned slots, size_t slot_size,
+                                    unsigned flags) {
+    memset(w, 0, sizeof(w[0]));
+    w->fd = fd;
+    w->slots = slots;
+    w->slot_size = slot_size;
+    w->bufs = (char*)malloc(slots * slot_size);
+    w->lens = (size_t*)malloc(slots * sizeof(size_t));
+    if (w->bufs == NULL || w->lens == NULL)
+        return -1;
+    if (uring_init(&w->ring, slots, flags) == 0) {
+        struct iovec iov = {w->bufs, slots * slot_size};
+        if (uring_register(&w->ring, IORING_REGISTER_BUFFERS, &iov, 1) == 0)
+            w->use_uring = 1;
+        else
+            uring_exit(&w->ring);
+    }
+    uring_set_nonblock(fd, 0);
+    return 0;
+}
+
+// 提交当前批次并等待全部写完，成功返回 0，失败返回 -1
+static inline int uring_writer_flush(struct uring_writer* w) {
+    if (w->used == 0)
+        return 0;
+    unsigned count = w->used;
+    w->used = 0;
+    if (!w->use_uring)
+        return 0;
+
+    for (unsigned i = 0; i < count; ++i) {
+        struct io_uring_sqe* sqe = uring_get_sqe(&w->ring);
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = w->fd;
+        sqe->off = (uint64_t)-1;
+        sqe->addr = (uint64_t)(uintptr_t)(w->bufs + i * w->slot_size);
+        sqe->len = (unsigned)w->lens[i];
+        sqe->buf_index = 0;
+        sqe->user_data = i;
+        if (i + 1 < count)
+            sqe->flags = IOSQE_IO_LINK;
+    }
+    long before = w->ring.syscalls;
+    int failed = 0;
+    unsigned done = 0;
+    while (done < count) {
+        if (uring_submit(&w->ring, count - done) == -1)
+            return -1;
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(&w->ring)) != NULL) {
+            if (cqe->res < 0 && !failed) {
+                errno = -cqe->res;
+                failed = 1;
+            }
+            uring_cqe_seen(&w->ring);
+            ++done;
+        }
+    }
+    w->syscalls += w->ring.syscalls - before;
+    return failed ? -1 : 0;
+}
+
+/**
+ * @brief 写一条消息（len 不超过 slot_size）
+ * @details io_uring 不可用时直接 write()，否则攒满一批再提交
+ * @return 成功，0；失败，-1
+ */
+static inline int uring_writer_write(struct uring_writer* w, const void* data,
+                                     size_t len) {
+    if (len > w->slot_size) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (!w->use_uring) {
+        for (;;) {
+            ++w->syscalls;
+            if (write(w->fd, data, len) != -1)
+                return 0;
+            if (errno != EINTR)
+                return -1;
+        }
+    }
+    memcpy(w->bufs + w->used * w->slot_size, data, len);
+    w->lens[w->used++] = len;
+    return w->used == w->slots ? uring_writer_flush(w) : 0;
+}
+
+static inline void uring_writer_destroy(struct uring_writer* w) {
+    uring_writer_flush(w);
+    if (w->use_uring)
+        uring_exit(&w->ring);
+    free(w->bufs);
+    free(w->lens);
+}
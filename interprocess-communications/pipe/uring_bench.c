@@ -0,0 +1,253 @@
+/***
+ * @brief 比较 ./uring.h 的各个后端与阻塞 read / write 的吞吐量和系统调用次数
+ * @details
+ * pipes 个管道，每个管道一个写者子进程，各写 messages 条 size 字节的消息；
+ * 父进程用 uring_reader 同时读所有管道，直到全部 EOF，并核对收到的字节数。
+ *
+ * 读端：epoll（./second.c 的做法）、uring_fixed、uring_multishot，
+ *      以及基准 read：每个管道一个子进程，阻塞 read() 直到 EOF（每次最多 URING_BUF_SIZE 字节）
+ * 写端：write（./first.c 的做法，一条消息一次 write()）、uring（批量提交）
+ *
+ * 报告每秒消息数，以及读端、写端平均每条消息的系统调用次数。
+ * sqpoll 为 1 时 io_uring 使用 SQPOLL（需要额外的内核线程，单核上通常更慢）。
+ *
+ * @note
+ * gcc interprocess-communications/pipe/uring_bench.c -o out/a.out -O2 -lm
+ * out/a.out [pipes=4] [messages=100000] [size=64] [sqpoll=0]
+ */
+
+#include "../../benchmark/bench.h"
+#include "uring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define WRITER_BATCH 64
+
+struct round {
+    int pipes;
+    int messages;
+    size_t size;
+    unsigned flags;
+    enum uring_backend backend; // 读端希望使用的后端
+    int blocking_reader;        // 为 1 时不用 uring_reader，每个管道一个阻塞读的子进程
+    int uring_writer;
+    // 累计值，跨多轮求平均
+    enum uring_backend used;
+    long bytes;
+    long reader_syscalls;
+    long* writer_syscalls; // MAP_SHARED，子进程写入
+    long* reader_shared;   // MAP_SHARED，阻塞读的子进程写入 {系统调用次数, 字节数}
+    long total_messages;
+};
+
+static void writer_main(int fd, const struct round* rd, long* syscalls) {
+    char* msg = malloc(rd->size);
+    memset(msg, 'm', rd->size);
+    if (rd->uring_writer) {
+        struct uring_writer w;
+        if (uring_writer_init(&w, fd, WRITER_BATCH, rd->size, rd->flags) ==
+            -1) {
+            perror("uring_writer_init");
+            _exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < rd->messages; ++i) {
+            if (uring_writer_write(&w, msg, rd->size) == -1) {
+                perror("uring_writer_write");
+                _exit(EXIT_FAILURE);
+            }
+        }
+        if (uring_writer_flush(&w) == -1) {
+            perror("uring_writer_flush");
+            _exit(EXIT_FAILURE);
+        }
+        __atomic_fetch_add(syscalls, w.syscalls, __ATOMIC_RELAXED);
+        uring_writer_destroy(&w);
+    } else {
+        for (int i = 0; i < rd->messages; ++i) {
+            if (write(fd, msg, rd->size) != (ssize_t)rd->size) {
+                perror("write");
+                _exit(EXIT_FAILURE);
+            }
+        }
+        __atomic_fetch_add(syscalls, rd->messages, __ATOMIC_RELAXED);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+static void reader_main(int fd, long* shared) {
+    char* buf = malloc(URING_BUF_SIZE);
+    long syscalls = 0, bytes = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, URING_BUF_SIZE)) > 0) {
+        ++syscalls;
+        bytes += n;
+    }
+    if (n == -1) {
+        perror("read");
+        _exit(EXIT_FAILURE);
+    }
+    ++syscalls; // 读到 EOF 的那一次
+    __atomic_fetch_add(&shared[0], syscalls, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shared[1], bytes, __ATOMIC_RELAXED);
+    _exit(EXIT_SUCCESS);
+}
+
+// 每个管道 fork 一个阻塞读的子进程，等它们全部读到 EOF
+static void read_blocking(int* fds, struct round* rd) {
+    long syscalls = rd->reader_shared[0], bytes = rd->reader_shared[1];
+    for (int i = 0; i < rd->pipes; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            for (int j = 0; j < rd->pipes; ++j) {
+                if (j != i)
+                    close(fds[j]);
+            }
+            reader_main(fds[i], rd->reader_shared);
+        }
+    }
+    for (int i = 0; i < rd->pipes; ++i)
+        close(fds[i]);
+    int status;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "reader or writer failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    rd->reader_syscalls += rd->reader_shared[0] - syscalls;
+    rd->bytes += rd->reader_shared[1] - bytes;
+}
+
+static void on_data(int index, const char* data, size_t len, void* arg) {
+    (void)index;
+    (void)data;
+    struct round* rd = arg;
+    rd->bytes += (long)len;
+}
+
+static void run_round(void* arg) {
+    struct round* rd = arg;
+    int* fds = malloc(rd->pipes * sizeof(int));
+    for (int i = 0; i < rd->pipes; ++i) {
+        int pipefd[2];
+        if (pipe(pipefd) == -1) {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(pipefd[0]);
+            for (int j = 0; j < i; ++j)
+                close(fds[j]);
+            writer_main(pipefd[1], rd, rd->writer_syscalls);
+        }
+        close(pipefd[1]);
+        fds[i] = pipefd[0];
+    }
+
+    long before = rd->bytes;
+    if (rd->blocking_reader) {
+        read_blocking(fds, rd);
+    } else {
+        struct uring_reader r;
+        if (uring_reader_init(&r, fds, rd->pipes, rd->backend, rd->flags) ==
+            -1) {
+            perror("uring_reader_init");
+            exit(EXIT_FAILURE);
+        }
+        rd->used = r.backend;
+        int n;
+        while ((n = uring_reader_poll(&r, on_data, rd)) > 0)
+            ;
+        if (n == -1) {
+            perror("uring_reader_poll");
+            exit(EXIT_FAILURE);
+        }
+        rd->reader_syscalls += r.syscalls;
+        uring_reader_destroy(&r);
+        for (int i = 0; i < rd->pipes; ++i)
+            close(fds[i]);
+        while (wait(NULL) > 0)
+            ;
+    }
+    free(fds);
+
+    long expect = (long)rd->pipes * rd->messages * (long)rd->size;
+    if (rd->bytes - before != expect) {
+        fprintf(stderr, "received %ld bytes, expected %ld\n",
+                rd->bytes - before, expect);
+        exit(EXIT_FAILURE);
+    }
+    rd->total_messages += (long)rd->pipes * rd->messages;
+}
+
+int main(int argc, char* argv[]) {
+    struct round rd = {0};
+    rd.pipes = argc > 1 ? atoi(argv[1]) : 4;
+    rd.messages = argc > 2 ? atoi(argv[2]) : 100000;
+    rd.size = argc > 3 ? strtoul(argv[3], NULL, 10) : 64;
+    rd.flags = argc > 4 && atoi(argv[4]) ? URING_SQPOLL : 0;
+    rd.writer_syscalls = mmap(NULL, 3 * sizeof(long), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (rd.writer_syscalls == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    rd.reader_shared = rd.writer_syscalls + 1;
+
+    bench_init(NULL);
+    const enum uring_backend backends[] = {URING_EPOLL, URING_FIXED,
+                                           URING_MULTISHOT};
+    char lines[8][128];
+    int nlines = 0;
+    // b == 3：阻塞 read() 的基准
+    for (int b = 0; b < 4; ++b) {
+        for (int uw = 0; uw < 2; ++uw) {
+            rd.blocking_reader = b == 3;
+            rd.backend = backends[b % 3];
+            rd.uring_writer = uw;
+            rd.bytes = 0;
+            rd.reader_syscalls = 0;
+            rd.total_messages = 0;
+            *rd.writer_syscalls = 0;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s/%s",
+                     rd.blocking_reader ? "read"
+                                        : uring_backend_name(backends[b]),
+                     uw ? "uring" : "write");
+            struct bench_result r = bench_run(
+                name, run_round, &rd, (double)rd.pipes * rd.messages);
+            bench_report(&r);
+            snprintf(lines[nlines++], sizeof(lines[0]),
+                     "%-16s %-7s %12.0f %14.3f %14.3f",
+                     rd.blocking_reader ? "read" : uring_backend_name(rd.used),
+                     uw ? "uring" : "write",
+                     1e9 / r.median_ns,
+                     (double)rd.reader_syscalls / rd.total_messages,
+                     (double)*rd.writer_syscalls / rd.total_messages);
+        }
+    }
+
+    if (bench_cfg.format == BENCH_TEXT) {
+        printf("\n%d pipes x %d messages x %zu bytes%s\n", rd.pipes,
+               rd.messages, rd.size, rd.flags ? ", SQPOLL" : "");
+        printf("%-16s %-7s %12s %14s %14s\n", "reader", "writer", "msgs_per_s",
+               "rd_sys_per_msg", "wr_sys_per_msg");
+        for (int i = 0; i < nlines; ++i)
+            printf("%s\n", lines[i]);
+    }
+    return 0;
+}
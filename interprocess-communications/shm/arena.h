@@ -0,0 +1,610 @@
+/**
+ * @brief 跨进程共享内存上的分配器 SharedArena，以及建在它上面的 ShmVector / ShmHashMap / SlabPool
+ * @details
+ * ./ring.h 的队列只能放不含指针的类型：同一块 MAP_SHARED 内存在各进程中映射的地址不同，
+ * 一个进程里的指针在另一个进程里指向别处。这里的容器都用 OffsetPtr 代替指针：
+ * 它保存的是目标相对于 OffsetPtr 自身地址的偏移，不管整块区域映射在哪里，
+ * 两者的相对位置都不变，所以在共享区域里建好的 vector、哈希表，
+ * 任何映射了这块区域的进程（甚至同一进程里的第二个映射）都能直接读。
+ *
+ * 区域布局：ARENA_HEADER_SIZE 字节的 ArenaHeader，之后是分配出去的块。
+ *
+ * 分配：块的大小向上取整到 2 的幂（16 字节起），每个大小级别一个空闲链表（Treiber 栈），
+ *      空闲块的前 8 字节存下一个空闲块。链表头是 64 位的 {版本号 24 位, 偏移 / 16 共 40 位}，
+ *      每次 CAS 都递增版本号，避免 ABA；最大 16 TB 的区域。
+ *      空闲链表为空时：
+ *          块不大于 ARENA_SLAB_BYTES / 8 的，从区域顶部切一整块 slab（ARENA_SLAB_BYTES），
+ *          分成许多块，一次 CAS 挂到链表上；
+ *          更大的块直接从顶部切。
+ *      块对齐到 min(块大小, 4096)。顶部只增不减，释放的块回到所属级别的链表，不会合并。
+ *      deallocate() 需要传入分配时的大小（和 std::allocator 一样），块前面不需要额外的头。
+ *      分配和释放都是无锁的，多个进程可以同时进行。
+ *
+ * 创建：SharedArena::create(size, name, flags)
+ *      name 为空时用 memfd_create，子进程通过 fork 继承，或用 attach(fd()) 重新映射；
+ *      否则用 shm_open(name)，不相关的进程用 open(name) 打开。
+ *      flags 含 ARENA_HUGETLB 时用 MFD_HUGETLB 的 memfd（2 MB 大页，减少 TLB 缺失），
+ *      系统没有预留大页（/proc/sys/vm/nr_hugepages）时退回普通页并打印提示。
+ *
+ * 容器（ShmVector / ShmHashMap）本身也要放在共享区域里（make<>() 构造），
+ * 修改时传入 SharedArena，只读时不需要。一个容器同一时刻只能有一个写者；
+ * 写完之后，其他进程通过 root() 找到它并行地只读访问。
+ * 元素的复制要经过构造函数（OffsetPtr 不能 memcpy），容器扩容时逐个移动构造。
+ *
+ * @details
+ * https://www.boost.org/doc/libs/release/doc/html/interprocess/offset_ptr.html
+ * https://man7.org/linux/man-pages/man2/memfd_create.2.html
+ * https://www.kernel.org/doc/html/latest/admin-guide/mm/hugetlbpage.html
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <new>
+#include <sys/mman.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+constexpr uint64_t ARENA_MAGIC = 0x314e455241524853ULL; // "SHRAREN1"
+constexpr size_t ARENA_HEADER_SIZE = 4096;
+constexpr size_t ARENA_MIN_BLOCK = 16;
+constexpr int ARENA_CLASSES = 40;
+constexpr size_t ARENA_SLAB_BYTES = 64 * 1024;
+constexpr size_t ARENA_HUGE_PAGE = 2 * 1024 * 1024;
+
+// SharedArena::create() 的 flags
+constexpr int ARENA_HUGETLB = 1;
+
+/**
+ * @brief 自相对指针：保存目标地址减去自身地址，0 表示空指针
+ * @details
+ * 复制时按新位置重新计算偏移，所以不能 memcpy，也不能指向自己。
+ */
+template <typename T>
+class OffsetPtr {
+public:
+    OffsetPtr() = default;
+    OffsetPtr(std::nullptr_t) {}
+    OffsetPtr(T* p) { set(p); }
+    OffsetPtr(const OffsetPtr& other) { set(other.get()); }
+
+    OffsetPtr& operator=(const OffsetPtr& other) {
+        set(other.get());
+        return *this;
+    }
+
+    OffsetPtr& operator=(T* p) {
+        set(p);
+        return *this;
+    }
+
+    T* get() const {
+        if (off_ == 0)
+            return nullptr;
+        return reinterpret_cast<T*>(
+            reinterpret_cast<uintptr_t>(this) + static_cast<uintptr_t>(off_));
+    }
+
+    T* operator->() const { return get(); }
+    T& operator*() const { return *get(); }
+    T& operator[](size_t i) const { return get()[i]; }
+    explicit operator bool() const { return off_ != 0; }
+
+private:
+    void set(T* p) {
+        off_ = p == nullptr ? 0
+                            : static_cast<int64_t>(reinterpret_cast<uintptr_t>(p) -
+                                                   reinterpret_cast<uintptr_t>(this));
+    }
+
+    int64_t off_ = 0;
+};
+
+struct ArenaHeader {
+    uint64_t magic;
+    uint64_t size;                         // 整个区域的字节数
+    alignas(64) std::atomic<uint64_t> top; // 顶部的偏移
+    std::atomic<uint64_t> root;            // 根对象的偏移，0 表示没有
+    alignas(64) std::atomic<uint64_t> free[ARENA_CLASSES]; // {版本号, 偏移 / 16}
+};
+
+static_assert(sizeof(ArenaHeader) <= ARENA_HEADER_SIZE);
+
+class SharedArena {
+public:
+    /**
+     * @brief 创建 size 字节的共享区域
+     * @param name 为空时用 memfd_create，否则用 shm_open(name)（已存在时截断重建）
+     * @param flags ARENA_HUGETLB：用大页（只对 memfd 有效），size 向上取整到 2 MB
+     * @return 失败时打印错误并退出
+     */
+    static SharedArena create(size_t size, const char* name = nullptr,
+                              int flags = 0) {
+        int fd = -1;
+        if (name == nullptr && (flags & ARENA_HUGETLB)) {
+            size_t huge = (size + ARENA_HUGE_PAGE - 1) & ~(ARENA_HUGE_PAGE - 1);
+            fd = memfd_create("arena", MFD_CLOEXEC | MFD_HUGETLB);
+            if (fd != -1 && ftruncate(fd, huge) == 0) {
+                void* p = mmap(nullptr, huge, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, fd, 0);
+                // hugetlbfs 在映射时才检查大页是否够用
+                if (p != MAP_FAILED) {
+                    SharedArena arena(fd, p, huge);
+                    arena.init();
+                    return arena;
+                }
+            }
+            if (fd != -1)
+                close(fd);
+            fprintf(stderr, "arena: no huge pages available "
+                            "(see /proc/sys/vm/nr_hugepages), using 4 KB pages\n");
+        }
+
+        fd = name == nullptr ? memfd_create("arena", MFD_CLOEXEC)
+                             : shm_open(name, O_CREAT | O_TRUNC | O_RDWR, 0600);
+        if (fd == -1) {
+            perror(name == nullptr ? "memfd_create" : "shm_open");
+            exit(EXIT_FAILURE);
+        }
+        if (ftruncate(fd, size) == -1) {
+            perror("ftruncate");
+            exit(EXIT_FAILURE);
+        }
+        SharedArena arena = attach(fd, size);
+        close(fd);
+        arena.init();
+        return arena;
+    }
+
+    // 打开由 create(size, name) 创建的区域，映射到本进程的任意地址
+    static SharedArena open(const char* name) {
+        int fd = shm_open(name, O_RDWR, 0600);
+        if (fd == -1) {
+            perror("shm_open");
+            exit(EXIT_FAILURE);
+        }
+        SharedArena arena = attach(fd);
+        close(fd);
+        return arena;
+    }
+
+    /**
+     * @brief 再映射一次 fd 指向的区域（例如 fork 继承来的 memfd），得到独立的句柄
+     * @param size 为 0 时从头部读出
+     */
+    static SharedArena attach(int fd, size_t size = 0) {
+        int own = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (own == -1) {
+            perror("fcntl");
+            exit(EXIT_FAILURE);
+        }
+        if (size == 0) {
+            ArenaHeader h;
+            if (pread(own, &h, sizeof(h.magic) + sizeof(h.size), 0) !=
+                    static_cast<ssize_t>(sizeof(h.magic) + sizeof(h.size)) ||
+                h.magic != ARENA_MAGIC) {
+                fprintf(stderr, "arena: not an arena\n");
+                exit(EXIT_FAILURE);
+            }
+            size = h.size;
+        }
+        void* p =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, own, 0);
+        if (p == MAP_FAILED) {
+            perror("mmap");
+            exit(EXIT_FAILURE);
+        }
+        return SharedArena(own, p, size);
+    }
+
+    SharedArena(SharedArena&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)),
+          base_(std::exchange(other.base_, nullptr)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    SharedArena& operator=(SharedArena&& other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(base_, other.base_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    SharedArena(const SharedArena&) = delete;
+    SharedArena& operator=(const SharedArena&) = delete;
+
+    ~SharedArena() {
+        if (base_ != nullptr)
+            munmap(base_, size_);
+        if (fd_ != -1)
+            close(fd_);
+    }
+
+    int fd() const { return fd_; }
+    char* base() const { return base_; }
+    size_t size() const { return size_; }
+
+    // 已经从顶部切出去的字节数（包括头部和空闲块）
+    size_t used() const {
+        return header()->top.load(std::memory_order_relaxed);
+    }
+
+    uint64_t offsetOf(const void* p) const {
+        return p == nullptr ? 0 : static_cast<const char*>(p) - base_;
+    }
+
+    template <typename T = void>
+    T* at(uint64_t off) const {
+        return off == 0 ? nullptr : reinterpret_cast<T*>(base_ + off);
+    }
+
+    /**
+     * @brief 分配 bytes 字节，对齐到 min(块大小, 4096)
+     * @return 区域用完，或 bytes 超过最大的级别（8 TB）时返回 nullptr
+     */
+    void* allocate(size_t bytes) {
+        int k = sizeClass(bytes);
+        if (k >= ARENA_CLASSES)
+            return nullptr;
+        size_t block = ARENA_MIN_BLOCK << k;
+        uint64_t off = pop(k);
+        if (off != 0)
+            return base_ + off;
+
+        if (block <= ARENA_SLAB_BYTES / 8) {
+            uint64_t slab = bump(ARENA_SLAB_BYTES, 4096);
+            if (slab == 0)
+                return nullptr;
+            // 第一块返回，其余的串起来一次挂上链表
+            size_t count = ARENA_SLAB_BYTES / block;
+            for (size_t i = 1; i + 1 < count; ++i)
+                linkTo(slab + i * block, slab + (i + 1) * block);
+            push(k, slab + block, slab + (count - 1) * block);
+            return base_ + slab;
+        }
+        off = bump(block, block < 4096 ? block : 4096);
+        return off == 0 ? nullptr : base_ + off;
+    }
+
+    // 释放 allocate(bytes) 得到的块，bytes 必须与分配时相同
+    void deallocate(void* p, size_t bytes) {
+        if (p == nullptr)
+            return;
+        uint64_t off = offsetOf(p);
+        push(sizeClass(bytes), off, off);
+    }
+
+    // 在区域中构造一个 T，区域用完时打印错误并退出
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* p = allocate(sizeof(T));
+        if (p == nullptr)
+            outOfMemory(sizeof(T));
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void destroy(T* p) {
+        if (p == nullptr)
+            return;
+        p->~T();
+        deallocate(p, sizeof(T));
+    }
+
+    // 根对象：创建者建好数据结构后 setRoot()，其他进程用 root<T>() 找到它
+    void setRoot(const void* p) {
+        header()->root.store(offsetOf(p), std::memory_order_release);
+    }
+
+    template <typename T>
+    T* root() const {
+        return at<T>(header()->root.load(std::memory_order_acquire));
+    }
+
+    [[noreturn]] static void outOfMemory(size_t bytes) {
+        fprintf(stderr, "arena: out of memory allocating %zu bytes\n", bytes);
+        exit(EXIT_FAILURE);
+    }
+
+    static int sizeClass(size_t bytes) {
+        if (bytes <= ARENA_MIN_BLOCK)
+            return 0;
+        return 64 - __builtin_clzll(bytes - 1) - 4;
+    }
+
+private:
+    static constexpr uint64_t OFF_BITS = 40;
+    static constexpr uint64_t OFF_MASK = (1ULL << OFF_BITS) - 1;
+
+    SharedArena(int fd, void* base, size_t size)
+        : fd_(fd), base_(static_cast<char*>(base)), size_(size) {}
+
+    ArenaHeader* header() const {
+        return reinterpret_cast<ArenaHeader*>(base_);
+    }
+
+    void init() {
+        ArenaHeader* h = new (base_) ArenaHeader();
+        h->size = size_;
+        h->top.store(ARENA_HEADER_SIZE, std::memory_order_relaxed);
+        h->root.store(0, std::memory_order_relaxed);
+        for (auto& head : h->free)
+            head.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        h->magic = ARENA_MAGIC;
+    }
+
+    // 从顶部切出 bytes 字节，起点对齐到 align；不够时返回 0
+    uint64_t bump(size_t bytes, size_t align) {
+        std::atomic<uint64_t>& top = header()->top;
+        uint64_t old = top.load(std::memory_order_relaxed);
+        uint64_t begin;
+        do {
+            begin = (old + align - 1) & ~static_cast<uint64_t>(align - 1);
+            if (begin + bytes > size_)
+                return 0;
+        } while (!top.compare_exchange_weak(old, begin + bytes,
+                                            std::memory_order_relaxed));
+        return begin;
+    }
+
+    // 空闲块的前 8 字节：下一个空闲块的偏移 / 16；其他进程可能同时在读，用原子访问
+    void linkTo(uint64_t off, uint64_t next_off) {
+        __atomic_store_n(reinterpret_cast<uint64_t*>(base_ + off),
+                         next_off >> 4, __ATOMIC_RELAXED);
+    }
+
+    // 把已经串好的 first ... last 挂到链表 k 的头上
+    void push(int k, uint64_t first, uint64_t last) {
+        std::atomic<uint64_t>& head = header()->free[k];
+        uint64_t old = head.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            __atomic_store_n(reinterpret_cast<uint64_t*>(base_ + last),
+                             old & OFF_MASK, __ATOMIC_RELAXED);
+            next = ((old >> OFF_BITS) + 1) << OFF_BITS | first >> 4;
+        } while (!head.compare_exchange_weak(old, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+    // 取下链表 k 的第一块，空时返回 0
+    uint64_t pop(int k) {
+        std::atomic<uint64_t>& head = header()->free[k];
+        uint64_t old = head.load(std::memory_order_acquire);
+        while ((old & OFF_MASK) != 0) {
+            uint64_t off = (old & OFF_MASK) << 4;
+            // 这块可能已经被别人取走并改写，读到的值没有意义，但版本号会让 CAS 失败
+            uint64_t link = __atomic_load_n(
+                reinterpret_cast<uint64_t*>(base_ + off), __ATOMIC_RELAXED);
+            uint64_t next = ((old >> OFF_BITS) + 1) << OFF_BITS |
+                            (link & OFF_MASK);
+            if (head.compare_exchange_weak(old, next,
+                                           std::memory_order_acquire,
+                                           std::memory_order_acquire))
+                return off;
+        }
+        return 0;
+    }
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief 固定大小对象的池：T 所在大小级别的空闲链表
+ * @details
+ * 用于在进程之间传递消息：发送方 allocate() 填好，把 offsetOf() 通过 ./ring.h 的队列发出，
+ * 接收方 at<T>() 读完后 free()。数据本身不经过队列，也不经过内核拷贝。
+ * 池只是一个视图，不占共享内存，每个进程各自构造一个即可。
+ */
+template <typename T>
+class SlabPool {
+public:
+    explicit SlabPool(SharedArena& arena) : arena_(&arena) {}
+
+    // 未初始化的 T，池用完时返回 nullptr
+    T* allocate() { return static_cast<T*>(arena_->allocate(sizeof(T))); }
+
+    void free(T* p) { arena_->deallocate(p, sizeof(T)); }
+
+private:
+    SharedArena* arena_;
+};
+
+/**
+ * @brief 放在共享区域中的动态数组
+ * @details
+ * 修改的操作需要传入 arena；读操作只用到 OffsetPtr，在任何映射中都有效。
+ */
+template <typename T>
+class ShmVector {
+public:
+    ShmVector() = default;
+    ShmVector(const ShmVector&) = delete;
+    ShmVector& operator=(const ShmVector&) = delete;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    T* data() const { return data_.get(); }
+    T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data(); }
+    T* end() const { return data() + size_; }
+
+    void reserve(SharedArena& arena, size_t n) {
+        if (n <= capacity_)
+            return;
+        // 块大小本来就是 2 的幂，容量取满整个块
+        size_t bytes = n * sizeof(T);
+        size_t block = ARENA_MIN_BLOCK << SharedArena::sizeClass(bytes);
+        T* p = static_cast<T*>(arena.allocate(bytes));
+        if (p == nullptr)
+            SharedArena::outOfMemory(bytes);
+        T* old = data();
+        for (size_t i = 0; i < size_; ++i) {
+            new (p + i) T(std::move(old[i]));
+            old[i].~T();
+        }
+        arena.deallocate(old, capacity_ * sizeof(T));
+        data_ = p;
+        capacity_ = block / sizeof(T);
+    }
+
+    template <typename... Args>
+    T& emplace_back(SharedArena& arena, Args&&... args) {
+        if (size_ == capacity_)
+            reserve(arena, capacity_ == 0 ? 4 : capacity_ * 2);
+        T* p = new (data() + size_) T(std::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    void push_back(SharedArena& arena, const T& value) {
+        emplace_back(arena, value);
+    }
+
+    void clear() {
+        for (size_t i = 0; i < size_; ++i)
+            data_[i].~T();
+        size_ = 0;
+    }
+
+    // 析构所有元素并把存储还给 arena
+    void release(SharedArena& arena) {
+        clear();
+        arena.deallocate(data(), capacity_ * sizeof(T));
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+private:
+    OffsetPtr<T> data_;
+    uint64_t size_ = 0;
+    uint64_t capacity_ = 0;
+};
+
+/**
+ * @brief 放在共享区域中的哈希表：开放寻址、线性探测，负载不超过 1/2
+ * @details
+ * K、V 必须可平凡拷贝（表本身可以包含 OffsetPtr 指向的其他数据，但键值不能）。
+ * Hash 的结果再经过一次 splitmix64 混合，std::hash 对整数是恒等函数，
+ * 直接用会让有规律的键挤在一起。各进程必须使用同一个 Hash。
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ShmHashMap {
+    static_assert(std::is_trivially_copyable_v<K>);
+    static_assert(std::is_trivially_copyable_v<V>);
+
+public:
+    ShmHashMap() = default;
+    ShmHashMap(const ShmHashMap&) = delete;
+    ShmHashMap& operator=(const ShmHashMap&) = delete;
+
+    size_t size() const { return size_; }
+    size_t bucketCount() const { return mask_ == 0 ? 0 : mask_ + 1; }
+
+    // 预留能放下 n 个键的桶，避免插入过程中反复扩容
+    void reserve(SharedArena& arena, size_t n) {
+        size_t want = 16;
+        while (want < 2 * n)
+            want *= 2;
+        if (want > bucketCount())
+            rehash(arena, want);
+    }
+
+    // 插入或覆盖，返回是否是新键
+    bool insert(SharedArena& arena, const K& key, const V& value) {
+        if (2 * (size_ + 1) > bucketCount())
+            rehash(arena, bucketCount() == 0 ? 16 : bucketCount() * 2);
+        uint64_t h = hashOf(key);
+        Bucket* b = buckets_.get();
+        for (uint64_t i = h;; ++i) {
+            Bucket& slot = b[i & mask_];
+            if (slot.hash == 0) {
+                slot.hash = h;
+                slot.key = key;
+                slot.value = value;
+                ++size_;
+                return true;
+            }
+            if (slot.hash == h && slot.key == key) {
+                slot.value = value;
+                return false;
+            }
+        }
+    }
+
+    // 没有时返回 nullptr
+    const V* find(const K& key) const {
+        if (size_ == 0)
+            return nullptr;
+        uint64_t h = hashOf(key);
+        const Bucket* b = buckets_.get();
+        for (uint64_t i = h;; ++i) {
+            const Bucket& slot = b[i & mask_];
+            if (slot.hash == 0)
+                return nullptr;
+            if (slot.hash == h && slot.key == key)
+                return &slot.value;
+        }
+    }
+
+    void release(SharedArena& arena) {
+        arena.deallocate(buckets_.get(), bucketCount() * sizeof(Bucket));
+        buckets_ = nullptr;
+        mask_ = 0;
+        size_ = 0;
+    }
+
+private:
+    struct Bucket {
+        uint64_t hash; // 0 表示空；有效的哈希值最高位总是 1
+        K key;
+        V value;
+    };
+
+    static uint64_t hashOf(const K& key) {
+        uint64_t x = static_cast<uint64_t>(Hash{}(key));
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return (x ^ (x >> 31)) | 1ULL << 63;
+    }
+
+    void rehash(SharedArena& arena, size_t count) {
+        size_t bytes = count * sizeof(Bucket);
+        Bucket* nb = static_cast<Bucket*>(arena.allocate(bytes));
+        if (nb == nullptr)
+            SharedArena::outOfMemory(bytes);
+        for (size_t i = 0; i < count; ++i)
+            nb[i].hash = 0;
+
+        Bucket* old = buckets_.get();
+        size_t old_count = bucketCount();
+        for (size_t j = 0; j < old_count; ++j) {
+            if (old[j].hash == 0)
+                continue;
+            for (uint64_t i = old[j].hash;; ++i) {
+                if (nb[i & (count - 1)].hash == 0) {
+                    nb[i & (count - 1)] = old[j];
+                    break;
+                }
+            }
+        }
+        arena.deallocate(old, old_count * sizeof(Bucket));
+        buckets_ = nb;
+        mask_ = count - 1;
+    }
+
+    OffsetPtr<Bucket> buckets_;
+    uint64_t mask_ = 0;
+    uint64_t size_ = 0;
+};
@@ -0,0 +1,406 @@
+/**
+ * @brief 共享查找表：SharedArena 中的 ShmHashMap 与 malloc + 管道拷贝的对比
+ * @details
+ * 父进程建一张 entries 个键的查找表（默认 1000000），children 个子进程（默认 4）
+ * 各自做 lookups 次随机查找（默认 1000000）。
+ *
+ * malloc + pipe
+ *      父进程在堆上建 std::unordered_map，再把所有键值逐个写进每个子进程的管道，
+ *      子进程读出后在自己的堆上重建一份。
+ * arena
+ *      父进程在 SharedArena 中建 ShmHashMap 并 setRoot()，子进程 attach() 重新映射
+ *      （映射地址与父进程不同），root() 找到表后直接查找，没有拷贝。
+ *      参数为 huge 时用 ARENA_HUGETLB。
+ *
+ * 每种方式报告：父进程建表耗时、从开始到所有子进程可以查找的耗时、
+ * 子进程每次查找的耗时、所有子进程私有内存（/proc/self/smaps_rollup 的 Private_*）之和。
+ * 单 CPU 上子进程同时查找会互相挤占缓存，查找耗时用 children=1 比较更准确。
+ * 子进程把查找结果的校验和交回父进程核对。
+ *
+ * 最后比较 64 字节消息的分配 + 释放：malloc / free 与 SlabPool，
+ * 以及父子进程同时使用同一个 SlabPool（每个块写入自己的 pid 再检查，
+ * 同一块被发给两个进程时检查会失败）。
+ *
+ * @note
+ * g++ interprocess-communications/shm/arena_bench.cpp -o out/a.out --std=c++17 -O2
+ * out/a.out [entries=1000000] [children=4] [lookups=1000000] [huge]
+ */
+#include "arena.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+struct Record {
+    uint64_t id;
+    uint64_t score;
+    uint64_t flags;
+    char name[8];
+};
+
+struct Entry {
+    uint64_t key;
+    Record value;
+};
+
+// 子进程交回父进程的结果
+struct Result {
+    uint64_t ready_ns; // 可以开始查找的时刻
+    uint64_t checksum;
+    double lookup_ns;
+    uint64_t private_kb;
+};
+
+struct Message {
+    uint64_t owner;
+    char payload[56];
+};
+
+using Table = ShmHashMap<uint64_t, Record>;
+
+constexpr uint64_t KEY_STRIDE = 0x9e3779b9;
+constexpr int POOL_BATCH = 64;
+constexpr int POOL_ROUNDS = 100000;
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t keyOf(uint64_t i) { return i * KEY_STRIDE + 1; }
+
+Record recordOf(uint64_t i) {
+    Record r{i, i * 31 % 1000, i & 0xff, {}};
+    for (size_t k = 0; k < sizeof(r.name); ++k)
+        r.name[k] = static_cast<char>('a' + (i >> (3 * k)) % 26);
+    return r;
+}
+
+// 每个子进程用不同的种子查找同一组随机键
+template <typename Find>
+uint64_t lookupAll(uint64_t entries, uint64_t lookups, uint64_t seed,
+                   Find find, double* ns_per_lookup) {
+    uint64_t x = seed * 0x9e3779b97f4a7c15ULL + 1, sum = 0;
+    uint64_t t0 = nowNs();
+    for (uint64_t i = 0; i < lookups; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const Record* r = find(keyOf(x % entries));
+        sum += r != nullptr ? r->score + r->name[1] : 1000000;
+    }
+    *ns_per_lookup = static_cast<double>(nowNs() - t0) / lookups;
+    return sum;
+}
+
+uint64_t expectedChecksum(uint64_t entries, uint64_t lookups, uint64_t seed) {
+    double unused;
+    return lookupAll(entries, lookups, seed, [](uint64_t key) {
+        static Record r;
+        r = recordOf((key - 1) / KEY_STRIDE);
+        return &r;
+    }, &unused);
+}
+
+// 只有本进程映射的页（Private_Clean + Private_Dirty）
+uint64_t privateKb() {
+    FILE* f = fopen("/proc/self/smaps_rollup", "r");
+    if (f == nullptr)
+        return 0;
+    char line[256];
+    unsigned long long kb, total = 0;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (sscanf(line, "Private_Clean: %llu kB", &kb) == 1 ||
+            sscanf(line, "Private_Dirty: %llu kB", &kb) == 1)
+            total += kb;
+    }
+    fclose(f);
+    return total;
+}
+
+void writeAll(int fd, const void* buf, size_t len) {
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n == -1) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+bool readAll(int fd, void* buf, size_t len) {
+    char* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+struct Row {
+    const char* name;
+    double build_ms;
+    double ready_ms;
+    double lookup_ns;
+    uint64_t private_kb;
+};
+
+// 收集子进程的结果并核对校验和
+Row collect(const char* name, uint64_t t0, double build_ms,
+            const vector<int>& result_fds, uint64_t entries,
+            uint64_t lookups) {
+    Row row{name, build_ms, 0, 0, 0};
+    for (size_t i = 0; i < result_fds.size(); ++i) {
+        Result r;
+        if (!readAll(result_fds[i], &r, sizeof(r))) {
+            fprintf(stderr, "%s: child %zu sent no result\n", name, i);
+            exit(EXIT_FAILURE);
+        }
+        close(result_fds[i]);
+        if (r.checksum != expectedChecksum(entries, lookups, i + 1)) {
+            fprintf(stderr, "%s: child %zu wrong checksum\n", name, i);
+            exit(EXIT_FAILURE);
+        }
+        double ready = static_cast<double>(r.ready_ns - t0) / 1e6;
+        row.ready_ms = ready > row.ready_ms ? ready : row.ready_ms;
+        row.lookup_ns += r.lookup_ns / result_fds.size();
+        row.private_kb += r.private_kb;
+    }
+    while (wait(nullptr) > 0)
+        ;
+    return row;
+}
+
+Row mallocPipe(uint64_t entries, int children, uint64_t lookups) {
+    uint64_t t0 = nowNs();
+    std::unordered_map<uint64_t, Record> table;
+    table.reserve(entries);
+    for (uint64_t i = 0; i < entries; ++i)
+        table.emplace(keyOf(i), recordOf(i));
+    double build_ms = static_cast<double>(nowNs() - t0) / 1e6;
+
+    vector<int> result_fds;
+    for (int c = 0; c < children; ++c) {
+        int data[2], result[2];
+        if (pipe(data) == -1 || pipe(result) == -1) {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(data[1]);
+            close(result[0]);
+            // 子进程不使用继承来的表，从管道重建自己的一份
+            std::unordered_map<uint64_t, Record> copy;
+            copy.reserve(entries);
+            Entry buf[256];
+            for (uint64_t got = 0; got < entries;) {
+                size_t n = entries - got < 256 ? entries - got : 256;
+                if (!readAll(data[0], buf, n * sizeof(Entry)))
+                    _exit(EXIT_FAILURE);
+                for (size_t i = 0; i < n; ++i)
+                    copy.emplace(buf[i].key, buf[i].value);
+                got += n;
+            }
+            Result r;
+            r.ready_ns = nowNs();
+            r.checksum = lookupAll(
+                entries, lookups, c + 1,
+                [&](uint64_t key) -> const Record* {
+                    auto it = copy.find(key);
+                    return it == copy.end() ? nullptr : &it->second;
+                },
+                &r.lookup_ns);
+            r.private_kb = privateKb();
+            writeAll(result[1], &r, sizeof(r));
+            _exit(EXIT_SUCCESS);
+        }
+        close(data[0]);
+        close(result[1]);
+        result_fds.push_back(result[0]);
+
+        Entry buf[256];
+        size_t n = 0;
+        for (const auto& [key, value] : table) {
+            buf[n++] = Entry{key, value};
+            if (n == 256) {
+                writeAll(data[1], buf, sizeof(buf));
+                n = 0;
+            }
+        }
+        writeAll(data[1], buf, n * sizeof(Entry));
+        close(data[1]);
+    }
+    return collect("malloc + pipe", t0, build_ms, result_fds, entries,
+                   lookups);
+}
+
+Row sharedArena(uint64_t entries, int children, uint64_t lookups, bool huge) {
+    uint64_t t0 = nowNs();
+    // 桶数是不小于 2 * entries 的 2 的幂，桶数组的块再向上取整到 2 的幂
+    size_t buckets = 16;
+    while (buckets < 2 * entries)
+        buckets *= 2;
+    size_t bytes = buckets * (sizeof(uint64_t) * 2 + sizeof(Record));
+    size_t block = ARENA_MIN_BLOCK << SharedArena::sizeClass(bytes);
+    SharedArena arena = SharedArena::create(block + (1 << 20), nullptr,
+                                            huge ? ARENA_HUGETLB : 0);
+    Table* table = arena.make<Table>();
+    table->reserve(arena, entries);
+    for (uint64_t i = 0; i < entries; ++i)
+        table->insert(arena, keyOf(i), recordOf(i));
+    arena.setRoot(table);
+    double build_ms = static_cast<double>(nowNs() - t0) / 1e6;
+
+    vector<int> result_fds;
+    for (int c = 0; c < children; ++c) {
+        int result[2];
+        if (pipe(result) == -1) {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(result[0]);
+            // 重新映射到另一个地址，只通过 root() 找到表
+            SharedArena view = SharedArena::attach(arena.fd(), arena.size());
+            const Table* shared = view.root<Table>();
+            if (view.base() == arena.base() ||
+                shared->size() != entries) {
+                fprintf(stderr, "child: bad view of the arena\n");
+                _exit(EXIT_FAILURE);
+            }
+            Result r;
+            r.ready_ns = nowNs();
+            r.checksum = lookupAll(
+                entries, lookups, c + 1,
+                [&](uint64_t key) { return shared->find(key); },
+                &r.lookup_ns);
+            r.private_kb = privateKb();
+            writeAll(result[1], &r, sizeof(r));
+            _exit(EXIT_SUCCESS);
+        }
+        close(result[1]);
+        result_fds.push_back(result[0]);
+    }
+    return collect(huge ? "arena (huge)" : "arena", t0, build_ms, result_fds,
+                   entries, lookups);
+}
+
+double mallocMessages() {
+    void* batch[POOL_BATCH];
+    uint64_t t0 = nowNs();
+    for (int round = 0; round < POOL_ROUNDS; ++round) {
+        for (int i = 0; i < POOL_BATCH; ++i) {
+            batch[i] = malloc(sizeof(Message));
+            static_cast<Message*>(batch[i])->owner = i;
+        }
+        for (int i = 0; i < POOL_BATCH; ++i)
+            free(batch[i]);
+    }
+    return static_cast<double>(nowNs() - t0) / POOL_ROUNDS / POOL_BATCH;
+}
+
+// 每个块写入 owner 再检查，返回检查失败的次数
+uint64_t poolMessages(SlabPool<Message>& pool, uint64_t owner, double* ns) {
+    Message* batch[POOL_BATCH];
+    uint64_t bad = 0;
+    uint64_t t0 = nowNs();
+    for (int round = 0; round < POOL_ROUNDS; ++round) {
+        for (int i = 0; i < POOL_BATCH; ++i) {
+            batch[i] = pool.allocate();
+            if (batch[i] == nullptr)
+                SharedArena::outOfMemory(sizeof(Message));
+            __atomic_store_n(&batch[i]->owner, owner, __ATOMIC_RELAXED);
+        }
+        for (int i = 0; i < POOL_BATCH; ++i) {
+            bad += __atomic_load_n(&batch[i]->owner, __ATOMIC_RELAXED) != owner;
+            pool.free(batch[i]);
+        }
+    }
+    *ns = static_cast<double>(nowNs() - t0) / POOL_ROUNDS / POOL_BATCH;
+    return bad;
+}
+
+void messages() {
+    SharedArena arena = SharedArena::create(16 << 20);
+    SlabPool<Message> pool(arena);
+    // 超过最大级别的请求不能越界访问空闲链表
+    if (arena.allocate(ARENA_MIN_BLOCK << (ARENA_CLASSES - 1) << 1) != nullptr ||
+        arena.allocate(SIZE_MAX) != nullptr) {
+        fprintf(stderr, "arena: oversized allocation succeeded\n");
+        exit(EXIT_FAILURE);
+    }
+    double malloc_ns = mallocMessages();
+    double pool_ns;
+    uint64_t bad = poolMessages(pool, 1, &pool_ns);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        double unused;
+        _exit(poolMessages(pool, getpid(), &unused) == 0 ? EXIT_SUCCESS
+                                                         : EXIT_FAILURE);
+    }
+    double shared_ns;
+    bad += poolMessages(pool, getpid(), &shared_ns);
+    int status;
+    waitpid(pid, &status, 0);
+    if (bad != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "SlabPool handed the same block out twice\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("\n%zu-byte messages, alloc + free: malloc %.1f ns, SlabPool %.1f "
+           "ns, SlabPool shared by 2 processes %.1f ns (arena used %zu KB)\n",
+           sizeof(Message), malloc_ns, pool_ns, shared_ns, arena.used() / 1024);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t entries = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int children = argc > 2 ? atoi(argv[2]) : 4;
+    uint64_t lookups = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+    bool huge = argc > 4 && strcmp(argv[4], "huge") == 0;
+    if (entries == 0 || children <= 0 || lookups == 0) {
+        fprintf(stderr, "entries, children and lookups must be positive\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%llu entries, %d children, %llu lookups each\n\n",
+           static_cast<unsigned long long>(entries), children,
+           static_cast<unsigned long long>(lookups));
+    printf("%-16s %10s %10s %11s %17s\n", "", "build_ms", "ready_ms",
+           "lookup_ns", "children_private");
+    // 先做 arena：malloc 释放的堆不会还给系统，之后 fork 的子进程会带着它
+    Row arena = sharedArena(entries, children, lookups, huge);
+    Row rows[] = {mallocPipe(entries, children, lookups), arena};
+    for (const Row& r : rows)
+        printf("%-16s %10.1f %10.1f %11.1f %14llu KB\n", r.name, r.build_ms,
+               r.ready_ms, r.lookup_ns,
+               static_cast<unsigned long long>(r.private_kb));
+
+    messages();
+    return EXIT_SUCCESS;
+}
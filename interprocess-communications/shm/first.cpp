@@ -0,0 +1,208 @@
+/**
+ * @brief 共享内存环形队列与管道的对比
+ * @details
+ * 生产者是 fork 出的子进程，消费者是父进程，消息 64 字节。
+ *
+ * 吞吐量：生产者全速发送 count 条消息，统计每秒消息数。
+ *      pipe         每条消息一次 write()，消费者每次 read() 尽量多读
+ *      spsc         SpscRing，逐条 push / 批量 pop
+ *      spsc-batch   SpscRing，每 32 条发布一次
+ *      mpmc xP      P 个生产者共用一个 MpmcRing
+ * 延迟：生产者每 20 微秒发送一条，消息里带着发送时刻，
+ *      消费者统计投递延迟的 p50 / p99。
+ *
+ * @note
+ * g++ interprocess-communications/shm/first.cpp -o out/a.out --std=c++17 -O2
+ * out/a.out [count=1000000] [producers=4]
+ */
+#include "ring.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+
+struct Message {
+    uint64_t send_ns;
+    uint64_t seq;
+    char payload[48];
+};
+
+constexpr size_t RING_SIZE = 4096;
+constexpr size_t BATCH = 32;
+constexpr long PACE_NS = 20000;
+
+using Spsc = SpscRing<Message, RING_SIZE>;
+using Mpmc = MpmcRing<Message, RING_SIZE>;
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void pace(bool paced) {
+    if (paced) {
+        timespec ts = {0, PACE_NS};
+        nanosleep(&ts, nullptr);
+    }
+}
+
+/**
+ * @brief 跑一组测试
+ * @param send 在每个生产者子进程中调用 send(条数, 是否限速)
+ * @param recv 在父进程中调用 recv(总条数, 延迟数组或 nullptr)
+ */
+template <typename Send, typename Recv>
+void runCase(const char* name, int producers, long count, bool paced,
+             Send send, Recv recv) {
+    long per_producer = count / producers;
+    long total = per_producer * producers;
+    vector<uint64_t> latencies;
+    latencies.reserve(paced ? total : 0);
+
+    uint64_t begin = nowNs();
+    for (int i = 0; i < producers; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            send(per_producer, paced);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+    recv(total, paced ? &latencies : nullptr);
+    uint64_t elapsed = nowNs() - begin;
+    while (wait(nullptr) > 0)
+        ;
+
+    if (!paced) {
+        printf("%-14s %12.0f msg/s\n", name, total * 1e9 / elapsed);
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-14s p50 %8.1f us   p99 %8.1f us\n", name,
+           latencies[total / 2] / 1e3, latencies[total * 99 / 100] / 1e3);
+}
+
+void record(const Message& msg, vector<uint64_t>* latencies) {
+    if (latencies != nullptr)
+        latencies->push_back(nowNs() - msg.send_ns);
+}
+
+void benchPipe(long count, bool paced) {
+    int pipefd[2];
+    if (pipe(pipefd) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    runCase(
+        "pipe", 1, count, paced,
+        [&](long n, bool paced) {
+            close(pipefd[0]);
+            Message msg{};
+            for (msg.seq = 0; msg.seq < static_cast<uint64_t>(n); ++msg.seq) {
+                pace(paced);
+                msg.send_ns = nowNs();
+                write(pipefd[1], &msg, sizeof(msg));
+            }
+        },
+        [&](long n, vector<uint64_t>* latencies) {
+            close(pipefd[1]);
+            Message buf[BATCH];
+            long received = 0;
+            size_t partial = 0; // 上次 read 末尾不完整消息的字节数
+            while (received < n) {
+                char* dst = reinterpret_cast<char*>(buf) + partial;
+                ssize_t r = read(pipefd[0], dst, sizeof(buf) - partial);
+                if (r <= 0)
+                    break;
+                size_t bytes = partial + r;
+                size_t whole = bytes / sizeof(Message);
+                for (size_t i = 0; i < whole; ++i)
+                    record(buf[i], latencies);
+                received += whole;
+                partial = bytes % sizeof(Message);
+                memmove(buf, buf + whole, partial);
+            }
+            close(pipefd[0]);
+        });
+}
+
+void benchSpsc(long count, bool paced, size_t batch) {
+    Spsc* ring = createShared<Spsc>();
+    runCase(
+        batch == 1 ? "spsc" : "spsc-batch", 1, count, paced,
+        [&](long n, bool paced) {
+            Message msgs[BATCH]{};
+            for (long sent = 0; sent < n;) {
+                pace(paced);
+                size_t k = std::min<long>(batch, n - sent);
+                uint64_t now = nowNs();
+                for (size_t i = 0; i < k; ++i) {
+                    msgs[i].send_ns = now;
+                    msgs[i].seq = sent + i;
+                }
+                ring->push(msgs, k);
+                sent += k;
+            }
+        },
+        [&](long n, vector<uint64_t>* latencies) {
+            Message buf[BATCH];
+            for (long received = 0; received < n;) {
+                size_t k = ring->pop(buf, BATCH);
+                for (size_t i = 0; i < k; ++i)
+                    record(buf[i], latencies);
+                received += k;
+            }
+        });
+    destroyShared(ring);
+}
+
+void benchMpmc(long count, bool paced, int producers) {
+    Mpmc* ring = createShared<Mpmc>();
+    char name[32];
+    snprintf(name, sizeof(name), "mpmc x%d", producers);
+    runCase(
+        name, producers, count, paced,
+        [&](long n, bool paced) {
+            Message msg{};
+            for (msg.seq = 0; msg.seq < static_cast<uint64_t>(n); ++msg.seq) {
+                pace(paced);
+                msg.send_ns = nowNs();
+                ring->push(msg);
+            }
+        },
+        [&](long n, vector<uint64_t>* latencies) {
+            Message msg;
+            for (long received = 0; received < n; ++received) {
+                ring->pop(msg);
+                record(msg, latencies);
+            }
+        });
+    destroyShared(ring);
+}
+
+int main(int argc, char* argv[]) {
+    long count = argc > 1 ? atol(argv[1]) : 1000000;
+    int producers = argc > 2 ? atoi(argv[2]) : 4;
+    long paced_count = std::min(count, 20000L);
+
+    printf("throughput, %ld messages of %zu bytes\n", count, sizeof(Message));
+    benchPipe(count, false);
+    benchSpsc(count, false, 1);
+    benchSpsc(count, false, BATCH);
+    benchMpmc(count, false, producers);
+
+    printf("\nlatency, one message every %ld us\n", PACE_NS / 1000);
+    benchPipe(paced_count, true);
+    benchSpsc(paced_count, true, 1);
+    benchMpmc(paced_count, true, producers);
+    return EXIT_SUCCESS;
+}
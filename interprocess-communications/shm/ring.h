@@ -0,0 +1,348 @@
+/**
+ * @brief 共享内存中的无锁环形队列 SpscRing / MpmcRing
+ * @details
+ * 队列对象整个放在 MAP_SHARED 内存里（memfd_create 或 shm_open），
+ * fork 出的子进程继承映射后，父子进程直接通过内存交换消息，不经过内核拷贝。
+ *
+ * SpscRing<T, N>
+ *      单生产者单消费者。head / tail 各占一个 cache line，避免伪共享；
+ *      双方各自缓存对方的下标，只有缓存显示“满/空”时才去读对方的 cache line。
+ *      pushBatch() 写完一批元素后只发布一次 tail。
+ * MpmcRing<T, N>
+ *      Dmitry Vyukov 的有界队列，每个槽位带一个序号，
+ *      入队和出队都用 CAS 抢下标，多生产者（MPSC）或多消费者都可以使用。
+ *
+ * 队列空（或满）时，等待的一方在一个 futex 字上睡眠，
+ * 另一方只有在发现“有人在等”时才调用 futex(FUTEX_WAKE)，
+ * 所以繁忙时没有任何系统调用。
+ * 跨进程使用，不能带 FUTEX_PRIVATE_FLAG。
+ *
+ * T 必须是可平凡拷贝的类型，不能包含指针（各进程映射地址不同）。
+ *
+ * @details
+ * https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ * https://man7.org/linux/man-pages/man2/futex.2.html
+ */
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <type_traits>
+#include <unistd.h>
+
+constexpr size_t CACHE_LINE = 64;
+
+// 自旋多少次之后才进入 futex 睡眠
+constexpr int RING_SPIN = 256;
+
+// timeout 为相对时间，空指针表示一直等
+inline void futexWait(std::atomic<uint32_t>* addr, uint32_t expected,
+                      const timespec* timeout = nullptr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected,
+            timeout, nullptr, 0);
+}
+
+inline void futexWake(std::atomic<uint32_t>* addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, count,
+            nullptr, nullptr, 0);
+}
+
+/**
+ * @brief 一个方向上的“等待/唤醒”
+ * @details
+ * 等待方：读 seq → 置 waiting → 再检查一次条件 → futex 等 seq 变化。
+ * 通知方：改完数据 → 全屏障 → 看到 waiting 才递增 seq 并唤醒。
+ * 两边都有全屏障，所以不会出现“等待方睡下去、通知方又没看到 waiting”。
+ */
+struct alignas(CACHE_LINE) WaitPoint {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> waiting{0};
+
+    template <typename Ready>
+    void wait(Ready ready) {
+        for (int i = 0; i < RING_SPIN; ++i) {
+            if (ready())
+                return;
+        }
+        while (!ready()) {
+            uint32_t s = seq.load(std::memory_order_acquire);
+            waiting.fetch_add(1, std::memory_order_seq_cst);
+            if (!ready())
+                futexWait(&seq, s);
+            waiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 与 wait() 相同，但最多睡眠 timeout_ms 毫秒，超时返回 false
+    template <typename Ready>
+    bool waitFor(Ready ready, int timeout_ms) {
+        for (int i = 0; i < RING_SPIN; ++i) {
+            if (ready())
+                return true;
+        }
+        timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+        uint32_t s = seq.load(std::memory_order_acquire);
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        if (!ready())
+            futexWait(&seq, s, &timeout);
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+        return ready();
+    }
+
+    void notify(int count = 1) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) != 0) {
+            seq.fetch_add(1, std::memory_order_release);
+            futexWake(&seq, count);
+        }
+    }
+};
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    bool tryPush(const T& item) { return pushBatch(&item, 1) == 1; }
+
+    // 尽量写入 count 个元素，只发布一次 tail，返回实际写入的个数
+    size_t pushBatch(const T* items, size_t count) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (N - (tail - cached_head_) < count)
+            cached_head_ = head_.load(std::memory_order_acquire);
+        size_t free = N - (tail - cached_head_);
+        if (count > free)
+            count = free;
+        if (count == 0)
+            return 0;
+
+        for (size_t i = 0; i < count; ++i)
+            slots_[(tail + i) & (N - 1)] = items[i];
+        tail_.store(tail + count, std::memory_order_release);
+        not_empty_.notify();
+        return count;
+    }
+
+    // 写入全部 count 个元素，队列满时睡眠
+    void push(const T* items, size_t count = 1) {
+        while (count > 0) {
+            size_t n = pushBatch(items, count);
+            items += n;
+            count -= n;
+            if (count > 0)
+                not_full_.wait([this] {
+                    return head_.load(std::memory_order_acquire) !=
+                           tail_.load(std::memory_order_relaxed) - N;
+                });
+        }
+    }
+
+    bool tryPop(T& item) { return popBatch(&item, 1) == 1; }
+
+    // 最多取出 count 个元素，只发布一次 head，返回实际取出的个数
+    size_t popBatch(T* out, size_t count) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < count)
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        size_t avail = cached_tail_ - head;
+        if (count > avail)
+            count = avail;
+        if (count == 0)
+            return 0;
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = slots_[(head + i) & (N - 1)];
+        head_.store(head + count, std::memory_order_release);
+        not_full_.notify();
+        return count;
+    }
+
+    // 至少取出一个元素，队列空时睡眠
+    size_t pop(T* out, size_t count = 1) {
+        size_t n;
+        while ((n = popBatch(out, count)) == 0)
+            not_empty_.wait([this] {
+                return tail_.load(std::memory_order_acquire) !=
+                       head_.load(std::memory_order_relaxed);
+            });
+        return n;
+    }
+
+private:
+    // 消费者独占
+    alignas(CACHE_LINE) std::atomic<uint64_t> head_{0};
+    uint64_t cached_tail_ = 0;
+    // 生产者独占
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail_{0};
+    uint64_t cached_head_ = 0;
+
+    WaitPoint not_empty_;
+    WaitPoint not_full_;
+    alignas(CACHE_LINE) T slots_[N];
+};
+
+template <typename T, size_t N>
+class MpmcRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    MpmcRing() {
+        for (size_t i = 0; i < N; ++i)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(const T& item) {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & (N - 1)];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    slot.value = item;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    not_empty_.notify();
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 满
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void push(const T& item) {
+        while (!tryPush(item))
+            not_full_.wait([this] { return !full(); });
+    }
+
+    bool tryPop(T& item) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & (N - 1)];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+                    item = slot.value;
+                    slot.seq.store(pos + N, std::memory_order_release);
+                    not_full_.notify();
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 空
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void pop(T& item) {
+        while (!tryPop(item))
+            not_empty_.wait([this] { return !empty(); });
+    }
+
+    // 队列空时最多等待 timeout_ms 毫秒，超时返回 false
+    bool popFor(T& item, int timeout_ms) {
+        if (tryPop(item))
+            return true;
+        not_empty_.waitFor([this] { return !empty(); }, timeout_ms);
+        return tryPop(item);
+    }
+
+    bool empty() const {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        return slots_[pos & (N - 1)].seq.load(std::memory_order_acquire) !=
+               pos + 1;
+    }
+
+    bool full() const {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        return slots_[pos & (N - 1)].seq.load(std::memory_order_acquire) !=
+               pos;
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_relaxed) -
+               head_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        T value;
+    };
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> head_{0};
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail_{0};
+    WaitPoint not_empty_;
+    WaitPoint not_full_;
+    alignas(CACHE_LINE) Slot slots_[N];
+};
+
+/**
+ * @brief 在共享内存中构造一个 T
+ * @param name 为空时用 memfd_create，只能通过 fork 继承；
+ *             否则用 shm_open(name)，不相关的进程也可以按名字打开
+ * @return 映射好的对象，失败时打印错误并退出
+ */
+template <typename T>
+T* createShared(const char* name = nullptr) {
+    int fd = name == nullptr ? memfd_create("ring", 0)
+                             : shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd == -1) {
+        perror(name == nullptr ? "memfd_create" : "shm_open");
+        exit(EXIT_FAILURE);
+    }
+    if (ftruncate(fd, sizeof(T)) == -1) {
+        perror("ftruncate");
+        exit(EXIT_FAILURE);
+    }
+    void* p =
+        mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    return new (p) T();
+}
+
+// 映射一个已由 createShared(name) 创建的对象
+template <typename T>
+T* openShared(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd == -1) {
+        perror("shm_open");
+        exit(EXIT_FAILURE);
+    }
+    void* p =
+        mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    return static_cast<T*>(p);
+}
+
+template <typename T>
+void destroyShared(T* obj) {
+    obj->~T();
+    munmap(obj, sizeof(T));
+}
@@ -0,0 +1,286 @@
+/**
+ * @brief 两个线程之间的 ping-pong 往返延迟
+ * @details
+ * ./volatile.c 用 volatile int 自旋来同步两个线程，
+ * volatile 既不保证原子性也不保证顺序，不是同步原语，而且一直占着一个核。
+ * 这里用同样的“交接”模式比较几种正确的等待方式：
+ *
+ * seq_cst      std::atomic 自旋，读写都是 memory_order_seq_cst
+ *              （x86 上 seq_cst 的 store 是 xchg，带一次全屏障）
+ * acq_rel      std::atomic 自旋，store 用 release，load 用 acquire
+ * pause        acq_rel 自旋，每次循环执行一条 pause 指令，
+ *              降低功耗，也把流水线让给同一物理核上的另一个超线程
+ * spin_futex   先自旋一段时间，还没等到就在 futex 上睡眠
+ * atomic_wait  C++20 std::atomic::wait / notify_one
+ *
+ * 两个线程分别绑定到指定的 CPU 上，每个往返包含两次交接。
+ * 默认选择 CPU 0 与它的超线程兄弟、同一插槽的另一个核、另一个插槽的核，
+ * 拓扑信息来自 /sys/devices/system/cpu/cpuN/topology。
+ * 两个线程在同一个 CPU 上时，纯自旋没有意义，只测试会睡眠的方式。
+ *
+ * @details
+ * https://en.cppreference.com/w/cpp/atomic/atomic/wait
+ * https://man7.org/linux/man-pages/man2/futex.2.html
+ *
+ * @note
+ * g++ other/pingpong.cpp -o out/a.out --std=c++20 -O2 -lpthread && out/a.out
+ * 指定 CPU 对：out/a.out -i 100000 0,1 0,2
+ */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+enum class Strategy {
+    SeqCst,
+    AcqRel,
+    Pause,
+    SpinFutex,
+    AtomicWait
+};
+
+constexpr Strategy ALL_STRATEGIES[] = {Strategy::SeqCst, Strategy::AcqRel,
+                                       Strategy::Pause, Strategy::SpinFutex,
+                                       Strategy::AtomicWait};
+
+const char* strategyName(Strategy s) {
+    switch (s) {
+    case Strategy::SeqCst:
+        return "seq_cst";
+    case Strategy::AcqRel:
+        return "acq_rel";
+    case Strategy::Pause:
+        return "pause";
+    case Strategy::SpinFutex:
+        return "spin_futex";
+    case Strategy::AtomicWait:
+        return "atomic_wait";
+    }
+    return "unknown";
+}
+
+// 会一直占着 CPU 等待的方式
+bool spinsForever(Strategy s) {
+    return s == Strategy::SeqCst || s == Strategy::AcqRel ||
+           s == Strategy::Pause;
+}
+
+constexpr int FUTEX_SPIN = 2000;
+
+// 独占一个 cache line，避免与其他数据伪共享
+struct alignas(64) Shared {
+    std::atomic<uint32_t> turn{0};
+    std::atomic<uint32_t> sleepers{0};
+};
+
+template <Strategy S>
+void waitFor(Shared& shared, uint32_t want) {
+    if constexpr (S == Strategy::SeqCst) {
+        while (shared.turn.load(std::memory_order_seq_cst) != want)
+            ;
+    } else if constexpr (S == Strategy::AcqRel) {
+        while (shared.turn.load(std::memory_order_acquire) != want)
+            ;
+    } else if constexpr (S == Strategy::Pause) {
+        while (shared.turn.load(std::memory_order_acquire) != want)
+            __builtin_ia32_pause();
+    } else if constexpr (S == Strategy::SpinFutex) {
+        for (int i = 0; i < FUTEX_SPIN; ++i) {
+            if (shared.turn.load(std::memory_order_acquire) == want)
+                return;
+            __builtin_ia32_pause();
+        }
+        uint32_t seen;
+        while ((seen = shared.turn.load(std::memory_order_seq_cst)) != want) {
+            shared.sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (shared.turn.load(std::memory_order_seq_cst) == seen)
+                syscall(SYS_futex, &shared.turn, FUTEX_WAIT_PRIVATE, seen,
+                        nullptr, nullptr, 0);
+            shared.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    } else {
+        uint32_t seen;
+        while ((seen = shared.turn.load(std::memory_order_acquire)) != want)
+            shared.turn.wait(seen, std::memory_order_acquire);
+    }
+}
+
+template <Strategy S>
+void publish(Shared& shared, uint32_t value) {
+    if constexpr (S == Strategy::SeqCst) {
+        shared.turn.store(value, std::memory_order_seq_cst);
+    } else if constexpr (S == Strategy::SpinFutex) {
+        shared.turn.store(value, std::memory_order_seq_cst);
+        if (shared.sleepers.load(std::memory_order_seq_cst) != 0)
+            syscall(SYS_futex, &shared.turn, FUTEX_WAKE_PRIVATE, 1, nullptr,
+                    nullptr, 0);
+    } else if constexpr (S == Strategy::AtomicWait) {
+        shared.turn.store(value, std::memory_order_release);
+        shared.turn.notify_one();
+    } else {
+        shared.turn.store(value, std::memory_order_release);
+    }
+}
+
+void pinTo(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    // 绑定失败时结果会被标错（同核 / 超线程兄弟 / 跨核），直接退出
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        errno = rc;
+        perror("pthread_setaffinity_np");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// 返回每次往返的纳秒数
+template <Strategy S>
+vector<uint64_t> pingPong(int cpu_a, int cpu_b, int iterations) {
+    constexpr int WARMUP = 1000;
+    Shared shared;
+    vector<uint64_t> samples;
+    samples.reserve(iterations);
+
+    std::thread pong([&] {
+        pinTo(cpu_b);
+        for (int i = 0; i < WARMUP + iterations; ++i) {
+            waitFor<S>(shared, 2 * i + 1);
+            publish<S>(shared, 2 * i + 2);
+        }
+    });
+
+    pinTo(cpu_a);
+    for (int i = 0; i < WARMUP + iterations; ++i) {
+        auto t0 = Clock::now();
+        publish<S>(shared, 2 * i + 1);
+        waitFor<S>(shared, 2 * i + 2);
+        if (i >= WARMUP)
+            samples.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - t0)
+                    .count());
+    }
+    pong.join();
+    return samples;
+}
+
+vector<uint64_t> run(Strategy s, int cpu_a, int cpu_b, int iterations) {
+    switch (s) {
+    case Strategy::SeqCst:
+        return pingPong<Strategy::SeqCst>(cpu_a, cpu_b, iterations);
+    case Strategy::AcqRel:
+        return pingPong<Strategy::AcqRel>(cpu_a, cpu_b, iterations);
+    case Strategy::Pause:
+        return pingPong<Strategy::Pause>(cpu_a, cpu_b, iterations);
+    case Strategy::SpinFutex:
+        return pingPong<Strategy::SpinFutex>(cpu_a, cpu_b, iterations);
+    case Strategy::AtomicWait:
+        return pingPong<Strategy::AtomicWait>(cpu_a, cpu_b, iterations);
+    }
+    return {};
+}
+
+struct CpuTopology {
+    int package = -1;
+    int core = -1;
+};
+
+int readTopology(int cpu, const char* name) {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                     "/topology/" + name);
+    int value = -1;
+    in >> value;
+    return value;
+}
+
+CpuTopology topologyOf(int cpu) {
+    return {readTopology(cpu, "physical_package_id"),
+            readTopology(cpu, "core_id")};
+}
+
+const char* relation(int a, int b) {
+    if (a == b)
+        return "same cpu";
+    CpuTopology ta = topologyOf(a), tb = topologyOf(b);
+    if (ta.package != tb.package)
+        return "cross-socket";
+    return ta.core == tb.core ? "SMT sibling" : "same socket";
+}
+
+// CPU 0 与它的超线程兄弟、同插槽的核、跨插槽的核；只有一个 CPU 时为 (0, 0)
+vector<std::pair<int, int>> defaultPairs() {
+    int ncpu = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    vector<std::pair<int, int>> pairs;
+    bool found_smt = false, found_socket = false, found_cross = false;
+    CpuTopology t0 = topologyOf(0);
+    for (int cpu = 1; cpu < ncpu; ++cpu) {
+        CpuTopology t = topologyOf(cpu);
+        bool* found = t.package != t0.package ? &found_cross
+                      : t.core == t0.core     ? &found_smt
+                                              : &found_socket;
+        if (!*found) {
+            *found = true;
+            pairs.emplace_back(0, cpu);
+        }
+    }
+    if (pairs.empty())
+        pairs.emplace_back(0, 0);
+    return pairs;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 100000;
+    vector<std::pair<int, int>> pairs;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (size_t comma = arg.find(','); comma != string::npos) {
+            pairs.emplace_back(std::stoi(arg.substr(0, comma)),
+                               std::stoi(arg.substr(comma + 1)));
+        } else {
+            fprintf(stderr, "Usage: %s [-i iterations] [cpu_a,cpu_b ...]\n",
+                    argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (pairs.empty())
+        pairs = defaultPairs();
+
+    printf("%-8s %-13s %-12s %10s %10s %10s %10s\n", "cpus", "relation",
+           "strategy", "p50_ns", "p90_ns", "p99_ns", "max_ns");
+    for (auto [a, b] : pairs) {
+        for (Strategy s : ALL_STRATEGIES) {
+            if (a == b && spinsForever(s))
+                continue;
+            vector<uint64_t> samples = run(s, a, b, iterations);
+            std::sort(samples.begin(), samples.end());
+            size_t n = samples.size();
+            char cpus[16];
+            snprintf(cpus, sizeof(cpus), "%d,%d", a, b);
+            printf("%-8s %-13s %-12s %10lu %10lu %10lu %10lu\n", cpus,
+                   relation(a, b), strategyName(s), samples[n / 2],
+                   samples[n * 9 / 10], samples[n * 99 / 100], samples[n - 1]);
+        }
+    }
+    return EXIT_SUCCESS;
+}
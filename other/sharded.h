@@ -0,0 +1,168 @@
+/**
+ * @brief 独占 cache line 的 Padded<T>，以及按线程 / 按 CPU 分片的计数器
+ * @details
+ * ./volatile.c 里 testVar 和 waitVar 是相邻的全局变量，由不同线程写入，
+ * 它们落在同一个 cache line 上：一个线程每写一次，另一个核上的这一行就失效一次，
+ * 这就是伪共享（false sharing）。多个线程更新的统计计数器也是一样，
+ * 即使每个线程只写自己的那个计数器，只要挨在一起，就会互相拖慢。
+ *
+ * Padded<T>
+ *      把 T 对齐并填充到 PAD_SIZE 字节，数组中相邻的两个元素不会共享 cache line。
+ * ThreadCounter
+ *      每个线程一个 Padded 分片，按 threadIndex() 选择。编号小于 capacity 的线程
+ *      独占自己的分片，只需要普通的 load + store（没有 lock 前缀），
+ *      其余线程共用最后一个额外的分片，改用 fetch_add。
+ * CpuCounter
+ *      每个 CPU 一个 Padded 分片，用当前 CPU 号选择分片。
+ *      分片数只和 CPU 数有关，与线程数无关；
+ *      取到 CPU 号之后线程仍可能被迁移，所以用 fetch_add，
+ *      但分片几乎总是只被本 CPU 访问，这一行一直留在本核的缓存中。
+ * 两种计数器读取时把所有分片加起来：add() 很便宜，read() 要扫一遍所有分片，
+ * 适合写多读少的统计量；read() 与 add() 并发时得到的是某个近似的中间值。
+ *
+ * 当前 CPU 号优先从 rseq 区域读取：glibc 2.35 起每个线程都注册了 rseq，
+ * 内核在线程每次被调度到某个 CPU 上时更新 cpu_id，读取它只是一次内存访问；
+ * 没有注册 rseq 时（内核太旧，或者 GLIBC_TUNABLES=glibc.pthread.rseq=0）
+ * 回退到 sched_getcpu()（vDSO 或系统调用）。
+ *
+ * PAD_SIZE 固定为 64，而不用 std::hardware_destructive_interference_size：
+ * 后者的值随编译器版本和 -mtune 变化（GCC 在头文件中使用它会给出警告），
+ * 不适合用在可能被不同编译单元、不同进程共享的数据布局中。
+ * Intel 的相邻行预取器会成对地取 128 字节，极端情况下可以改成 128。
+ *
+ * @details
+ * https://en.cppreference.com/w/cpp/thread/hardware_destructive_interference_size
+ * https://www.efficios.com/blog/2019/02/08/linux-restartable-sequences/
+ * https://man7.org/linux/man-pages/man3/sched_getcpu.3.html
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sched.h>
+#include <sys/rseq.h>
+#include <unistd.h>
+
+constexpr size_t PAD_SIZE = 64;
+
+template <typename T>
+struct alignas(PAD_SIZE) Padded {
+    T value{};
+
+    T& operator*() { return value; }
+    const T& operator*() const { return value; }
+    T* operator->() { return &value; }
+    const T* operator->() const { return &value; }
+};
+
+static_assert(sizeof(Padded<char>) == PAD_SIZE);
+
+// 当前线程所在的 CPU 号
+inline int currentCpu() {
+    if (__rseq_size > 0) {
+        auto* rs = reinterpret_cast<const struct rseq*>(
+            static_cast<const char*>(__builtin_thread_pointer()) +
+            __rseq_offset);
+        int cpu = static_cast<int>(
+            __atomic_load_n(&rs->cpu_id, __ATOMIC_RELAXED));
+        if (cpu >= 0)
+            return cpu;
+    }
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : cpu;
+}
+
+constexpr unsigned THREAD_INDEX_MAX = 1024;
+
+/**
+ * @brief 当前线程的编号
+ * @details
+ * 第一次调用时取最小的空闲编号，线程退出时归还，同时存在的线程编号各不相同。
+ * 同时存在超过 THREAD_INDEX_MAX 个线程时，之后的线程得到 THREAD_INDEX_MAX 及以上、
+ * 可能重复的编号。
+ */
+inline unsigned threadIndex() {
+    static std::atomic<uint64_t> used[THREAD_INDEX_MAX / 64];
+    static std::atomic<unsigned> overflow{0};
+    struct Holder {
+        unsigned index = THREAD_INDEX_MAX;
+        Holder() {
+            for (unsigned w = 0; w < THREAD_INDEX_MAX / 64; ++w) {
+                uint64_t bits = used[w].load(std::memory_order_relaxed);
+                while (~bits != 0) {
+                    uint64_t bit = ~bits & (bits + 1); // 最低的 0 位
+                    if (used[w].compare_exchange_weak(
+                            bits, bits | bit, std::memory_order_acquire)) {
+                        index = w * 64 + __builtin_ctzll(bit);
+                        return;
+                    }
+                }
+            }
+            index += overflow.fetch_add(1, std::memory_order_relaxed);
+        }
+        ~Holder() {
+            if (index < THREAD_INDEX_MAX)
+                used[index / 64].fetch_and(~(1ULL << (index % 64)),
+                                           std::memory_order_release);
+        }
+    };
+    thread_local Holder holder;
+    return holder.index;
+}
+
+class ThreadCounter {
+public:
+    explicit ThreadCounter(size_t capacity = THREAD_INDEX_MAX)
+        : capacity_(capacity),
+          shards_(std::make_unique<Padded<std::atomic<uint64_t>>[]>(
+              capacity + 1)) {}
+
+    void add(uint64_t n = 1) {
+        unsigned index = threadIndex();
+        if (index < capacity_) {
+            // 只有本线程写这个分片：不需要原子的读-改-写
+            std::atomic<uint64_t>& shard = *shards_[index];
+            shard.store(shard.load(std::memory_order_relaxed) + n,
+                        std::memory_order_relaxed);
+        } else {
+            shards_[capacity_]->fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t read() const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i <= capacity_; ++i)
+            sum += shards_[i]->load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    size_t capacity_;
+    std::unique_ptr<Padded<std::atomic<uint64_t>>[]> shards_;
+};
+
+class CpuCounter {
+public:
+    CpuCounter()
+        : nshards_(static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF))),
+          shards_(std::make_unique<Padded<std::atomic<uint64_t>>[]>(nshards_)) {
+    }
+
+    void add(uint64_t n = 1) {
+        size_t cpu = static_cast<size_t>(currentCpu());
+        shards_[cpu % nshards_]->fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t read() const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < nshards_; ++i)
+            sum += shards_[i]->load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    size_t nshards_;
+    std::unique_ptr<Padded<std::atomic<uint64_t>>[]> shards_;
+};
@@ -0,0 +1,126 @@
+/**
+ * @brief 多线程计数器的争用测试：共享原子变量、相邻 / 填充的每线程计数器、分片计数器
+ * @details
+ * threads 个线程各自把计数器加 iterations 次，线程数从 1 开始每次乘 2 直到 max_threads。
+ *
+ * atomic      所有线程 fetch_add 同一个 std::atomic，这一行在核之间来回传递
+ * unpadded    每个线程 fetch_add 自己的 std::atomic，但它们挨在一起（伪共享）
+ * padded      每个线程 fetch_add 自己的 Padded<std::atomic>（./sharded.h）
+ * per_thread  ThreadCounter，独占分片，load + store
+ * per_cpu     CpuCounter，按当前 CPU 选择分片，fetch_add
+ *
+ * 报告每秒的总加法次数（百万次），并检查最后的总和。
+ * CPU 数少于线程数时，线程分时运行，伪共享的代价大部分看不出来。
+ *
+ * @note
+ * g++ other/sharded_bench.cpp -o out/a.out --std=c++17 -O2 -lpthread
+ * out/a.out [max_threads=nproc] [iterations=10000000]
+ */
+#include "sharded.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int MAX_THREADS = 256;
+
+// 在 go 变为 true 之后，用 threads 个线程各执行 iterations 次 fn(t)，返回总耗时（秒）
+template <typename Fn>
+double runThreads(int threads, long iterations, Fn fn) {
+    std::atomic<bool> go{false};
+    std::atomic<int> ready{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (long i = 0; i < iterations; ++i)
+                fn(t);
+        });
+    }
+    while (ready.load() != threads)
+        std::this_thread::yield();
+    auto begin = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& th : pool)
+        th.join();
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void check(const char* name, uint64_t sum, uint64_t expect) {
+    if (sum != expect) {
+        fprintf(stderr, "%s: sum %llu, expected %llu\n", name,
+                (unsigned long long)sum, (unsigned long long)expect);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int max_threads = argc > 1 ? atoi(argv[1])
+                               : static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    long iterations = argc > 2 ? atol(argv[2]) : 10000000;
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+
+    printf("rseq %s, cpu %d\n", __rseq_size > 0 ? "registered" : "unavailable",
+           currentCpu());
+    printf("%8s %12s %12s %12s %12s %12s   (M adds/s)\n", "threads", "atomic",
+           "unpadded", "padded", "per_thread", "per_cpu");
+    for (int threads = 1;;
+         threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        uint64_t expect = static_cast<uint64_t>(threads) * iterations;
+        double total = static_cast<double>(expect) / 1e6;
+
+        std::atomic<uint64_t> shared{0};
+        double t_atomic = runThreads(threads, iterations, [&](int) {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        });
+        check("atomic", shared.load(), expect);
+
+        static std::atomic<uint64_t> adjacent[MAX_THREADS];
+        for (auto& a : adjacent)
+            a.store(0);
+        double t_unpadded = runThreads(threads, iterations, [&](int t) {
+            adjacent[t].fetch_add(1, std::memory_order_relaxed);
+        });
+        uint64_t sum = 0;
+        for (auto& a : adjacent)
+            sum += a.load();
+        check("unpadded", sum, expect);
+
+        static Padded<std::atomic<uint64_t>> padded[MAX_THREADS];
+        for (auto& p : padded)
+            p->store(0);
+        double t_padded = runThreads(threads, iterations, [&](int t) {
+            padded[t]->fetch_add(1, std::memory_order_relaxed);
+        });
+        sum = 0;
+        for (auto& p : padded)
+            sum += p->load();
+        check("padded", sum, expect);
+
+        ThreadCounter per_thread;
+        double t_thread = runThreads(threads, iterations,
+                                     [&](int) { per_thread.add(); });
+        check("per_thread", per_thread.read(), expect);
+
+        CpuCounter per_cpu;
+        double t_cpu = runThreads(threads, iterations,
+                                  [&](int) { per_cpu.add(); });
+        check("per_cpu", per_cpu.read(), expect);
+
+        printf("%8d %12.1f %12.1f %12.1f %12.1f %12.1f\n", threads,
+               total / t_atomic, total / t_unpadded, total / t_padded,
+               total / t_thread, total / t_cpu);
+        if (threads == max_threads)
+            break;
+    }
+    return EXIT_SUCCESS;
+}
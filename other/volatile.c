@@ -11,6 +11,9 @@
  * 这样一来， 如果 i 是一个寄存器变量或者表示一个端口数据就容易出错，
  * 所以说 volatile 可以保证对特殊地址的稳定访问。
  *
+ * 另外，testVar 和 waitVar 相邻，由两个线程写入，会发生伪共享，
+ * 填充到独占 cache line 的写法见 ./sharded.h。
+ *
  * @details
  * https://www.runoob.com/w3cnote/c-volatile-keyword.html
  * https://stackoverflow.com/questions/71716095/how-to-change-the-value-of-a-variable-without-the-compiler-knowing/71716449#71716449
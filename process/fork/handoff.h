@@ -0,0 +1,150 @@
+/**
+ * @brief 通过 memfd + SCM_RIGHTS 把大块数据零拷贝地交给子进程
+ * @details
+ * spawnChild() 只能通过 arg_list 传参数，大块数据只能经管道拷贝：
+ * 父进程 write() 一次拷贝进内核，子进程 read() 再拷贝一次。
+ *
+ * 这里父子进程之间有一条 Unix 域套接字（SOCK_SEQPACKET）控制通道：
+ * 1. 父进程 memfdCreate() 得到一块匿名共享内存，直接在里面生成数据；
+ * 2. memfdSeal() 解除映射并加上封印 F_SEAL_WRITE / SHRINK / GROW / SEAL，
+ *    之后任何人都不能再修改、截断它；
+ * 3. sendFd() 用 SCM_RIGHTS 把 fd 连同一个小消息头发给子进程；
+ * 4. 子进程 recvFd() 收到 fd，mapSealed() 检查封印后以只读方式 mmap。
+ * 传递的只是一个 fd，数据页本身不拷贝，多少 GB 都一样。
+ * 封印保证父进程事后不能改写或截断数据，子进程访问时不会遇到 SIGBUS。
+ *
+ * 控制通道的子进程端要在 execve() 后继续存在：
+ * openChannel() 返回的 child_fd 没有 FD_CLOEXEC，把它的编号放进 arg_list，
+ * spawnChild() 之后父进程关闭 child_fd。父进程是多线程时，
+ * 其他线程同时创建的子进程也会继承它。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/memfd_create.2.html
+ * https://man7.org/linux/man-pages/man7/unix.7.html
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr int HANDOFF_SEALS =
+    F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+/**
+ * @brief 创建控制通道
+ * @param child_fd 子进程一端，可以被 execve() 继承
+ * @return 父进程一端（FD_CLOEXEC），失败时打印错误并退出
+ */
+inline int openChannel(int* child_fd) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(sv[1], F_SETFD, 0);
+    *child_fd = sv[1];
+    return sv[0];
+}
+
+/**
+ * @brief 创建 size 字节的 memfd，并映射为可写
+ * @param map 写入可写映射的地址，填好数据后交给 memfdSeal()
+ * @return memfd，失败时打印错误并退出
+ */
+inline int memfdCreate(const char* name, size_t size, void** map) {
+    int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        perror("memfd_create");
+        exit(EXIT_FAILURE);
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) == -1) {
+        perror("ftruncate");
+        exit(EXIT_FAILURE);
+    }
+    *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (*map == MAP_FAILED) {
+        perror("mmap memfd");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// 解除可写映射并封印，之后内容不能再被修改、截断
+inline void memfdSeal(int fd, void* map, size_t size) {
+    // 还存在可写的共享映射时不能加 F_SEAL_WRITE
+    munmap(map, size);
+    if (fcntl(fd, F_ADD_SEALS, HANDOFF_SEALS) == -1) {
+        perror("F_ADD_SEALS");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief 发送一条消息，fd 不为 -1 时随消息一起传递
+ * @return 成功，true；失败，false
+ */
+inline bool sendFd(int sock, int fd, const void* msg, size_t len) {
+    iovec iov{const_cast<void*>(msg), len};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr mh{};
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    if (fd != -1) {
+        mh.msg_control = control;
+        mh.msg_controllen = sizeof(control);
+        cmsghdr* cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    return sendmsg(sock, &mh, MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+}
+
+/**
+ * @brief 接收一条消息
+ * @param fd 写入随消息传来的 fd（FD_CLOEXEC），没有时为 -1
+ * @return 消息长度；对端关闭时返回 0；失败返回 -1
+ */
+inline ssize_t recvFd(int sock, int* fd, void* msg, size_t len) {
+    iovec iov{msg, len};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr mh{};
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control;
+    mh.msg_controllen = sizeof(control);
+    *fd = -1;
+    ssize_t n = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+    if (n <= 0)
+        return n;
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm != nullptr;
+         cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+            memcpy(fd, CMSG_DATA(cm), sizeof(int));
+    }
+    return n;
+}
+
+/**
+ * @brief 检查 fd 已被封印，并以只读方式映射
+ * @param size 写入数据大小
+ * @return 映射地址；没有封印、大小为 0 或映射失败时返回 nullptr
+ */
+inline const void* mapSealed(int fd, size_t* size) {
+    int seals = fcntl(fd, F_GET_SEALS);
+    struct stat st;
+    if (seals == -1 || (seals & HANDOFF_SEALS) != HANDOFF_SEALS ||
+        fstat(fd, &st) == -1)
+        return nullptr;
+    *size = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, *size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
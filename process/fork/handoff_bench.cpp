@@ -0,0 +1,213 @@
+/**
+ * @brief 比较 memfd + SCM_RIGHTS 与管道把数据交给子进程的延迟
+ * @details
+ * 父进程用 spawnChild() 以 posix_spawn 方式执行自己（--child），
+ * 通过 ./handoff.h 的控制通道与子进程通信。负载从 4 KB 增长到 max_mb，每次乘 4：
+ *
+ * memfd  父进程在 memfd 中生成数据、封印，发送 fd；
+ *        子进程检查封印、只读映射、计算校验和后回复。
+ * pipe   父进程先通过控制通道告诉子进程长度，再把数据写进管道；
+ *        子进程读到自己的缓冲区、计算校验和后回复。
+ *
+ * 生成数据不计时，计时从发送开始，到收到子进程的回复为止。
+ * 校验和只取每页的第一个 uint64_t，两种方式都要访问到每一页。
+ *
+ * @note
+ * g++ process/fork/handoff_bench.cpp -o out/handoff_bench --std=c++17 -O2
+ * out/handoff_bench [max_mb=1024]
+ */
+#include "../../benchmark/bench.h"
+#include "handoff.h"
+#include "spawn.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+constexpr size_t PAGE = 4096;
+constexpr size_t KB = 1024;
+
+struct Request {
+    uint64_t size;
+    int32_t via_pipe; // 1：数据随后从管道到达，fd 是管道读端
+};
+
+// 每页第一个 uint64_t 写入页号
+void fillPages(char* p, size_t size) {
+    for (size_t off = 0; off < size; off += PAGE) {
+        uint64_t index = off / PAGE;
+        memcpy(p + off, &index, sizeof(index));
+    }
+}
+
+uint64_t checksum(const char* p, size_t size) {
+    uint64_t sum = 0;
+    for (size_t off = 0; off < size; off += PAGE) {
+        uint64_t v;
+        memcpy(&v, p + off, sizeof(v));
+        sum += v;
+    }
+    return sum;
+}
+
+uint64_t expectedChecksum(size_t size) {
+    uint64_t pages = (size + PAGE - 1) / PAGE;
+    return pages * (pages - 1) / 2;
+}
+
+// 子进程：处理请求直到控制通道关闭
+int childMain(int sock) {
+    std::vector<char> buf;
+    int pipe_rd = -1;
+    Request req;
+    int fd;
+    ssize_t n;
+    while ((n = recvFd(sock, &fd, &req, sizeof(req))) == sizeof(req)) {
+        uint64_t sum = 0;
+        if (req.via_pipe) {
+            if (fd != -1) {
+                if (pipe_rd != -1)
+                    close(pipe_rd);
+                pipe_rd = fd;
+            }
+            if (buf.size() < req.size)
+                buf.resize(req.size);
+            size_t got = 0;
+            while (got < req.size) {
+                ssize_t r = read(pipe_rd, buf.data() + got, req.size - got);
+                if (r <= 0) {
+                    perror("child read");
+                    return EXIT_FAILURE;
+                }
+                got += static_cast<size_t>(r);
+            }
+            sum = checksum(buf.data(), req.size);
+        } else {
+            size_t size;
+            const void* p = mapSealed(fd, &size);
+            if (p == nullptr || size != req.size) {
+                fprintf(stderr, "child: memfd not sealed or wrong size\n");
+                return EXIT_FAILURE;
+            }
+            sum = checksum(static_cast<const char*>(p), size);
+            munmap(const_cast<void*>(p), size);
+            close(fd);
+        }
+        if (!sendFd(sock, -1, &sum, sizeof(sum))) {
+            perror("child send");
+            return EXIT_FAILURE;
+        }
+    }
+    return n == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void checkReply(int sock, size_t size) {
+    uint64_t sum;
+    int fd;
+    if (recvFd(sock, &fd, &sum, sizeof(sum)) != sizeof(sum)) {
+        perror("recv reply");
+        exit(EXIT_FAILURE);
+    }
+    if (sum != expectedChecksum(size)) {
+        fprintf(stderr, "size %zu: wrong checksum\n", size);
+        exit(EXIT_FAILURE);
+    }
+}
+
+double handoffMemfd(int sock, size_t size) {
+    void* map;
+    int fd = memfdCreate("payload", size, &map);
+    fillPages(static_cast<char*>(map), size);
+
+    uint64_t begin = bench_tsc_begin();
+    memfdSeal(fd, map, size);
+    Request req{size, 0};
+    if (!sendFd(sock, fd, &req, sizeof(req))) {
+        perror("sendmsg");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+    checkReply(sock, size);
+    return (bench_tsc_end() - begin) / bench_tsc_ghz;
+}
+
+double handoffPipe(int sock, int pipe_wr, int pipe_rd, const char* buf,
+                   size_t size, bool first) {
+    uint64_t begin = bench_tsc_begin();
+    Request req{size, 1};
+    // 管道读端只需要交给子进程一次
+    if (!sendFd(sock, first ? pipe_rd : -1, &req, sizeof(req))) {
+        perror("sendmsg");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t done = 0; done < size;) {
+        ssize_t n = write(pipe_wr, buf + done, size - done);
+        if (n == -1) {
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        done += static_cast<size_t>(n);
+    }
+    checkReply(sock, size);
+    return (bench_tsc_end() - begin) / bench_tsc_ghz;
+}
+
+double median(std::vector<double>& v) {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--child") == 0)
+        return childMain(atoi(argv[2]));
+
+    size_t max_mb = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1024;
+    size_t max_size = max_mb * KB * KB;
+
+    int child_fd;
+    int sock = openChannel(&child_fd);
+    std::string fd_arg = std::to_string(child_fd);
+    char* arg_list[] = {const_cast<char*>("handoff_bench"),
+                        const_cast<char*>("--child"), fd_arg.data(), nullptr};
+    pid_t child = spawnChild("/proc/self/exe", arg_list, SpawnMode::PosixSpawn);
+    close(child_fd);
+
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC) == -1) {
+        perror("pipe2");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(pipefd[1], F_SETPIPE_SZ, 1 << 20);
+
+    bench_init(nullptr);
+    std::vector<char> buf(max_size);
+    fillPages(buf.data(), max_size);
+
+    printf("%10s %6s %14s %14s %10s %10s %8s\n", "size_kb", "reps",
+           "memfd_us", "pipe_us", "memfd_GBs", "pipe_GBs", "speedup");
+    bool first = true;
+    for (size_t size = 4 * KB; size <= max_size; size *= 4) {
+        // 小负载多测几次，大负载至少 5 次
+        size_t reps = std::clamp<size_t>((64 * KB * KB) / size, 5, 200);
+        std::vector<double> memfd_ns, pipe_ns;
+        for (size_t i = 0; i < reps; ++i) {
+            memfd_ns.push_back(handoffMemfd(sock, size));
+            pipe_ns.push_back(handoffPipe(sock, pipefd[1], pipefd[0],
+                                          buf.data(), size, first));
+            first = false;
+        }
+        double m = median(memfd_ns), p = median(pipe_ns);
+        printf("%10zu %6zu %14.1f %14.1f %10.2f %10.2f %7.1fx\n", size / KB,
+               reps, m / 1e3, p / 1e3, size / m, size / p, p / m);
+    }
+
+    close(sock);
+    int status;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
@@ -0,0 +1,399 @@
+/**
+ * @brief 进程池 ProcessPool：共享内存任务队列、工作窃取、崩溃后重新排队
+ * @details
+ * ./second_parent.cpp、./third.cpp 里的 FORK_NUM 个子进程除了等 SIGTERM 什么都不做。
+ * ProcessPool 把 fork 出的子进程变成真正的工作进程：
+ *
+ * 任务队列
+ *      每个工作进程一个 MpmcRing（../../interprocess-communications/shm/ring.h），
+ *      放在 MAP_SHARED 内存中。父进程 submit() 时放进最空的队列。
+ * 工作窃取
+ *      工作进程自己的队列空了，就从当前最满的队列里取一个任务。
+ * 完成队列
+ *      所有工作进程共用一个 MpmcRing，父进程在 poll() / wait() 中取出结果，
+ *      交给构造时传入的 on_complete 回调。
+ * 背压
+ *      所有任务队列都满时 submit() 不返回，一边处理完成队列一边等待空位；
+ *      完成队列满时工作进程在 futex 上等父进程取走结果。
+ * 崩溃恢复
+ *      每个工作进程在共享内存中记录正在执行的任务（state + entry）。
+ *      ./reaper.h 通过 pidfd 发现工作进程异常退出后，父进程先取完完成队列，
+ *      如果它死在 RUNNING 状态，就把记录的任务重新排队，再 fork 一个新的工作进程。
+ *      死在 CLAIMING（刚从队列取出、还没来得及记录，只有几条指令）时，
+ *      那个任务可能丢失：等到所有队列都空、所有工作进程都空闲时，
+ *      父进程把仍未完成的任务全部重新排队。
+ *      父进程按任务 id 记录未完成的任务，重复的完成结果会被忽略。
+ *      同一个任务让工作进程崩溃 POOL_MAX_CRASHES 次之后不再排队，
+ *      而是调用 on_failed(id, 最后一次的 siginfo_t) 作为它的结果，避免无限重启。
+ *      MpmcRing 本身不是“健壮”的：死在队列操作内部（CAS 之后、发布序号之前）
+ *      会让那个槽位永远卡住，这里不处理这种情况。
+ *
+ * 工作进程由 fork() 创建，直接运行 fn，不执行 execve()。
+ * Task 和 Result 必须可平凡拷贝，且不能包含指针。父进程的方法不是线程安全的。
+ *
+ * @details
+ * https://en.wikipedia.org/wiki/Work_stealing
+ */
+#pragma once
+
+#include "../../interprocess-communications/shm/ring.h"
+#include "reaper.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr int POOL_MAX_WORKERS = 64;
+constexpr size_t POOL_QUEUE = 256;        // 每个工作进程的任务队列长度
+constexpr size_t POOL_COMPLETIONS = 4096; // 完成队列长度
+// 父进程等待完成队列时，每隔多久检查一次工作进程是否退出
+constexpr int POOL_CHECK_MS = 10;
+// 一个任务最多让工作进程崩溃几次，之后认为任务本身有问题
+constexpr int POOL_MAX_CRASHES = 3;
+
+template <typename Task, typename Result>
+class ProcessPool {
+    static_assert(std::is_trivially_copyable_v<Task>);
+    static_assert(std::is_trivially_copyable_v<Result>);
+
+public:
+    using Fn = Result (*)(const Task&);
+    using OnComplete = std::function<void(uint64_t id, const Result&)>;
+    using OnFailed = std::function<void(uint64_t id, const siginfo_t& info)>;
+
+    struct Stats {
+        uint64_t steals;   // 工作进程从别人的队列取到的任务数
+        uint64_t crashes;  // 异常退出的工作进程数
+        uint64_t requeued; // 重新排队的任务数
+        uint64_t failed;   // 崩溃次数过多而放弃的任务数
+    };
+
+    /**
+     * @brief fork 出 workers 个工作进程，每个任务在工作进程中执行 fn(task)
+     * @param on_complete 父进程取到结果时调用
+     * @param on_failed 任务放弃时调用，为空时在 stderr 打印一行
+     */
+    ProcessPool(int workers, Fn fn, OnComplete on_complete,
+                OnFailed on_failed = nullptr)
+        : nworkers_(workers), fn_(fn), on_complete_(std::move(on_complete)),
+          on_failed_(std::move(on_failed)) {
+        if (workers < 1 || workers > POOL_MAX_WORKERS) {
+            fprintf(stderr, "ProcessPool: workers must be 1..%d\n",
+                    POOL_MAX_WORKERS);
+            exit(EXIT_FAILURE);
+        }
+        shared_ = createShared<Shared>();
+        pids_.assign(workers, -1);
+        for (int w = 0; w < workers; ++w)
+            startWorker(w);
+    }
+
+    ~ProcessPool() {
+        shutdown();
+        destroyShared(shared_);
+    }
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    // 提交一个任务，返回任务 id；队列全满时阻塞（背压）
+    uint64_t submit(const Task& task) {
+        Entry e{next_id_++, task};
+        outstanding_.emplace(e.id, Pending{task, 0});
+        while (!backlog_.empty() || !place(e)) {
+            if (!backlog_.empty() && place(backlog_.front())) {
+                backlog_.pop_front();
+                continue;
+            }
+            waitCompletions();
+        }
+        return e.id;
+    }
+
+    // 处理已经到达的结果，返回处理的个数
+    size_t poll() {
+        flushBacklog();
+        size_t n = drain();
+        if (++polls_ % 64 == 0)
+            checkWorkers(0);
+        return n;
+    }
+
+    // 等待所有已提交的任务完成
+    void wait() {
+        while (!outstanding_.empty()) {
+            flushBacklog();
+            waitCompletions();
+        }
+    }
+
+    // 还没有完成的任务数
+    size_t pending() const { return outstanding_.size(); }
+
+    Stats stats() const {
+        Stats s{0, crashes_, requeued_, failed_};
+        for (int w = 0; w < nworkers_; ++w)
+            s.steals += shared_->slots[w].steals.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // 工作进程 w 的 pid（用于测试崩溃恢复）
+    pid_t workerPid(int w) const { return pids_[w]; }
+
+    // 等待队列中的任务做完，然后让所有工作进程退出并回收
+    void shutdown() {
+        if (shared_->shutdown.load(std::memory_order_relaxed))
+            return;
+        wait();
+        shared_->shutdown.store(1, std::memory_order_seq_cst);
+        shared_->work.seq.fetch_add(1, std::memory_order_release);
+        futexWake(&shared_->work.seq, INT_MAX);
+        while (reaper_.size() > 0)
+            reaper_.poll(-1, [](pid_t, const siginfo_t&) {});
+    }
+
+private:
+    enum : uint32_t { IDLE, CLAIMING, RUNNING };
+
+    struct Entry {
+        uint64_t id;
+        Task task;
+    };
+
+    struct Completion {
+        uint64_t id;
+        Result result;
+    };
+
+    struct Pending {
+        Task task;
+        int crashes; // 执行它的工作进程崩溃的次数
+    };
+
+    struct alignas(CACHE_LINE) Slot {
+        std::atomic<uint32_t> state{IDLE};
+        Entry entry; // state 为 RUNNING 时有效
+        std::atomic<uint64_t> steals{0};
+        MpmcRing<Entry, POOL_QUEUE> queue;
+    };
+
+    struct Shared {
+        WaitPoint work; // 有新任务或要退出
+        std::atomic<uint32_t> shutdown{0};
+        MpmcRing<Completion, POOL_COMPLETIONS> completions;
+        Slot slots[POOL_MAX_WORKERS];
+    };
+
+    void startWorker(int w) {
+        shared_->slots[w].state.store(IDLE, std::memory_order_relaxed);
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0)
+            workerMain(w);
+        pids_[w] = pid;
+        reaper_.add(pid);
+    }
+
+    bool anyQueued() const {
+        for (int w = 0; w < nworkers_; ++w) {
+            if (!shared_->slots[w].queue.empty())
+                return true;
+        }
+        return false;
+    }
+
+    // 从最满的队列里偷一个任务
+    bool steal(int self, Entry& e) {
+        int victim = -1;
+        size_t most = 0;
+        for (int w = 0; w < nworkers_; ++w) {
+            size_t n = shared_->slots[w].queue.size();
+            if (w != self && n > most) {
+                most = n;
+                victim = w;
+            }
+        }
+        return victim != -1 && shared_->slots[victim].queue.tryPop(e);
+    }
+
+    [[noreturn]] void workerMain(int self) {
+        Slot& slot = shared_->slots[self];
+        Entry e;
+        for (;;) {
+            // 先声明“正在取任务”，再取；崩溃在两者之间时父进程能看出来
+            slot.state.store(CLAIMING, std::memory_order_seq_cst);
+            bool stolen = false;
+            bool got = slot.queue.tryPop(e) || (stolen = steal(self, e));
+            if (got) {
+                slot.entry = e;
+                slot.state.store(RUNNING, std::memory_order_release);
+                if (stolen)
+                    slot.steals.fetch_add(1, std::memory_order_relaxed);
+                Completion c{e.id, fn_(e.task)};
+                shared_->completions.push(c);
+                slot.state.store(IDLE, std::memory_order_release);
+                continue;
+            }
+            slot.state.store(IDLE, std::memory_order_seq_cst);
+            if (shared_->shutdown.load(std::memory_order_acquire))
+                _exit(EXIT_SUCCESS);
+            shared_->work.wait([this] {
+                return anyQueued() ||
+                       shared_->shutdown.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    // 放进最空的队列，全满时返回 false
+    bool place(const Entry& e) {
+        int best = 0;
+        size_t least = SIZE_MAX;
+        for (int w = 0; w < nworkers_; ++w) {
+            size_t n = shared_->slots[w].queue.size();
+            if (n < least) {
+                least = n;
+                best = w;
+            }
+        }
+        for (int i = 0; i < nworkers_; ++i) {
+            int w = (best + i) % nworkers_;
+            if (shared_->slots[w].queue.tryPush(e)) {
+                shared_->work.notify(nworkers_);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void flushBacklog() {
+        while (!backlog_.empty() && place(backlog_.front()))
+            backlog_.pop_front();
+    }
+
+    void complete(const Completion& c) {
+        // 重新排队的任务可能已经完成过一次
+        if (outstanding_.erase(c.id) == 1)
+            on_complete_(c.id, c.result);
+    }
+
+    size_t drain() {
+        size_t n = 0;
+        Completion c;
+        while (shared_->completions.tryPop(c)) {
+            complete(c);
+            ++n;
+        }
+        return n;
+    }
+
+    // 等到至少一个结果，或者超时后检查工作进程
+    void waitCompletions() {
+        if (drain() > 0) {
+            if (++polls_ % 64 == 0)
+                checkWorkers(0);
+            return;
+        }
+        Completion c;
+        if (shared_->completions.popFor(c, POOL_CHECK_MS)) {
+            complete(c);
+            drain();
+            return;
+        }
+        checkWorkers(0);
+    }
+
+    void requeue(const Entry& e) {
+        ++requeued_;
+        backlog_.push_back(e);
+    }
+
+    // 放弃一个反复让工作进程崩溃的任务
+    void fail(uint64_t id, const siginfo_t& info) {
+        ++failed_;
+        outstanding_.erase(id);
+        if (on_failed_)
+            on_failed_(id, info);
+        else
+            fprintf(stderr,
+                    "ProcessPool: task %llu crashed its worker %d times, "
+                    "giving up\n",
+                    static_cast<unsigned long long>(id), POOL_MAX_CRASHES);
+    }
+
+    // 回收退出的工作进程并重启；它正在执行的任务重新排队，崩溃次数到上限则放弃
+    void checkWorkers(int timeout_ms) {
+        std::vector<std::pair<int, siginfo_t>> dead;
+        reaper_.poll(timeout_ms, [&](pid_t pid, const siginfo_t& info) {
+            for (int w = 0; w < nworkers_; ++w) {
+                if (pids_[w] == pid)
+                    dead.emplace_back(w, info);
+            }
+        });
+        if (!dead.empty()) {
+            // 先取完结果：崩溃前已经完成的任务不应重新排队
+            drain();
+            for (const auto& [w, info] : dead) {
+                ++crashes_;
+                Slot& slot = shared_->slots[w];
+                uint32_t state = slot.state.load(std::memory_order_acquire);
+                auto it = state == RUNNING ? outstanding_.find(slot.entry.id)
+                                           : outstanding_.end();
+                if (it != outstanding_.end()) {
+                    if (++it->second.crashes >= POOL_MAX_CRASHES)
+                        fail(slot.entry.id, info);
+                    else
+                        requeue(slot.entry);
+                } else if (state == CLAIMING)
+                    reconcile_ = true;
+                startWorker(w);
+            }
+        }
+        if (reconcile_)
+            reconcile();
+    }
+
+    /**
+     * 所有队列都空、所有工作进程都空闲时，还没完成的任务只可能已经丢失。
+     * 顺序很重要：先看队列（之后没有新任务进入），再看状态，最后取完结果。
+     */
+    void reconcile() {
+        if (!backlog_.empty() || anyQueued())
+            return;
+        for (int w = 0; w < nworkers_; ++w) {
+            if (shared_->slots[w].state.load(std::memory_order_seq_cst) !=
+                IDLE)
+                return;
+        }
+        drain();
+        for (const auto& [id, pending] : outstanding_)
+            requeue(Entry{id, pending.task});
+        reconcile_ = false;
+        flushBacklog();
+    }
+
+    int nworkers_;
+    Fn fn_;
+    OnComplete on_complete_;
+    OnFailed on_failed_;
+    Shared* shared_ = nullptr;
+    Reaper reaper_;
+    std::vector<pid_t> pids_;
+    std::unordered_map<uint64_t, Pending> outstanding_;
+    std::deque<Entry> backlog_; // 重新排队、暂时放不进队列的任务
+    uint64_t next_id_ = 0;
+    uint64_t polls_ = 0;
+    uint64_t crashes_ = 0;
+    uint64_t requeued_ = 0;
+    uint64_t failed_ = 0;
+    bool reconcile_ = false;
+};
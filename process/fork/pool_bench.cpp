@@ -0,0 +1,165 @@
+/**
+ * @brief ./pool.h 进程池的扩展性与崩溃恢复测试
+ * @details
+ * 任务是固定数量的计算，单独运行时约需 spin_ns 纳秒
+ * （启动时校准；不按截止时间忙等，否则分时运行的任务也会“同时”完成）：
+ * small  约 1 微秒，small_tasks 个，主要看队列和调度开销
+ * large  约 10 毫秒，large_tasks 个，主要看能否用满所有核
+ * 工作进程数从 1 开始每次乘 2，直到 max_workers（默认为 CPU 数），
+ * 报告每秒完成的任务数和相对 1 个工作进程的加速比。
+ *
+ * 崩溃测试：一个任务在第一次执行时 abort()，同时父进程中途 SIGKILL 一个工作进程，
+ * 检查每个任务恰好完成一次；另一个任务每次执行都 abort()，
+ * 检查它在 POOL_MAX_CRASHES 次崩溃后以 on_failed 结束，而不是无限重启。
+ *
+ * @note
+ * g++ process/fork/pool_bench.cpp -o out/pool_bench --std=c++17 -O2
+ * out/pool_bench [max_workers=nproc] [small_tasks=200000] [large_tasks=64]
+ */
+#include "../../benchmark/bench.h"
+#include "pool.h"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+struct Task {
+    uint64_t spin_ns;
+    uint32_t crash; // 为 CRASH_ONCE 时第一次执行会 abort()，CRASH_ALWAYS 时每次都会
+};
+
+enum : uint32_t { CRASH_NEVER, CRASH_ONCE, CRASH_ALWAYS };
+
+struct Result {
+    uint64_t value;
+};
+
+static double iters_per_ns; // spin() 每纳秒的迭代次数
+
+uint64_t spin(uint64_t iters) {
+    uint64_t x = iters;
+    for (uint64_t i = 0; i < iters; ++i)
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x;
+}
+
+void calibrateSpin() {
+    const uint64_t iters = 10000000;
+    double begin = bench_now_ns();
+    volatile uint64_t sink = spin(iters);
+    (void)sink;
+    iters_per_ns = iters / (bench_now_ns() - begin);
+}
+
+// 所有进程共享，保证带 crash 的任务只崩溃一次
+static std::atomic<uint32_t>* crashed_once;
+
+Result runTask(const Task& task) {
+    if (task.crash == CRASH_ALWAYS ||
+        (task.crash == CRASH_ONCE && crashed_once->exchange(1) == 0))
+        abort();
+    return Result{spin(static_cast<uint64_t>(task.spin_ns * iters_per_ns))};
+}
+
+// 提交 count 个任务并等待全部完成，返回每秒完成的任务数
+double throughput(int workers, uint64_t spin_ns, int count) {
+    long done = 0;
+    ProcessPool<Task, Result> pool(workers, runTask,
+                                   [&](uint64_t, const Result&) { ++done; });
+    double begin = bench_now_ns();
+    for (int i = 0; i < count; ++i)
+        pool.submit(Task{spin_ns, CRASH_NEVER});
+    pool.wait();
+    double elapsed = bench_now_ns() - begin;
+    if (done != count) {
+        fprintf(stderr, "completed %ld of %d tasks\n", done, count);
+        exit(EXIT_FAILURE);
+    }
+    return count / elapsed * 1e9;
+}
+
+void crashTest(int workers) {
+    const int count = 2000;
+    const int poison = count / 3;
+    std::vector<int> completed(count, 0);
+    std::vector<int> failed(count, 0);
+    ProcessPool<Task, Result> pool(
+        workers, runTask,
+        [&](uint64_t id, const Result&) { ++completed[id]; },
+        [&](uint64_t id, const siginfo_t& info) {
+            if (info.si_code == CLD_DUMPED || info.si_code == CLD_KILLED)
+                ++failed[id];
+        });
+    for (int i = 0; i < count; ++i) {
+        uint32_t crash = i == count / 4 ? CRASH_ONCE
+                         : i == poison  ? CRASH_ALWAYS
+                                        : CRASH_NEVER;
+        pool.submit(Task{100000, crash});
+        if (i == count / 2)
+            kill(pool.workerPid(0), SIGKILL);
+    }
+    pool.wait();
+
+    if (completed[poison] != 0 || failed[poison] != 1) {
+        fprintf(stderr, "poison task completed %d times, failed %d times\n",
+                completed[poison], failed[poison]);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (i == poison)
+            continue;
+        if (completed[i] != 1 || failed[i] != 0) {
+            fprintf(stderr, "task %d completed %d times, failed %d times\n",
+                    i, completed[i], failed[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    auto s = pool.stats();
+    printf("crash test: %d workers, %d tasks each completed once, "
+           "1 failed after %d crashes; crashes %llu, requeued %llu, "
+           "failed %llu, steals %llu\n",
+           workers, count - 1, POOL_MAX_CRASHES,
+           (unsigned long long)s.crashes, (unsigned long long)s.requeued,
+           (unsigned long long)s.failed, (unsigned long long)s.steals);
+}
+
+int main(int argc, char* argv[]) {
+    int max_workers = argc > 1 ? atoi(argv[1])
+                               : static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    int small_tasks = argc > 2 ? atoi(argv[2]) : 200000;
+    int large_tasks = argc > 3 ? atoi(argv[3]) : 64;
+    if (max_workers > POOL_MAX_WORKERS)
+        max_workers = POOL_MAX_WORKERS;
+
+    bench_init(nullptr);
+    calibrateSpin();
+    crashed_once = static_cast<std::atomic<uint32_t>*>(
+        mmap(nullptr, sizeof(std::atomic<uint32_t>), PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (crashed_once == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%8s %16s %8s %16s %8s\n", "workers", "small_tasks_per_s", "speedup",
+           "large_tasks_per_s", "speedup");
+    double small_base = 0, large_base = 0;
+    for (int w = 1;; w = w * 2 < max_workers ? w * 2 : max_workers) {
+        double small = throughput(w, 1000, small_tasks);
+        double large = throughput(w, 10000000, large_tasks);
+        if (w == 1) {
+            small_base = small;
+            large_base = large;
+        }
+        printf("%8d %16.0f %7.2fx %16.1f %7.2fx\n", w, small,
+               small / small_base, large, large / large_base);
+        if (w == max_workers)
+            break;
+    }
+
+    crashTest(max_workers > 1 ? max_workers : 2);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+/**
+ * @brief 基于 pidfd + epoll 的子进程回收器 Reaper
+ * @details
+ * 每个子进程对应一个 pidfd（pidfd_open 或 clone3(CLONE_PIDFD) 得到），
+ * 子进程退出时 pidfd 变为可读。所有 pidfd 注册在同一个 epoll 上，
+ * epoll_event.data 里存的是槽位下标，一个退出事件只需要 O(1) 的工作：
+ * waitid(P_PIDFD) 回收、关闭 pidfd、槽位放回空闲链表。
+ * 回收时顺便取得子进程的 struct rusage，on_exit 回调期间可以用 usage() 读出。
+ * 一次 epoll_wait() 可以批量拿到许多退出事件。
+ *
+ * 进程自己关心的信号（例如 SIGINT / SIGTERM）通过 watchSignals()
+ * 转成 signalfd 挂到同一个 epoll 上，在普通上下文里处理，
+ * 不需要在信号处理函数里做任何非异步信号安全的事情。
+ *
+ * shutdown() 先用 pidfd_send_signal() 一次性给所有子进程发信号，
+ * 再统一等待；超过期限还没退出的子进程改发 SIGKILL。
+ * 通过 pidfd 发信号，不会因为 pid 被复用而误杀其他进程。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/pidfd_open.2.html
+ * https://man7.org/linux/man-pages/man2/pidfd_send_signal.2.html
+ */
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+// 直接使用系统调用：glibc 2.36 的 <sys/pidfd.h> 在 C++ 中无法链接
+inline int pidfdOpen(pid_t pid) {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+inline int pidfdSendSignal(int pidfd, int sig) {
+    return static_cast<int>(
+        syscall(SYS_pidfd_send_signal, pidfd, sig, nullptr, 0));
+}
+
+// 系统调用 waitid 的第五个参数是 rusage，glibc 的包装函数没有暴露它
+inline int waitidUsage(idtype_t idtype, id_t id, siginfo_t* info, int options,
+                       rusage* usage) {
+    return static_cast<int>(
+        syscall(SYS_waitid, idtype, id, info, options, usage));
+}
+
+class Reaper {
+public:
+    // 回调参数：退出的子进程 pid，以及 waitid() 得到的 siginfo
+    using ExitInfo = siginfo_t;
+
+    Reaper() {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd_ == -1) {
+            perror("epoll_create1");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ~Reaper() {
+        for (const Slot& slot : slots_) {
+            if (slot.pidfd != -1)
+                close(slot.pidfd);
+        }
+        if (sigfd_ != -1)
+            close(sigfd_);
+        close(epfd_);
+    }
+
+    Reaper(const Reaper&) = delete;
+    Reaper& operator=(const Reaper&) = delete;
+
+    /**
+     * @brief 开始跟踪子进程 pid
+     * @param pidfd 已有的 pidfd（例如 clone3 返回的），为 -1 时调用 pidfd_open
+     */
+    void add(pid_t pid, int pidfd = -1) {
+        if (pidfd == -1)
+            pidfd = pidfdOpen(pid);
+        if (pidfd == -1) {
+            perror("pidfd_open");
+            exit(EXIT_FAILURE);
+        }
+
+        uint32_t index;
+        if (free_ != NONE) {
+            index = free_;
+            free_ = slots_[index].next_free;
+        } else {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(Slot{});
+        }
+        slots_[index] = Slot{pid, pidfd, NONE};
+
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = index;
+        if (epoll_ctl(epfd_, EPOLL_CTL_ADD, pidfd, &ev) == -1) {
+            perror("epoll_ctl");
+            exit(EXIT_FAILURE);
+        }
+        ++live_;
+    }
+
+    // 屏蔽 mask 中的信号，改为通过 takeSignal() 取出
+    void watchSignals(const sigset_t& mask) {
+        if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
+            perror("sigprocmask");
+            exit(EXIT_FAILURE);
+        }
+        sigfd_ = signalfd(sigfd_, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (sigfd_ == -1) {
+            perror("signalfd");
+            exit(EXIT_FAILURE);
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = SIGNAL_TAG;
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, sigfd_, &ev);
+    }
+
+    // 返回 poll() 期间到达的被监视信号并清除它，没有时返回 0
+    int takeSignal() {
+        int sig = pending_signal_;
+        pending_signal_ = 0;
+        return sig;
+    }
+
+    // 正在回调的子进程的资源使用，只在 on_exit 期间有效
+    const rusage& usage() const { return usage_; }
+
+    // 仍在运行（尚未回收）的子进程个数
+    size_t size() const { return live_; }
+
+    /**
+     * @brief 等待事件并回收已退出的子进程
+     * @param timeout_ms 传给 epoll_wait()，-1 表示一直等
+     * @param on_exit 对每个回收的子进程调用 on_exit(pid, info)
+     * @return 本次回收的子进程个数；被监视的信号到达时也会返回
+     */
+    template <typename OnExit>
+    int poll(int timeout_ms, OnExit on_exit) {
+        epoll_event events[MAX_EVENTS];
+        int n = epoll_wait(epfd_, events, MAX_EVENTS, timeout_ms);
+        if (n == -1) {
+            if (errno == EINTR)
+                return 0;
+            perror("epoll_wait");
+            exit(EXIT_FAILURE);
+        }
+
+        int reaped = 0;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == SIGNAL_TAG) {
+                signalfd_siginfo info;
+                while (read(sigfd_, &info, sizeof(info)) == sizeof(info))
+                    pending_signal_ = static_cast<int>(info.ssi_signo);
+                continue;
+            }
+            reap(static_cast<uint32_t>(events[i].data.u64), on_exit);
+            ++reaped;
+        }
+        return reaped;
+    }
+
+    /**
+     * @brief 结束所有子进程
+     * @details
+     * 先给所有子进程发 sig，在 deadline 内回收；
+     * 期限到了还没退出的发 SIGKILL，再全部回收。
+     */
+    template <typename OnExit>
+    void shutdown(int sig, std::chrono::milliseconds deadline,
+                  OnExit on_exit) {
+        signalAll(sig);
+
+        using Clock = std::chrono::steady_clock;
+        auto until = Clock::now() + deadline;
+        while (live_ > 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                until - Clock::now());
+            if (left.count() <= 0)
+                break;
+            poll(static_cast<int>(left.count()), on_exit);
+        }
+
+        if (live_ > 0) {
+            signalAll(SIGKILL);
+            while (live_ > 0)
+                poll(-1, on_exit);
+        }
+    }
+
+    // 通过 pidfd 给所有仍在跟踪的子进程发送 sig
+    void signalAll(int sig) {
+        for (const Slot& slot : slots_) {
+            if (slot.pidfd != -1)
+                pidfdSendSignal(slot.pidfd, sig);
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint64_t SIGNAL_TAG = UINT64_MAX;
+    static constexpr int MAX_EVENTS = 256;
+
+    struct Slot {
+        pid_t pid = -1;
+        int pidfd = -1;
+        uint32_t next_free = NONE;
+    };
+
+    template <typename OnExit>
+    void reap(uint32_t index, OnExit& on_exit) {
+        Slot& slot = slots_[index];
+        ExitInfo info{};
+        if (waitidUsage(static_cast<idtype_t>(P_PIDFD), slot.pidfd, &info,
+                        WEXITED, &usage_) == -1) {
+            perror("waitid");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = slot.pid;
+        // 之后 fork 的子进程可能继承了这个 pidfd，只 close() 不会把它从 epoll 中移除
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, slot.pidfd, nullptr);
+        close(slot.pidfd);
+        slot = Slot{-1, -1, free_};
+        free_ = index;
+        --live_;
+        on_exit(pid, info);
+    }
+
+    int epfd_ = -1;
+    int sigfd_ = -1;
+    int pending_signal_ = 0;
+    rusage usage_{};
+    std::vector<Slot> slots_;
+    uint32_t free_ = NONE;
+    size_t live_ = 0;
+};
@@ -0,0 +1,174 @@
+/**
+ * @brief Reaper（pidfd + epoll）与 kill + wait 循环的对比
+ * @details
+ * 创建 children 个子进程（默认 10000），子进程 pause() 等待信号。
+ *
+ * 1. 单个退出的回收延迟：其余子进程都活着，每次结束一个，
+ *    测从 kill() 到回收完成的时间。
+ *    wait() 在内核里要遍历整个子进程链表，子进程越多越慢；
+ *    Reaper 只处理 epoll 报告的那一个 pidfd。
+ * 2. 全部关闭：kill 循环 + wait 循环，与 Reaper::shutdown() 比较总耗时。
+ * 3. 有 1% 的子进程忽略 SIGTERM 时，Reaper::shutdown() 在期限后改发 SIGKILL。
+ *
+ * 每个子进程占用父进程一个 pidfd：启动时把 RLIMIT_NOFILE 的软限制提到硬限制，
+ * 仍然不够时减少 children 并打印提示。子进程设置 PR_SET_PDEATHSIG，
+ * 父进程中途出错退出时它们随之结束，不会留下孤儿。
+ *
+ * @note
+ * g++ process/fork/reaper_bench.cpp -o out/a.out --std=c++17 -O2
+ * out/a.out [children=10000]
+ */
+#include "reaper.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+constexpr int SAMPLES = 200;
+constexpr std::chrono::milliseconds DEADLINE(200);
+constexpr int SPARE_FDS = 64; // pidfd 之外：标准流、epoll 等
+
+double elapsedUs(Clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - since)
+        .count();
+}
+
+// 创建 n 个等待信号的子进程，每 stubborn_every 个中有一个忽略 SIGTERM
+vector<pid_t> spawnSleepers(int n, int stubborn_every = 0) {
+    vector<pid_t> pids;
+    pids.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            // 父进程退出时一起结束；fork 之后父进程可能已经不在了
+            if (prctl(PR_SET_PDEATHSIG, SIGKILL) == -1 || getppid() == 1)
+                _exit(EXIT_FAILURE);
+            if (stubborn_every > 0 && i % stubborn_every == 0)
+                signal(SIGTERM, SIG_IGN);
+            for (;;)
+                pause();
+        }
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+void ignoreExit(pid_t, const siginfo_t&) {}
+
+void singleExitLatency(int children) {
+    vector<pid_t> pids = spawnSleepers(children);
+
+    double wait_us = 0;
+    for (int i = 0; i < SAMPLES; ++i) {
+        auto t0 = Clock::now();
+        kill(pids.back(), SIGTERM);
+        wait(nullptr);
+        wait_us += elapsedUs(t0);
+        pids.pop_back();
+    }
+
+    Reaper reaper;
+    for (pid_t pid : pids)
+        reaper.add(pid);
+    double reaper_us = 0;
+    for (int i = 0; i < SAMPLES; ++i) {
+        auto t0 = Clock::now();
+        kill(pids.back(), SIGTERM);
+        while (reaper.poll(-1, ignoreExit) == 0)
+            ;
+        reaper_us += elapsedUs(t0);
+        pids.pop_back();
+    }
+
+    printf("single exit with ~%d live children: wait %.1f us, reaper %.1f us\n",
+           children, wait_us / SAMPLES, reaper_us / SAMPLES);
+    reaper.shutdown(SIGKILL, DEADLINE, ignoreExit);
+}
+
+void shutdownAll(int children) {
+    vector<pid_t> pids = spawnSleepers(children);
+    auto t0 = Clock::now();
+    for (pid_t pid : pids)
+        kill(pid, SIGTERM);
+    while (wait(nullptr) > 0)
+        ;
+    printf("shutdown %d children: kill + wait  %10.1f ms\n", children,
+           elapsedUs(t0) / 1e3);
+
+    pids = spawnSleepers(children);
+    Reaper reaper;
+    for (pid_t pid : pids)
+        reaper.add(pid);
+    t0 = Clock::now();
+    reaper.shutdown(SIGTERM, DEADLINE, ignoreExit);
+    printf("shutdown %d children: reaper       %10.1f ms\n", children,
+           elapsedUs(t0) / 1e3);
+}
+
+void shutdownStubborn(int children) {
+    vector<pid_t> pids = spawnSleepers(children, 100);
+    Reaper reaper;
+    for (pid_t pid : pids)
+        reaper.add(pid);
+
+    int killed = 0;
+    auto t0 = Clock::now();
+    reaper.shutdown(SIGTERM, DEADLINE, [&](pid_t, const siginfo_t& info) {
+        if (info.si_code == CLD_KILLED && info.si_status == SIGKILL)
+            ++killed;
+    });
+    printf("shutdown %d children, 1%% ignore SIGTERM: %.1f ms, %d SIGKILLed "
+           "after %lld ms\n",
+           children, elapsedUs(t0) / 1e3, killed,
+           static_cast<long long>(DEADLINE.count()));
+}
+
+// 把打开文件数的软限制提到硬限制，返回最多可以同时持有 pidfd 的子进程数
+int raiseFdLimit() {
+    rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == -1) {
+        perror("getrlimit");
+        exit(EXIT_FAILURE);
+    }
+    if (lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &lim) == -1) {
+            perror("setrlimit");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (lim.rlim_cur == RLIM_INFINITY || lim.rlim_cur > INT_MAX)
+        return INT_MAX;
+    return static_cast<int>(lim.rlim_cur) - SPARE_FDS;
+}
+
+int main(int argc, char* argv[]) {
+    int children = argc > 1 ? atoi(argv[1]) : 10000;
+    int max_children = raiseFdLimit();
+    if (children > max_children) {
+        fprintf(stderr, "RLIMIT_NOFILE allows %d pidfds, using %d children\n",
+                max_children, max_children);
+        children = max_children;
+    }
+    if (children <= SAMPLES * 2) {
+        fprintf(stderr, "children must be greater than %d\n", SAMPLES * 2);
+        exit(EXIT_FAILURE);
+    }
+
+    singleExitLatency(children);
+    shutdownAll(children);
+    shutdownStubborn(children);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/**
+ * @brief 比较 second_child 的两种等待方式：spin（usleep 轮询）与 signalfd
+ * @details
+ * 对每种方式启动 children 个子进程，空闲 idle_seconds 秒后：
+ * 1. 从 /proc/<pid>/status 读上下文切换次数，换算成每秒唤醒次数；
+ *    从 /proc/<pid>/stat 读 utime + stime，得到空闲期间消耗的 CPU 时间。
+ * 2. 逐个发送 SIGTERM，用 pidfd 上的 poll() 等到子进程退出，
+ *    统计从 kill() 到退出的延迟。
+ *
+ * @note
+ * g++ process/fork/second_child.cpp -o out/child
+ * g++ process/fork/second_child_bench.cpp -o out/child_bench --std=c++17 -O2
+ * cd out
+ * ./child_bench [idle_seconds=1] [children=6]
+ */
+#include "spawn.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+// /proc/<pid>/status 中自愿与非自愿上下文切换次数之和
+long contextSwitches(pid_t pid) {
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    string line;
+    long total = 0;
+    while (std::getline(status, line)) {
+        if (line.find("ctxt_switches:") != string::npos)
+            total += std::stol(line.substr(line.find(':') + 1));
+    }
+    return total;
+}
+
+// /proc/<pid>/stat 中的 utime + stime，单位毫秒
+double cpuMillis(pid_t pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    string content((std::istreambuf_iterator<char>(stat)),
+                   std::istreambuf_iterator<char>());
+    // 第 2 个字段（进程名）可能含空格，从最后一个 ')' 之后开始数
+    std::istringstream fields(content.substr(content.rfind(')') + 2));
+    string field;
+    unsigned long utime = 0, stime = 0;
+    for (int i = 3; fields >> field; ++i) {
+        if (i == 14)
+            utime = std::stoul(field);
+        else if (i == 15) {
+            stime = std::stoul(field);
+            break;
+        }
+    }
+    return (utime + stime) * 1000.0 / sysconf(_SC_CLK_TCK);
+}
+
+void measure(const char* program, const char* mode, int children,
+             double idle_seconds) {
+    char* arg_list[] = {const_cast<char*>(program), const_cast<char*>(mode),
+                        nullptr};
+    vector<pid_t> pids(children);
+    vector<int> pidfds(children);
+    vector<long> switches(children);
+    for (int i = 0; i < children; ++i) {
+        pids[i] = spawnChild(program, arg_list, SpawnMode::Clone3, &pidfds[i]);
+        switches[i] = contextSwitches(pids[i]);
+    }
+
+    usleep(static_cast<useconds_t>(idle_seconds * 1e6));
+
+    double wakeups = 0, cpu_ms = 0;
+    for (int i = 0; i < children; ++i) {
+        wakeups += (contextSwitches(pids[i]) - switches[i]) / idle_seconds;
+        cpu_ms += cpuMillis(pids[i]);
+    }
+
+    vector<double> latencies;
+    for (int i = 0; i < children; ++i) {
+        pollfd pfd = {pidfds[i], POLLIN, 0};
+        auto t0 = Clock::now();
+        kill(pids[i], SIGTERM);
+        poll(&pfd, 1, -1);
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - t0)
+                .count());
+        waitpid(pids[i], nullptr, 0);
+        close(pidfds[i]);
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%-10s %16.0f %14.1f %14.1f %14.1f\n", mode, wakeups / children,
+           cpu_ms / children, latencies[children / 2], latencies.back());
+}
+
+int main(int argc, char* argv[]) {
+    double idle_seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    int children = argc > 2 ? atoi(argv[2]) : 6;
+    const char* program = "child";
+
+    if (access(program, X_OK) != 0) {
+        printf("Program file 'child' does not exist in current directory!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%d children, idle %.1f s\n", children, idle_seconds);
+    printf("%-10s %16s %14s %14s %14s\n", "mode", "wakeups/s/child",
+           "cpu_ms/child", "exit_p50_us", "exit_max_us");
+    measure(program, "spin", children, idle_seconds);
+    measure(program, "signalfd", children, idle_seconds);
+    return EXIT_SUCCESS;
+}
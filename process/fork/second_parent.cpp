@@ -10,8 +10,22 @@
  * g++ process/fork/second_child.cpp -o out/child
  * g++ process/fork/second_parent.cpp -o out/parent --std=c++17
  * cd out
- * ./parent
+ * ./parent [fork|posix_spawn|vfork|clone3|zygote] [placement]
+ *
+ * placement 为 ./topology.h 的放置策略之一
+ * （none|compact|scatter|physical_core|numa_node），默认 none。
+ *
+ * zygote 模式下子进程由 ./zygote.h 的模板进程创建，不执行 child，
+ * 直接运行 childMain()，与 ./second_child.cpp 一样等到 SIGTERM 就退出。
+ *
+ * 子进程用 wait4() 回收，打印退出状态、CPU 时间和内存峰值；
+ * 设置 CHILD_METRICS（以及 CHILD_SAMPLE_MS）时按 ./telemetry.h 的行协议输出：
+ * CHILD_METRICS=metrics.lp CHILD_SAMPLE_MS=100 ./parent
  */
+#include "spawn.h"
+#include "telemetry.h"
+#include "topology.h"
+#include "zygote.h"
 #include <atomic>
 #include <filesystem>
 #include <iostream>
@@ -27,22 +41,47 @@ using std::filesystem::exists;
 
 constexpr int FORK_NUM = 6;
 
-pid_t spawnChild(const char* program, char** arg_list) {
-    pid_t ch_pid = fork();
-    if (ch_pid == -1) {
-        perror("fork");
+// zygote 模式的子进程：等到 SIGTERM 就退出
+int childMain(int) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    int sig;
+    sigwait(&mask, &sig);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "zygote") == 0) {
+        ChildTelemetry telemetry = ChildTelemetry::fromEnv("mode=zygote");
+        Zygote zygote(nullptr, childMain);
+        for (int i = 0; i < FORK_NUM; ++i) {
+            pid_t ch_pid = zygote.spawn(i);
+            cout << "spawn child with pid - " << ch_pid << endl;
+            telemetry.track(ch_pid);
+        }
+        cout << endl;
+        zygote.stop();
+
+        telemetry.reapAll(printChildExit);
+        return EXIT_SUCCESS;
+    }
+
+    SpawnMode mode = SpawnMode::Fork;
+    if (argc > 1 && !parseSpawnMode(argv[1], &mode)) {
+        cout << "Unknown spawn mode '" << argv[1] << "'\n";
         exit(EXIT_FAILURE);
-    } else if (ch_pid > 0) {
-        cout << "spawn child with pid - " << ch_pid << endl;
-        return ch_pid;
-    } else {
-        execve(program, arg_list, nullptr);
-        perror("execve");
+    }
+    Placement placement = Placement::None;
+    if (argc > 2 && !parsePlacement(argv[2], &placement)) {
+        cout << "Unknown placement '" << argv[2] << "'\n";
         exit(EXIT_FAILURE);
     }
-}
+    Topology topo = readTopology();
+    ChildTelemetry telemetry =
+        ChildTelemetry::fromEnv(string("mode=") + spawnModeName(mode));
 
-int main() {
     string program_name("child");
     char* arg_list[] = {program_name.data(), nullptr};
     vector<int> children;
@@ -53,13 +92,16 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    for (int i = 0; i < FORK_NUM; ++i)
-        children[i] = spawnChild(program_name.c_str(), arg_list);
+    for (int i = 0; i < FORK_NUM; ++i) {
+        pid_t ch_pid = spawnPlaced(program_name.c_str(), arg_list, mode,
+                                   placeChild(topo, placement, i));
+        cout << "spawn child with pid - " << ch_pid << endl;
+        children.push_back(ch_pid);
+        telemetry.track(ch_pid);
+    }
     cout << endl;
 
-    pid_t child_pid;
-    while ((child_pid = wait(nullptr)) > 0)
-        cout << "child " << child_pid << " terminated" << endl;
+    telemetry.reapAll(printChildExit);
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+/**
+ * @brief 基于实时信号的命令通道：sigqueue() 发送，sigtimedwait() / signalfd 接收
+ * @details
+ * ./second_parent.cpp 等程序只能用 kill() 告诉子进程一件事：SIGTERM，不带任何数据。
+ * 给每个子进程开一条管道又太重：几千个工作进程就是几千对 fd。
+ *
+ * 这里每种命令对应一个实时信号 SIGRTMIN + cmd（cmd < SIGCMD_COUNT），
+ * sendCommand() 用 sigqueue() 发送，随信号带一个 64 位的 payload（sigval）。
+ * payload 可以是整数，也可以是共享内存（MAP_SHARED）中的偏移量，
+ * 但不能是指针：子进程的地址空间里同一个地址不一定指向同一样东西。
+ *
+ * 与普通信号不同，实时信号会排队：同一个信号发送多次就收到多次，不会合并，
+ * 同一种信号按发送顺序交付，编号小的信号先交付。
+ * 排队长度受 RLIMIT_SIGPENDING 限制（ulimit -i），这是同一用户所有进程共享的额度，
+ * 超过时 sigqueue() 返回 EAGAIN，发送方需要稍后重试。
+ *
+ * 子进程用 CommandReceiver 接收。构造时屏蔽所有命令信号，
+ * 命令只能通过 wait()（sigtimedwait）或 read()（signalfd，可以一次读出多条）取出，
+ * 不会打断正在执行的代码；fd() 可以和其他 fd 一起放进 epoll。
+ * 实时信号的默认动作是终止进程：子进程创建 CommandReceiver 之前收到命令就会被杀死。
+ * fork() 的子进程会继承父进程的信号屏蔽字，可以由父进程在 fork() 之前调用 blockCommands()；
+ * spawnChild() 会清空屏蔽字，execve() 的子进程要先创建 CommandReceiver 再通知父进程。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man3/sigqueue.3.html
+ * https://man7.org/linux/man-pages/man2/sigtimedwait.2.html
+ * https://man7.org/linux/man-pages/man7/signal.7.html
+ */
+#pragma once
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+// 示例命令；cmd 只要小于 SIGCMD_COUNT 都可以使用
+enum : int {
+    SIGCMD_RELOAD,
+    SIGCMD_DRAIN,
+    SIGCMD_RESIZE
+};
+
+constexpr int SIGCMD_COUNT = 8; // 使用 SIGRTMIN .. SIGRTMIN + 7
+
+struct Command {
+    int cmd;
+    uint64_t payload;
+    pid_t sender; // 发送者 pid
+};
+
+inline int commandSignal(int cmd) { return SIGRTMIN + cmd; }
+
+// 所有命令信号组成的集合
+inline sigset_t commandMask() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int cmd = 0; cmd < SIGCMD_COUNT; ++cmd)
+        sigaddset(&mask, commandSignal(cmd));
+    return mask;
+}
+
+// 屏蔽所有命令信号，之后 fork() 的子进程继承屏蔽字
+inline void blockCommands() {
+    sigset_t mask = commandMask();
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) == -1) {
+        perror("sigprocmask");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief 向 pid 发送命令 cmd，携带 payload
+ * @return 成功，true；失败，false，排队已满时 errno 为 EAGAIN
+ */
+inline bool sendCommand(pid_t pid, int cmd, uint64_t payload) {
+    sigval value;
+    value.sival_ptr = reinterpret_cast<void*>(payload);
+    return sigqueue(pid, commandSignal(cmd), value) == 0;
+}
+
+class CommandReceiver {
+public:
+    CommandReceiver() : mask_(commandMask()) {
+        blockCommands();
+        fd_ = signalfd(-1, &mask_, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd_ == -1) {
+            perror("signalfd");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ~CommandReceiver() { close(fd_); }
+
+    CommandReceiver(const CommandReceiver&) = delete;
+    CommandReceiver& operator=(const CommandReceiver&) = delete;
+
+    // 有命令到达时可读，用于 epoll
+    int fd() const { return fd_; }
+
+    /**
+     * @brief 等待一条命令
+     * @param timeout_ms -1 表示一直等
+     * @return 收到命令，true；超时，false
+     */
+    bool wait(Command* cmd, int timeout_ms = -1) {
+        siginfo_t info;
+        int sig;
+        do {
+            if (timeout_ms < 0) {
+                sig = sigwaitinfo(&mask_, &info);
+            } else {
+                timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+                sig = sigtimedwait(&mask_, &info, &ts);
+            }
+        } while (sig == -1 && errno == EINTR);
+        if (sig == -1) {
+            if (errno == EAGAIN)
+                return false;
+            perror("sigtimedwait");
+            exit(EXIT_FAILURE);
+        }
+        cmd->cmd = sig - SIGRTMIN;
+        cmd->payload = reinterpret_cast<uint64_t>(info.si_value.sival_ptr);
+        cmd->sender = info.si_pid;
+        return true;
+    }
+
+    /**
+     * @brief 不阻塞地取出最多 n 条已经到达的命令
+     * @return 取出的条数，没有命令时返回 0
+     */
+    size_t read(Command* cmds, size_t n) {
+        constexpr size_t BATCH = 64;
+        signalfd_siginfo infos[BATCH];
+        size_t count = 0;
+        while (count < n) {
+            size_t want = n - count < BATCH ? n - count : BATCH;
+            ssize_t got = ::read(fd_, infos, want * sizeof(infos[0]));
+            if (got <= 0) {
+                if (got == -1 && errno != EAGAIN) {
+                    perror("read signalfd");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            size_t k = static_cast<size_t>(got) / sizeof(infos[0]);
+            for (size_t i = 0; i < k; ++i) {
+                cmds[count].cmd = static_cast<int>(infos[i].ssi_signo) - SIGRTMIN;
+                cmds[count].payload = infos[i].ssi_ptr;
+                cmds[count].sender = static_cast<pid_t>(infos[i].ssi_pid);
+                ++count;
+            }
+            if (k < want)
+                break;
+        }
+        return count;
+    }
+
+private:
+    sigset_t mask_;
+    int fd_ = -1;
+};
@@ -0,0 +1,290 @@
+/**
+ * @brief 比较 ./sigcmd.h 的实时信号命令通道与管道命令通道的延迟和吞吐量
+ * @details
+ * 命令是 (cmd, payload) 两个整数，管道通道每条命令写一个 16 字节的记录。
+ *
+ * 延迟   父子进程之间往返：父进程发一条命令，子进程回一条 payload + 1 的命令。
+ *        signal：双方都用 sendCommand() / CommandReceiver::wait()；
+ *        pipe：每个方向一条管道，read() / write()。
+ * 吞吐量 父进程给 children 个子进程轮流各发 commands 条 SIGCMD_RELOAD，
+ *        最后各发一条 SIGCMD_DRAIN（payload 为条数），计时到所有子进程退出。
+ *        子进程一次取出多条（signalfd / 管道的 read()），检查 payload 按顺序递增，
+ *        收到 DRAIN 时检查条数，不对就以失败状态退出。
+ *        同一种实时信号按发送顺序交付，编号小的先交付，
+ *        所以 DRAIN（SIGRTMIN + 1）总在之前所有 RELOAD（SIGRTMIN）之后。
+ *        信号排队满（EAGAIN）时父进程让出 CPU 后重试，报告重试次数。
+ *
+ * @note
+ * g++ process/fork/sigcmd_bench.cpp -o out/sigcmd_bench --std=c++17 -O2
+ * out/sigcmd_bench [children=64] [commands=10000]
+ */
+#include "../../benchmark/bench.h"
+#include "sigcmd.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+constexpr size_t BATCH = 64;
+
+struct Record {
+    int32_t cmd;
+    uint64_t payload;
+};
+
+void writeRecord(int fd, int cmd, uint64_t payload) {
+    Record rec{cmd, payload};
+    if (write(fd, &rec, sizeof(rec)) != sizeof(rec)) {
+        perror("write");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void readRecord(int fd, Record* rec) {
+    if (read(fd, rec, sizeof(*rec)) != sizeof(*rec)) {
+        perror("read");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void sendOrRetry(pid_t pid, int cmd, uint64_t payload, long* retries) {
+    while (!sendCommand(pid, cmd, payload)) {
+        if (errno != EAGAIN) {
+            perror("sigqueue");
+            exit(EXIT_FAILURE);
+        }
+        ++*retries;
+        sched_yield();
+    }
+}
+
+pid_t forkChild() {
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    return pid;
+}
+
+void waitChildren(const std::vector<pid_t>& pids) {
+    for (pid_t pid : pids) {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "child %d failed\n", pid);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// ---- 延迟 ----
+
+struct SignalEcho {
+    pid_t child;
+    CommandReceiver* receiver;
+    uint64_t next;
+};
+
+void signalRoundTrip(void* arg) {
+    auto* echo = static_cast<SignalEcho*>(arg);
+    uint64_t payload = echo->next++;
+    long retries = 0;
+    sendOrRetry(echo->child, SIGCMD_RELOAD, payload, &retries);
+    Command reply;
+    if (!echo->receiver->wait(&reply) || reply.payload != payload + 1) {
+        fprintf(stderr, "signal echo: wrong payload\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+struct PipeEcho {
+    int to_child;
+    int from_child;
+    uint64_t next;
+};
+
+void pipeRoundTrip(void* arg) {
+    auto* echo = static_cast<PipeEcho*>(arg);
+    uint64_t payload = echo->next++;
+    writeRecord(echo->to_child, SIGCMD_RELOAD, payload);
+    Record reply;
+    readRecord(echo->from_child, &reply);
+    if (reply.payload != payload + 1) {
+        fprintf(stderr, "pipe echo: wrong payload\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+double signalLatency() {
+    CommandReceiver receiver;
+    pid_t parent = getpid();
+    pid_t child = forkChild();
+    if (child == 0) {
+        // 屏蔽字从父进程继承，但 signalfd 要自己创建
+        CommandReceiver child_receiver;
+        Command c;
+        long retries = 0;
+        while (child_receiver.wait(&c) && c.cmd != SIGCMD_DRAIN)
+            sendOrRetry(parent, SIGCMD_RELOAD, c.payload + 1, &retries);
+        _exit(EXIT_SUCCESS);
+    }
+    SignalEcho echo{child, &receiver, 0};
+    struct bench_result r = bench_run("signal_round_trip", signalRoundTrip,
+                                      &echo, 1);
+    bench_report(&r);
+    long retries = 0;
+    sendOrRetry(child, SIGCMD_DRAIN, 0, &retries);
+    waitChildren({child});
+    return r.median_ns;
+}
+
+double pipeLatency() {
+    int down[2], up[2];
+    if (pipe(down) == -1 || pipe(up) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pid_t child = forkChild();
+    if (child == 0) {
+        close(down[1]);
+        close(up[0]);
+        Record rec;
+        while (read(down[0], &rec, sizeof(rec)) == sizeof(rec))
+            writeRecord(up[1], rec.cmd, rec.payload + 1);
+        _exit(EXIT_SUCCESS);
+    }
+    close(down[0]);
+    close(up[1]);
+    PipeEcho echo{down[1], up[0], 0};
+    struct bench_result r = bench_run("pipe_round_trip", pipeRoundTrip, &echo,
+                                      1);
+    bench_report(&r);
+    close(down[1]);
+    close(up[0]);
+    waitChildren({child});
+    return r.median_ns;
+}
+
+// ---- 吞吐量 ----
+
+// 检查一条命令；收到 DRAIN 时退出
+void consume(int cmd, uint64_t payload, uint64_t* expect) {
+    if (cmd == SIGCMD_DRAIN)
+        _exit(payload == *expect ? EXIT_SUCCESS : EXIT_FAILURE);
+    if (cmd != SIGCMD_RELOAD || payload != *expect)
+        _exit(EXIT_FAILURE);
+    ++*expect;
+}
+
+double signalThroughput(int children, int commands, long* retries) {
+    std::vector<pid_t> pids;
+    for (int i = 0; i < children; ++i) {
+        pid_t pid = forkChild();
+        if (pid == 0) {
+            CommandReceiver receiver;
+            Command cmds[BATCH];
+            uint64_t expect = 0;
+            for (;;) {
+                size_t n = receiver.read(cmds, BATCH);
+                if (n == 0 && receiver.wait(&cmds[0]))
+                    n = 1;
+                for (size_t k = 0; k < n; ++k)
+                    consume(cmds[k].cmd, cmds[k].payload, &expect);
+            }
+        }
+        pids.push_back(pid);
+    }
+
+    double begin = bench_now_ns();
+    for (int i = 0; i < commands; ++i) {
+        for (pid_t pid : pids)
+            sendOrRetry(pid, SIGCMD_RELOAD, static_cast<uint64_t>(i), retries);
+    }
+    for (pid_t pid : pids)
+        sendOrRetry(pid, SIGCMD_DRAIN, static_cast<uint64_t>(commands), retries);
+    waitChildren(pids);
+    return static_cast<double>(children) * commands /
+           (bench_now_ns() - begin) * 1e9;
+}
+
+double pipeThroughput(int children, int commands) {
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    for (int i = 0; i < children; ++i) {
+        int pipefd[2];
+        if (pipe(pipefd) == -1) {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = forkChild();
+        if (pid == 0) {
+            close(pipefd[1]);
+            for (int fd : fds)
+                close(fd);
+            Record recs[BATCH];
+            uint64_t expect = 0;
+            size_t have = 0; // 不完整记录的字节数
+            for (;;) {
+                ssize_t n = read(pipefd[0], reinterpret_cast<char*>(recs) + have,
+                                 sizeof(recs) - have);
+                if (n <= 0)
+                    _exit(EXIT_FAILURE);
+                have += static_cast<size_t>(n);
+                size_t k = have / sizeof(Record);
+                for (size_t j = 0; j < k; ++j)
+                    consume(recs[j].cmd, recs[j].payload, &expect);
+                have -= k * sizeof(Record);
+                memmove(recs, recs + k, have);
+            }
+        }
+        close(pipefd[0]);
+        fds.push_back(pipefd[1]);
+        pids.push_back(pid);
+    }
+
+    double begin = bench_now_ns();
+    for (int i = 0; i < commands; ++i) {
+        for (int fd : fds)
+            writeRecord(fd, SIGCMD_RELOAD, static_cast<uint64_t>(i));
+    }
+    for (int fd : fds)
+        writeRecord(fd, SIGCMD_DRAIN, static_cast<uint64_t>(commands));
+    waitChildren(pids);
+    double rate = static_cast<double>(children) * commands /
+                  (bench_now_ns() - begin) * 1e9;
+    for (int fd : fds)
+        close(fd);
+    return rate;
+}
+
+int main(int argc, char* argv[]) {
+    int children = argc > 1 ? atoi(argv[1]) : 64;
+    int commands = argc > 2 ? atoi(argv[2]) : 10000;
+
+    bench_init(nullptr);
+    // 父进程也通过命令信号接收回复；fork() 的子进程继承屏蔽字
+    blockCommands();
+
+    double signal_rtt = signalLatency();
+    double pipe_rtt = pipeLatency();
+
+    long retries = 0;
+    double signal_rate = signalThroughput(children, commands, &retries);
+    double pipe_rate = pipeThroughput(children, commands);
+
+    if (bench_cfg.format == BENCH_TEXT) {
+        printf("\n%-8s %16s %16s\n", "channel", "round_trip_us", "cmds_per_s");
+        printf("%-8s %16.2f %16.0f  (%ld EAGAIN retries)\n", "signal",
+               signal_rtt / 1e3, signal_rate, retries);
+        printf("%-8s %16.2f %16.0f\n", "pipe", pipe_rtt / 1e3, pipe_rate);
+        printf("%d children x %d commands; pipe channel holds %d fds, "
+               "signal channel none\n",
+               children, commands, children);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/**
+ * @brief 创建子进程的几种方式 fork / posix_spawn / vfork / clone3
+ * @details
+ * fork() 会复制父进程的整个页表（写时复制，但页表本身要复制），
+ * 父进程的堆越大，fork() 越慢；而紧接着的 execve() 又把复制来的地址空间丢掉。
+ *
+ * SpawnMode::Fork
+ *      fork() + execve()，最常见的写法。
+ * SpawnMode::PosixSpawn
+ *      posix_spawn()，glibc 内部使用 clone(CLONE_VM | CLONE_VFORK)，
+ *      不复制页表，出错时通过返回值告诉父进程。
+ * SpawnMode::VFork
+ *      vfork() + execve()，子进程借用父进程的地址空间，
+ *      父进程被挂起，直到子进程 execve() 或 _exit()。
+ *      子进程中除了 execve() 和 _exit() 之外什么都不能做。
+ * SpawnMode::Clone3
+ *      clone3(CLONE_VFORK | CLONE_PIDFD)，父进程挂起到子进程 execve()，
+ *      同时拿到一个指向子进程的 pidfd（不会因为 pid 复用而发错信号）。
+ *      没有 CLONE_VM，所以页表仍然要复制一次。
+ *
+ * 无论哪种方式，子进程都以空的信号屏蔽字执行 program，
+ * 不会继承父进程为了使用 signalfd 而屏蔽的信号。
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/clone.2.html
+ * https://man7.org/linux/man-pages/man3/posix_spawn.3.html
+ * https://man7.org/linux/man-pages/man2/vfork.2.html
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/sched.h> // struct clone_args, CLONE_PIDFD
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum class SpawnMode {
+    Fork,
+    PosixSpawn,
+    VFork,
+    Clone3
+};
+
+constexpr SpawnMode ALL_SPAWN_MODES[] = {SpawnMode::Fork, SpawnMode::PosixSpawn,
+                                         SpawnMode::VFork, SpawnMode::Clone3};
+
+inline const char* spawnModeName(SpawnMode mode) {
+    switch (mode) {
+    case SpawnMode::Fork:
+        return "fork";
+    case SpawnMode::PosixSpawn:
+        return "posix_spawn";
+    case SpawnMode::VFork:
+        return "vfork";
+    case SpawnMode::Clone3:
+        return "clone3";
+    }
+    return "unknown";
+}
+
+// 由名字得到 SpawnMode，名字不认识时返回 false
+inline bool parseSpawnMode(const char* name, SpawnMode* mode) {
+    for (SpawnMode m : ALL_SPAWN_MODES) {
+        if (strcmp(name, spawnModeName(m)) == 0) {
+            *mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 以 mode 指定的方式创建子进程并执行 program
+ * @param pidfd 不为空时，Clone3 模式把 pidfd 写到这里，其他模式写入 -1
+ * @return 子进程 pid，失败时打印错误并退出
+ */
+inline pid_t spawnChild(const char* program, char** arg_list,
+                        SpawnMode mode = SpawnMode::Fork,
+                        int* pidfd = nullptr) {
+    static char* empty_env[] = {nullptr};
+    sigset_t empty_mask;
+    sigemptyset(&empty_mask);
+    if (pidfd != nullptr)
+        *pidfd = -1;
+
+    pid_t ch_pid = -1;
+    switch (mode) {
+    case SpawnMode::Fork:
+        ch_pid = fork();
+        if (ch_pid == 0) {
+            sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+            execve(program, arg_list, empty_env);
+            perror("execve");
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case SpawnMode::PosixSpawn: {
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setsigmask(&attr, &empty_mask);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+        // posix_spawn 不设置 errno，而是直接返回错误码
+        int err = posix_spawn(&ch_pid, program, nullptr, &attr, arg_list,
+                              empty_env);
+        posix_spawnattr_destroy(&attr);
+        if (err != 0) {
+            errno = err;
+            ch_pid = -1;
+        }
+        break;
+    }
+    case SpawnMode::VFork:
+        ch_pid = vfork();
+        if (ch_pid == 0) {
+            sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+            execve(program, arg_list, empty_env);
+            _exit(127);
+        }
+        break;
+    case SpawnMode::Clone3: {
+        int fd = -1;
+        struct clone_args args;
+        memset(&args, 0, sizeof(args));
+        args.flags = CLONE_VFORK | CLONE_PIDFD;
+        args.pidfd = reinterpret_cast<uint64_t>(&fd);
+        args.exit_signal = SIGCHLD;
+        ch_pid = static_cast<pid_t>(syscall(SYS_clone3, &args, sizeof(args)));
+        if (ch_pid == 0) {
+            sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+            execve(program, arg_list, empty_env);
+            _exit(127);
+        }
+        if (ch_pid > 0) {
+            if (pidfd != nullptr)
+                *pidfd = fd;
+            else
+                close(fd);
+        }
+        break;
+    }
+    }
+
+    if (ch_pid == -1) {
+        perror(spawnModeName(mode));
+        exit(EXIT_FAILURE);
+    }
+    return ch_pid;
+}
@@ -0,0 +1,435 @@
+/**
+ * @brief 子进程的资源遥测：回收时的 rusage + 运行中的 /proc/<pid>/stat 采样，以行协议输出
+ * @details
+ * wait(nullptr) 只回收子进程，退出码、CPU 时间、内存峰值全都丢掉了。
+ * wait4() 和 waitid() 的系统调用在回收的同时填好这个子进程的 struct rusage：
+ *      ru_utime / ru_stime     用户态、内核态 CPU 时间
+ *      ru_maxrss               常驻内存的峰值（KB）
+ *      ru_minflt / ru_majflt   次缺页、主缺页（需要读盘）次数
+ *      ru_nvcsw / ru_nivcsw    主动、被动上下文切换次数
+ * glibc 的 waitid() 没有 rusage 参数，./reaper.h 的 Reaper 用 waitidUsage() 直接调用系统调用，
+ * 回调期间可以通过 Reaper::usage() 取得。
+ *
+ * 子进程退出之前，ProcSampler 定期读取 /proc/<pid>/stat：
+ * 每个子进程只在 track() 时 open() 一次，之后每次采样只是一次 pread()，
+ * 没有路径查找，也不会因为 pid 被复用而读到别的进程（打开的文件始终指向原来的进程）。
+ * 两次采样之间 utime + stime 的增量换算成 CPU 占用率。
+ *
+ * 结果写成 InfluxDB 行协议，每行一条记录，可以 tail -f 或直接导入时序数据库：
+ *      child_sample,pid=123 state="S",cpu_pct=12.5,utime_us=1000i,stime_us=0i,
+ *                  rss_kb=3456i,vsize_kb=8000i,minflt=120i,majflt=0i,threads=1i 1700000000000000000
+ *      child_exit,pid=123 code=0i,signal=0i,wall_ms=5000.1,utime_us=1000i,stime_us=0i,
+ *                  maxrss_kb=3456i,minflt=120i,majflt=0i,nvcsw=4i,nivcsw=1i 1700000000000000000
+ * 时间戳是 CLOCK_REALTIME 的纳秒数；每轮采样、每次退出之后 fflush()。
+ *
+ * ChildTelemetry 把两者合在一起，ChildTelemetry::fromEnv() 读取环境变量：
+ *      CHILD_METRICS       输出文件，"-" 表示标准输出，不设置时不输出
+ *      CHILD_SAMPLE_MS     采样间隔（毫秒），0 或不设置时不采样
+ *
+ * @details
+ * https://man7.org/linux/man-pages/man2/wait4.2.html
+ * https://man7.org/linux/man-pages/man2/getrusage.2.html
+ * https://man7.org/linux/man-pages/man5/proc.5.html
+ * https://docs.influxdata.com/influxdb/v2/reference/syntax/line-protocol/
+ */
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+inline int64_t timevalUs(const timeval& tv) {
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+inline int64_t realtimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 一个已回收的子进程
+struct ChildExit {
+    pid_t pid;
+    int code;   // CLD_EXITED / CLD_KILLED / CLD_DUMPED
+    int status; // 退出码或信号
+    double wall_ms; // 从 track() 到回收，没有 track() 时为 0
+    rusage usage;
+};
+
+// 在标准输出打印一行摘要：退出码或信号、CPU 时间、内存峰值
+inline void printChildExit(const ChildExit& e) {
+    printf("child %d terminated, %s %d, cpu %lld+%lld us, maxrss %ld KB\n",
+           e.pid, e.code == CLD_EXITED ? "exit code" : "signal", e.status,
+           static_cast<long long>(timevalUs(e.usage.ru_utime)),
+           static_cast<long long>(timevalUs(e.usage.ru_stime)),
+           e.usage.ru_maxrss);
+    fflush(stdout);
+}
+
+// /proc/<pid>/stat 中关心的字段
+struct ProcSample {
+    char state;
+    uint64_t minflt;
+    uint64_t majflt;
+    uint64_t utime_ticks;
+    uint64_t stime_ticks;
+    int64_t threads;
+    uint64_t vsize;    // 字节
+    int64_t rss_pages;
+};
+
+/**
+ * @brief 解析 /proc/<pid>/stat 的内容
+ * @return 成功，true；格式不对，false
+ * @details
+ * 第 2 个字段是括号里的命令名，其中可能有空格和括号，从最后一个 ')' 之后开始按空格切分。
+ */
+inline bool parseProcStat(const char* buf, ProcSample* out) {
+    const char* p = strrchr(buf, ')');
+    if (p == nullptr)
+        return false;
+    ++p;
+    // 从第 3 个字段 state 开始
+    uint64_t fields[22] = {};
+    char state = 0;
+    int field = 3;
+    while (*p != '\0' && field <= 24) {
+        while (*p == ' ')
+            ++p;
+        if (field == 3) {
+            state = *p++;
+        } else {
+            char* end;
+            fields[field - 3] = strtoull(p, &end, 10);
+            if (end == p)
+                return false;
+            p = end;
+        }
+        ++field;
+        while (*p != ' ' && *p != '\0')
+            ++p;
+    }
+    if (field <= 24)
+        return false;
+    out->state = state;
+    out->minflt = fields[10 - 3];
+    out->majflt = fields[12 - 3];
+    out->utime_ticks = fields[14 - 3];
+    out->stime_ticks = fields[15 - 3];
+    out->threads = static_cast<int64_t>(fields[20 - 3]);
+    out->vsize = fields[23 - 3];
+    out->rss_pages = static_cast<int64_t>(fields[24 - 3]);
+    return true;
+}
+
+// 把记录写成行协议；path 为 nullptr 时什么都不做
+class MetricsWriter {
+public:
+    /**
+     * @param path 输出文件（追加），"-" 表示标准输出
+     * @param tags 附加在每行 pid 之后的标签，例如 "mode=fork"，可以为空
+     */
+    explicit MetricsWriter(const char* path, std::string tags = "") {
+        if (!tags.empty())
+            tags_ = "," + tags;
+        if (path == nullptr)
+            return;
+        if (strcmp(path, "-") == 0) {
+            out_ = stdout;
+            return;
+        }
+        out_ = fopen(path, "ae");
+        if (out_ == nullptr) {
+            perror("fopen metrics");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ~MetricsWriter() {
+        if (out_ != nullptr && out_ != stdout)
+            fclose(out_);
+        else if (out_ != nullptr)
+            fflush(out_);
+    }
+
+    MetricsWriter(const MetricsWriter&) = delete;
+    MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+    bool enabled() const { return out_ != nullptr; }
+
+    void writeExit(const ChildExit& e, int64_t ts_ns) {
+        if (out_ == nullptr)
+            return;
+        const rusage& ru = e.usage;
+        fprintf(out_,
+                "child_exit,pid=%d%s code=%di,signal=%di,wall_ms=%.3f,"
+                "utime_us=%lldi,stime_us=%lldi,maxrss_kb=%ldi,minflt=%ldi,"
+                "majflt=%ldi,nvcsw=%ldi,nivcsw=%ldi %lld\n",
+                e.pid, tags_.c_str(), e.code == CLD_EXITED ? e.status : 0,
+                e.code == CLD_EXITED ? 0 : e.status, e.wall_ms,
+                static_cast<long long>(timevalUs(ru.ru_utime)),
+                static_cast<long long>(timevalUs(ru.ru_stime)), ru.ru_maxrss,
+                ru.ru_minflt, ru.ru_majflt, ru.ru_nvcsw, ru.ru_nivcsw,
+                static_cast<long long>(ts_ns));
+    }
+
+    void writeSample(pid_t pid, const ProcSample& s, double cpu_pct,
+                     int64_t ts_ns) {
+        if (out_ == nullptr)
+            return;
+        fprintf(out_,
+                "child_sample,pid=%d%s state=\"%c\",cpu_pct=%.1f,"
+                "utime_us=%lldi,stime_us=%lldi,rss_kb=%lldi,vsize_kb=%llui,"
+                "minflt=%llui,majflt=%llui,threads=%lldi %lld\n",
+                pid, tags_.c_str(), s.state, cpu_pct,
+                static_cast<long long>(s.utime_ticks * us_per_tick_),
+                static_cast<long long>(s.stime_ticks * us_per_tick_),
+                static_cast<long long>(s.rss_pages * page_kb_),
+                static_cast<unsigned long long>(s.vsize / 1024),
+                static_cast<unsigned long long>(s.minflt),
+                static_cast<unsigned long long>(s.majflt),
+                static_cast<long long>(s.threads),
+                static_cast<long long>(ts_ns));
+    }
+
+    void flush() {
+        if (out_ != nullptr)
+            fflush(out_);
+    }
+
+private:
+    FILE* out_ = nullptr;
+    std::string tags_;
+    int64_t us_per_tick_ = 1000000 / sysconf(_SC_CLK_TCK);
+    int64_t page_kb_ = sysconf(_SC_PAGESIZE) / 1024;
+};
+
+// 定期读取被跟踪子进程的 /proc/<pid>/stat
+class ProcSampler {
+public:
+    ProcSampler() = default;
+
+    ~ProcSampler() {
+        for (const Entry& e : entries_)
+            close(e.fd);
+    }
+
+    ProcSampler(const ProcSampler&) = delete;
+    ProcSampler& operator=(const ProcSampler&) = delete;
+
+    // 打开 pid 的 stat 文件；进程已经不在时返回 false
+    bool add(pid_t pid) {
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+        entries_.push_back(Entry{pid, fd, 0, Clock::now(), false});
+        return true;
+    }
+
+    void remove(pid_t pid) {
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].pid == pid) {
+                close(entries_[i].fd);
+                entries_[i] = entries_.back();
+                entries_.pop_back();
+                return;
+            }
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * @brief 采样所有被跟踪的进程，对每个调用 on_sample(pid, sample, cpu_pct)
+     * @details
+     * cpu_pct 是与上一次采样之间的 CPU 占用率（100 表示占满一个 CPU），第一次采样为 0。
+     * 读失败（进程已被回收）的跳过，等 remove()。
+     */
+    template <typename OnSample>
+    void sample(OnSample on_sample) {
+        char buf[1024];
+        auto now = Clock::now();
+        for (Entry& e : entries_) {
+            ssize_t n = pread(e.fd, buf, sizeof(buf) - 1, 0);
+            if (n <= 0)
+                continue;
+            buf[n] = '\0';
+            ProcSample s;
+            if (!parseProcStat(buf, &s))
+                continue;
+            uint64_t ticks = s.utime_ticks + s.stime_ticks;
+            double cpu_pct = 0;
+            if (e.sampled) {
+                double secs =
+                    std::chrono::duration<double>(now - e.last_time).count();
+                if (secs > 0)
+                    cpu_pct = static_cast<double>(ticks - e.last_ticks) /
+                              ticks_per_sec_ / secs * 100;
+            }
+            e.last_ticks = ticks;
+            e.last_time = now;
+            e.sampled = true;
+            on_sample(e.pid, s, cpu_pct);
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        pid_t pid;
+        int fd;
+        uint64_t last_ticks;
+        Clock::time_point last_time;
+        bool sampled;
+    };
+
+    std::vector<Entry> entries_;
+    double ticks_per_sec_ = static_cast<double>(sysconf(_SC_CLK_TCK));
+};
+
+/**
+ * @brief 回收记录 + 定期采样 + 输出
+ * @details
+ * 用法：创建子进程后 track(pid)；回收时 exited(...)；
+ * 等待事件的超时用 timeoutMs()，醒来后调用 sampleIfDue()。
+ * 只使用 wait4() 的程序可以直接用 reapAll()。
+ */
+class ChildTelemetry {
+public:
+    ChildTelemetry(const char* path, int sample_ms, std::string tags = "")
+        : writer_(path, std::move(tags)),
+          sample_ms_(writer_.enabled() ? sample_ms : 0) {}
+
+    static ChildTelemetry fromEnv(std::string tags = "") {
+        const char* ms = getenv("CHILD_SAMPLE_MS");
+        return ChildTelemetry(getenv("CHILD_METRICS"), ms ? atoi(ms) : 0,
+                              std::move(tags));
+    }
+
+    bool sampling() const { return sample_ms_ > 0; }
+
+    void track(pid_t pid) {
+        starts_.push_back(Start{pid, Clock::now()});
+        if (sampling())
+            sampler_.add(pid);
+    }
+
+    // 记录一个已回收的子进程：code、status 与 siginfo_t 的 si_code、si_status 相同
+    ChildExit exited(pid_t pid, int code, int status, const rusage& usage) {
+        ChildExit e{pid, code, status, 0, usage};
+        for (size_t i = 0; i < starts_.size(); ++i) {
+            if (starts_[i].pid == pid) {
+                e.wall_ms = std::chrono::duration<double, std::milli>(
+                                Clock::now() - starts_[i].time)
+                                .count();
+                starts_[i] = starts_.back();
+                starts_.pop_back();
+                break;
+            }
+        }
+        if (sampling())
+            sampler_.remove(pid);
+        writer_.writeExit(e, realtimeNs());
+        writer_.flush();
+        return e;
+    }
+
+    ChildExit exited(pid_t pid, const siginfo_t& info, const rusage& usage) {
+        return exited(pid, info.si_code, info.si_status, usage);
+    }
+
+    // 距离下一次采样的毫秒数，不采样时为 -1
+    int timeoutMs() const {
+        if (!sampling())
+            return -1;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            next_sample_ - Clock::now());
+        return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+    }
+
+    void sampleIfDue() {
+        if (!sampling() || Clock::now() < next_sample_)
+            return;
+        int64_t ts = realtimeNs();
+        sampler_.sample([&](pid_t pid, const ProcSample& s, double cpu_pct) {
+            writer_.writeSample(pid, s, cpu_pct, ts);
+        });
+        writer_.flush();
+        next_sample_ = Clock::now() + std::chrono::milliseconds(sample_ms_);
+    }
+
+    /**
+     * @brief 用 wait4() 回收所有子进程，对每个调用 on_exit(const ChildExit&)
+     * @details
+     * 不采样时阻塞在 wait4() 上。采样时屏蔽 SIGCHLD，
+     * 在 wait4(WNOHANG) 之间用 sigtimedwait() 等 SIGCHLD 或下一次采样，
+     * 子进程退出后立即回收，结束时恢复原来的信号屏蔽字。
+     */
+    template <typename OnExit>
+    void reapAll(OnExit on_exit) {
+        sigset_t chld, old;
+        sigemptyset(&chld);
+        sigaddset(&chld, SIGCHLD);
+        if (sampling())
+            sigprocmask(SIG_BLOCK, &chld, &old);
+
+        for (;;) {
+            int wstatus;
+            rusage usage;
+            pid_t pid = wait4(-1, &wstatus, sampling() ? WNOHANG : 0, &usage);
+            if (pid > 0) {
+                int code = WIFEXITED(wstatus)  ? CLD_EXITED
+                           : WCOREDUMP(wstatus) ? CLD_DUMPED
+                                                : CLD_KILLED;
+                int status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus)
+                                                : WTERMSIG(wstatus);
+                on_exit(exited(pid, code, status, usage));
+                continue;
+            }
+            if (pid == -1) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != ECHILD)
+                    perror("wait4");
+                break;
+            }
+
+            sampleIfDue();
+            int ms = timeoutMs();
+            timespec ts{ms / 1000, (ms % 1000) * 1000000L};
+            sigtimedwait(&chld, nullptr, &ts);
+        }
+
+        if (sampling())
+            sigprocmask(SIG_SETMASK, &old, nullptr);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Start {
+        pid_t pid;
+        Clock::time_point time;
+    };
+
+    MetricsWriter writer_;
+    ProcSampler sampler_;
+    int sample_ms_;
+    std::vector<Start> starts_;
+    Clock::time_point next_sample_ = Clock::now();
+};
@@ -0,0 +1,274 @@
+/**
+ * @brief ./telemetry.h 的开销与正确性
+ * @details
+ * 1. 回收：子进程立即退出，比较 wait()、wait4()、waitidUsage() 每次回收的耗时。
+ *    带 rusage 的回收比 wait() 慢，单 CPU 上测到过 2.2 对 2.6 us，也测到过 2.1 对 4.1 us，
+ *    每个子进程只回收一次，相对 fork 本身（百微秒级）仍然可以忽略。
+ * 2. 采样：children 个睡眠的子进程（默认 1000），每个采样一次的耗时：
+ *    每次 open + read + close 路径，与 ProcSampler 保持打开、只 pread() 比较。
+ * 3. 正确性：
+ *      分配并写满 MEMORY_MB 的子进程，ru_maxrss 不小于 MEMORY_MB；
+ *      空转 BURN_MS 的子进程，ru_utime 接近 BURN_MS，运行中的采样 cpu_pct 接近 100
+ *      （等内存子进程退出之后才开始空转，采样窗口 SAMPLE_WINDOW_MS 远大于 1 个时钟节拍）；
+ *      被 SIGKILL 的子进程，code 为 CLD_KILLED；
+ *      写出的行协议逐行检查格式。
+ *
+ * @note
+ * g++ process/fork/telemetry_bench.cpp -o out/a.out --std=c++17 -O2
+ * out/a.out [children=1000]
+ */
+#include "reaper.h"
+#include "telemetry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+constexpr int REAP_SAMPLES = 2000;
+constexpr int SAMPLE_ROUNDS = 20;
+constexpr int MEMORY_MB = 64;
+constexpr int BURN_MS = 1000;
+constexpr int SAMPLE_WINDOW_MS = 600;
+constexpr const char* METRICS_PATH = "/tmp/telemetry_bench.lp";
+
+double elapsedUs(Clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - since)
+        .count();
+}
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+pid_t forkOrDie() {
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    return pid;
+}
+
+enum class ReapCall { Wait, Wait4, Waitid };
+
+// 只计 wait 调用本身的时间：先确认子进程已经是僵尸
+double reapUs(ReapCall call) {
+    double total = 0;
+    for (int i = 0; i < REAP_SAMPLES; ++i) {
+        pid_t pid = forkOrDie();
+        if (pid == 0)
+            _exit(0);
+        siginfo_t info{};
+        waitid(P_PID, pid, &info, WEXITED | WNOWAIT);
+
+        rusage usage;
+        auto t0 = Clock::now();
+        switch (call) {
+        case ReapCall::Wait:
+            wait(nullptr);
+            break;
+        case ReapCall::Wait4:
+            wait4(pid, nullptr, 0, &usage);
+            break;
+        case ReapCall::Waitid:
+            waitidUsage(P_PID, pid, &info, WEXITED, &usage);
+            break;
+        }
+        total += elapsedUs(t0);
+    }
+    return total / REAP_SAMPLES;
+}
+
+vector<pid_t> spawnSleepers(int n) {
+    vector<pid_t> pids;
+    pids.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        pid_t pid = forkOrDie();
+        if (pid == 0) {
+            for (;;)
+                pause();
+        }
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+void killAll(const vector<pid_t>& pids) {
+    for (pid_t pid : pids)
+        kill(pid, SIGKILL);
+    while (wait(nullptr) > 0)
+        ;
+}
+
+void samplingCost(int children) {
+    vector<pid_t> pids = spawnSleepers(children);
+
+    char buf[1024];
+    ProcSample s;
+    auto t0 = Clock::now();
+    for (int round = 0; round < SAMPLE_ROUNDS; ++round) {
+        for (pid_t pid : pids) {
+            char path[32];
+            snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            ssize_t n = read(fd, buf, sizeof(buf) - 1);
+            close(fd);
+            buf[n > 0 ? n : 0] = '\0';
+            parseProcStat(buf, &s);
+        }
+    }
+    double reopen_us = elapsedUs(t0) / SAMPLE_ROUNDS / children;
+
+    ProcSampler sampler;
+    for (pid_t pid : pids)
+        sampler.add(pid);
+    size_t seen = 0;
+    t0 = Clock::now();
+    for (int round = 0; round < SAMPLE_ROUNDS; ++round)
+        sampler.sample([&](pid_t, const ProcSample&, double) { ++seen; });
+    double pread_us = elapsedUs(t0) / SAMPLE_ROUNDS / children;
+    check(seen == static_cast<size_t>(SAMPLE_ROUNDS) * children,
+          "sampler skipped live children");
+
+    printf("sample /proc/<pid>/stat, %d children: open+read+close %.2f us, "
+           "kept fd pread %.2f us per child\n",
+           children, reopen_us, pread_us);
+    killAll(pids);
+}
+
+// 三个行为不同的子进程，父进程用 ChildTelemetry 采样并回收
+void correctness() {
+    unlink(METRICS_PATH);
+    vector<ChildExit> exits;
+    double burn_cpu_pct = 0;
+    {
+        ChildTelemetry telemetry(METRICS_PATH, 50, "bench=telemetry");
+
+        pid_t memory = forkOrDie();
+        if (memory == 0) {
+            size_t size = static_cast<size_t>(MEMORY_MB) << 20;
+            // 逐页写，不让编译器把 malloc + memset 优化掉
+            volatile char* p = static_cast<char*>(malloc(size));
+            for (size_t i = 0; i < size; i += 4096)
+                p[i] = 1;
+            _exit(p[size - 4096] == 1 ? 0 : 1);
+        }
+        // 空转的子进程不和它抢 CPU：等它成为僵尸（不回收，留给 reapAll）
+        siginfo_t info{};
+        if (waitid(P_PID, memory, &info, WEXITED | WNOWAIT) == -1) {
+            perror("waitid");
+            exit(EXIT_FAILURE);
+        }
+        pid_t burn = forkOrDie();
+        if (burn == 0) {
+            auto until = Clock::now() + std::chrono::milliseconds(BURN_MS);
+            volatile uint64_t x = 0;
+            while (Clock::now() < until)
+                x = x + 1;
+            _exit(0);
+        }
+        pid_t killed = forkOrDie();
+        if (killed == 0) {
+            for (;;)
+                pause();
+        }
+        telemetry.track(memory);
+        telemetry.track(burn);
+        telemetry.track(killed);
+
+        // 直接从 ProcSampler 取空转子进程在一个窗口内的占用率
+        ProcSampler sampler;
+        sampler.add(burn);
+        auto record = [&](pid_t, const ProcSample&, double cpu_pct) {
+            burn_cpu_pct = cpu_pct;
+        };
+        usleep((BURN_MS - SAMPLE_WINDOW_MS) * 1000 / 2);
+        sampler.sample(record);
+        usleep(SAMPLE_WINDOW_MS * 1000);
+        sampler.sample(record);
+        kill(killed, SIGKILL);
+        telemetry.reapAll([&](const ChildExit& e) { exits.push_back(e); });
+        check(exits.size() == 3, "reapAll missed children");
+
+        for (const ChildExit& e : exits) {
+            if (e.pid == memory) {
+                check(e.code == CLD_EXITED && e.status == 0, "memory child");
+                check(e.usage.ru_maxrss >= MEMORY_MB * 1024,
+                      "ru_maxrss below the touched size");
+                printf("memory child: maxrss %ld KB (touched %d MB), "
+                       "minflt %ld\n",
+                       e.usage.ru_maxrss, MEMORY_MB, e.usage.ru_minflt);
+            } else if (e.pid == burn) {
+                int64_t cpu_us =
+                    timevalUs(e.usage.ru_utime) + timevalUs(e.usage.ru_stime);
+                check(cpu_us >= BURN_MS * 1000 / 2, "burn child cpu time");
+                check(burn_cpu_pct > 50, "burn child sampled cpu_pct");
+                printf("burn child: cpu %.1f ms of %d ms wall, sampled %.0f%%, "
+                       "nivcsw %ld\n",
+                       cpu_us / 1e3, BURN_MS, burn_cpu_pct,
+                       e.usage.ru_nivcsw);
+            } else {
+                check(e.code == CLD_KILLED && e.status == SIGKILL,
+                      "killed child status");
+            }
+        }
+    }
+
+    // 每行：测量名,标签 字段 时间戳
+    FILE* f = fopen(METRICS_PATH, "r");
+    if (f == nullptr) {
+        perror("fopen");
+        exit(EXIT_FAILURE);
+    }
+    char line[1024];
+    int samples = 0, exit_lines = 0;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        int spaces = 0;
+        for (const char* p = line; *p != '\0'; ++p)
+            spaces += *p == ' ';
+        check(spaces == 2 && strstr(line, ",bench=telemetry ") != nullptr,
+              "malformed line protocol");
+        if (strncmp(line, "child_sample,", 13) == 0)
+            ++samples;
+        else if (strncmp(line, "child_exit,", 11) == 0)
+            ++exit_lines;
+        else
+            check(false, "unknown measurement");
+    }
+    fclose(f);
+    unlink(METRICS_PATH);
+    check(exit_lines == 3, "child_exit lines");
+    check(samples > 0, "child_sample lines");
+    printf("%s: %d child_sample, %d child_exit lines\n", METRICS_PATH,
+           samples, exit_lines);
+}
+
+int main(int argc, char* argv[]) {
+    int children = argc > 1 ? atoi(argv[1]) : 1000;
+    if (children <= 0) {
+        fprintf(stderr, "children must be positive\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("reap one zombie: wait %.2f us, wait4 + rusage %.2f us, "
+           "waitid + rusage %.2f us\n",
+           reapUs(ReapCall::Wait), reapUs(ReapCall::Wait4),
+           reapUs(ReapCall::Waitid));
+    samplingCost(children);
+    correctness();
+
+    if (failures > 0)
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
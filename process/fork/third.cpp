@@ -3,6 +3,13 @@
  * @details
  * 使用 fork() 在 C++ 程序中创建两个进程
  *
+ * 收到 SIGINT / SIGTERM 后结束所有子进程再退出。
+ * 信号通过 signalfd 交给 ./reaper.h 的 Reaper，在普通上下文中处理；
+ * 子进程的退出也由 Reaper 通过 pidfd + epoll 回收。
+ * 回收时打印退出状态、CPU 时间和内存峰值；设置 CHILD_METRICS（以及 CHILD_SAMPLE_MS）时
+ * 按 ./telemetry.h 的行协议输出，采样在 Reaper::poll() 的超时中进行：
+ * CHILD_METRICS=metrics.lp CHILD_SAMPLE_MS=100 ./parent
+ *
  * @details
  * https://www.delftstack.com/howto/cpp/cpp-fork/
  *
@@ -10,12 +17,14 @@
  * g++ process/fork/second_child.cpp -o out/child
  * g++ process/fork/third.cpp -o out/parent --std=c++17
  * cd out
- * ./parent
+ * ./parent [fork|posix_spawn|vfork|clone3]
  */
-#include <atomic>
+#include "reaper.h"
+#include "spawn.h"
+#include "telemetry.h"
+#include <chrono>
 #include <filesystem>
 #include <iostream>
-#include <sys/wait.h>
 #include <unistd.h>
 
 using std::cout;
@@ -23,39 +32,18 @@ using std::endl;
 using std::string;
 using std::filesystem::exists;
 
-constexpr std::atomic<int> FORK_NUM = 6;
-constexpr std::atomic<int> handler_exit_code = 103;
-
-std::atomic<int> child_pid;
-std::atomic<int>* children;
-
-void sigquitHandler(int signal_number) {
-    printf("sigquitHandler...\n");
-
-    for (int i = 0; i < FORK_NUM; ++i) {
-        kill(children[i], SIGTERM);
-    }
-    while ((child_pid = wait(nullptr)) > 0)
-        cout << "child " << child_pid << " terminated" << endl;
-    _exit(handler_exit_code);
-}
+constexpr int FORK_NUM = 6;
+constexpr int handler_exit_code = 103;
+// 发出 SIGTERM 后等待子进程退出的时间，超时改发 SIGKILL
+constexpr std::chrono::milliseconds SHUTDOWN_DEADLINE(1000);
 
-pid_t spawnChild(const char* program, char** arg_list) {
-    pid_t ch_pid = fork();
-    if (ch_pid == -1) {
-        perror("fork");
-        exit(EXIT_FAILURE);
-    } else if (ch_pid > 0) {
-        cout << "spawn child with pid - " << ch_pid << endl;
-        return ch_pid;
-    } else {
-        execve(program, arg_list, nullptr);
-        perror("execve");
+int main(int argc, char* argv[]) {
+    SpawnMode mode = SpawnMode::Fork;
+    if (argc > 1 && !parseSpawnMode(argv[1], &mode)) {
+        cout << "Unknown spawn mode '" << argv[1] << "'\n";
         exit(EXIT_FAILURE);
     }
-}
 
-int main() {
     string program_name("child");
     char* arg_list[] = {program_name.data(), nullptr};
 
@@ -64,17 +52,37 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    children = reinterpret_cast<std::atomic<int>*>(new int[FORK_NUM]);
-    signal(SIGTERM, sigquitHandler);
-    signal(SIGINT, sigquitHandler);
+    ChildTelemetry telemetry =
+        ChildTelemetry::fromEnv(string("mode=") + spawnModeName(mode));
+    Reaper reaper;
+    auto onExit = [&](pid_t pid, const siginfo_t& info) {
+        printChildExit(telemetry.exited(pid, info, reaper.usage()));
+    };
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    reaper.watchSignals(mask);
 
     for (int i = 0; i < FORK_NUM; ++i) {
-        children[i] = spawnChild(program_name.c_str(), arg_list);
+        int pidfd;
+        pid_t ch_pid =
+            spawnChild(program_name.c_str(), arg_list, mode, &pidfd);
+        cout << "spawn child with pid - " << ch_pid << endl;
+        reaper.add(ch_pid, pidfd);
+        telemetry.track(ch_pid);
     }
     cout << endl;
 
-    while ((child_pid = wait(nullptr)) > 0)
-        cout << "child " << child_pid << " terminated" << endl;
+    while (reaper.size() > 0) {
+        reaper.poll(telemetry.timeoutMs(), onExit);
+        telemetry.sampleIfDue();
+        if (int sig = reaper.takeSignal()) {
+            cout << "signal " << sig << ", shutting down..." << endl;
+            reaper.shutdown(SIGTERM, SHUTDOWN_DEADLINE, onExit);
+            return handler_exit_code;
+        }
+    }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
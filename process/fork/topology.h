@@ -0,0 +1,345 @@
+/**
+ * @brief CPU 拓扑发现，以及按拓扑放置子进程（CPU 亲和性 + NUMA 内存策略）
+ * @details
+ * spawnChild() 创建的子进程完全交给调度器，工作进程会在核之间迁移，
+ * 每次迁移都要在新核上重新把缓存热起来；在多插槽机器上，
+ * 它的内存还可能留在原来的 NUMA 节点上，之后每次访问都要跨节点。
+ *
+ * readTopology() 从 /sys/devices/system/cpu 和 /sys/devices/system/node
+ * 读出每个在线 CPU 所在的插槽、物理核、超线程序号和 NUMA 节点。
+ * placeChild() 按放置策略为第 index 个子进程选出 CPU 集合和内存节点：
+ *
+ * Placement::Compact       依次填满每个物理核的所有超线程，再用下一个核，
+ *                          子进程挤在尽量少的核、节点上，共享缓存
+ * Placement::Scatter       先在各节点的物理核之间轮流分配，物理核用完才用超线程，
+ *                          每个子进程独占尽量多的缓存和内存带宽
+ * Placement::PhysicalCore  每个子进程一个物理核（可以在这个核的超线程间移动），
+ *                          子进程比物理核多时从头开始复用，始终不让两个子进程成为超线程兄弟
+ * Placement::NumaNode      第 index 个子进程可以使用某个节点的所有 CPU，
+ *                          内存只从这个节点分配（MPOL_BIND）
+ * 前三种策略只绑定到一个 CPU（或一个物理核），内存优先从它所在的节点分配（MPOL_PREFERRED）。
+ * Placement::None 什么都不改，子进程照常继承父进程的 CPU 亲和性和内存策略。
+ *
+ * 拓扑只包含本进程当前亲和性掩码（sched_getaffinity）里的 CPU：
+ * 在 taskset 或 cpuset 限制下运行时，各种策略只在允许的 CPU 之间分配。
+ *
+ * applyPlacement() 用 sched_setaffinity() 和 set_mempolicy() 设置调用线程，
+ * 在 fork() 之后的子进程中调用。两者都会被 fork() 和 execve() 继承，
+ * 所以 spawnPlaced() 在创建子进程前设置当前线程、创建后恢复，
+ * 对 spawnChild() 的每种 SpawnMode 都有效（posix_spawn 没有在子进程中执行代码的机会）。
+ *
+ * 内存策略只影响之后第一次访问才分配的页：子进程应当在放置之后再分配、初始化它的数据。
+ *
+ * @details
+ * https://www.kernel.org/doc/html/latest/admin-guide/cputopology.html
+ * https://man7.org/linux/man-pages/man2/sched_setaffinity.2.html
+ * https://man7.org/linux/man-pages/man2/set_mempolicy.2.html
+ */
+#pragma once
+
+#include "spawn.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <linux/mempolicy.h> // MPOL_BIND, MPOL_PREFERRED
+#include <map>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+enum class Placement {
+    None,
+    Compact,
+    Scatter,
+    PhysicalCore,
+    NumaNode
+};
+
+constexpr Placement ALL_PLACEMENTS[] = {Placement::None, Placement::Compact,
+                                        Placement::Scatter,
+                                        Placement::PhysicalCore,
+                                        Placement::NumaNode};
+
+inline const char* placementName(Placement placement) {
+    switch (placement) {
+    case Placement::None:
+        return "none";
+    case Placement::Compact:
+        return "compact";
+    case Placement::Scatter:
+        return "scatter";
+    case Placement::PhysicalCore:
+        return "physical_core";
+    case Placement::NumaNode:
+        return "numa_node";
+    }
+    return "unknown";
+}
+
+// 由名字得到 Placement，名字不认识时返回 false
+inline bool parsePlacement(const char* name, Placement* placement) {
+    for (Placement p : ALL_PLACEMENTS) {
+        if (strcmp(name, placementName(p)) == 0) {
+            *placement = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct CpuInfo {
+    int cpu;
+    int package; // physical_package_id
+    int core;    // core_id，只在同一插槽内唯一
+    int smt;     // 在同一物理核的超线程中的序号，0 表示第一个
+    int node;    // NUMA 节点
+};
+
+struct Topology {
+    std::vector<CpuInfo> cpus; // 按 CPU 编号排序
+    int nodes = 1;             // 节点编号的上界（最大编号 + 1）
+};
+
+// 解析 "0-3,8,10-11" 格式的 CPU / 节点列表
+inline std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> ids;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos)
+            end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        int first = atoi(range.c_str());
+        int last = dash == std::string::npos ? first
+                                             : atoi(range.c_str() + dash + 1);
+        for (int id = first; id <= last; ++id)
+            ids.push_back(id);
+        pos = end + 1;
+    }
+    return ids;
+}
+
+inline std::string readSysfs(const std::string& path) {
+    std::ifstream in(path);
+    std::string value;
+    std::getline(in, value);
+    return value;
+}
+
+inline int readSysfsInt(const std::string& path, int fallback) {
+    std::string value = readSysfs(path);
+    return value.empty() ? fallback : atoi(value.c_str());
+}
+
+/**
+ * @brief 读取本进程可以使用的在线 CPU 的拓扑
+ * @details 没有 /sys/devices/system/node 时（内核未启用 NUMA）所有 CPU 都在节点 0
+ */
+inline Topology readTopology() {
+    Topology topo;
+    std::vector<int> online =
+        parseCpuList(readSysfs("/sys/devices/system/cpu/online"));
+    if (online.empty()) {
+        for (int cpu = 0; cpu < sysconf(_SC_NPROCESSORS_ONLN); ++cpu)
+            online.push_back(cpu);
+    }
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        online.erase(std::remove_if(online.begin(), online.end(),
+                                    [&](int cpu) {
+                                        return cpu >= CPU_SETSIZE ||
+                                               !CPU_ISSET(cpu, &allowed);
+                                    }),
+                     online.end());
+    }
+
+    std::map<int, int> node_of;
+    std::vector<int> nodes =
+        parseCpuList(readSysfs("/sys/devices/system/node/online"));
+    for (int node : nodes) {
+        std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(node) + "/cpulist";
+        for (int cpu : parseCpuList(readSysfs(path)))
+            node_of[cpu] = node;
+        topo.nodes = std::max(topo.nodes, node + 1);
+    }
+
+    // (package, core) -> 已经编号的超线程个数
+    std::map<std::pair<int, int>, int> threads;
+    for (int cpu : online) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                          "/topology/";
+        CpuInfo info;
+        info.cpu = cpu;
+        info.package = readSysfsInt(dir + "physical_package_id", 0);
+        info.core = readSysfsInt(dir + "core_id", cpu);
+        info.smt = threads[{info.package, info.core}]++;
+        auto it = node_of.find(cpu);
+        info.node = it == node_of.end() ? 0 : it->second;
+        topo.cpus.push_back(info);
+    }
+    return topo;
+}
+
+struct CpuPlacement {
+    cpu_set_t cpus;          // 为空表示不修改 CPU 亲和性
+    int node = -1;           // 内存节点，-1 表示不修改内存策略
+    int mode = MPOL_DEFAULT; // MPOL_BIND 或 MPOL_PREFERRED
+};
+
+// Compact 的顺序：节点，插槽，物理核，超线程序号
+inline std::vector<CpuInfo> compactOrder(const Topology& topo) {
+    std::vector<CpuInfo> order = topo.cpus;
+    std::sort(order.begin(), order.end(),
+              [](const CpuInfo& a, const CpuInfo& b) {
+                  return std::tie(a.node, a.package, a.core, a.smt) <
+                         std::tie(b.node, b.package, b.core, b.smt);
+              });
+    return order;
+}
+
+// Scatter 的顺序：超线程序号，节点内物理核的序号，节点
+inline std::vector<CpuInfo> scatterOrder(const Topology& topo) {
+    std::map<std::pair<int, int>, int> core_rank; // (package, core) -> 节点内序号
+    std::vector<int> cores_in_node(topo.nodes, 0);
+    std::vector<CpuInfo> order = compactOrder(topo);
+    for (const CpuInfo& c : order) {
+        if (c.smt == 0)
+            core_rank[{c.package, c.core}] = cores_in_node[c.node]++;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](const CpuInfo& a, const CpuInfo& b) {
+                         int ra = core_rank[{a.package, a.core}];
+                         int rb = core_rank[{b.package, b.core}];
+                         return std::tie(a.smt, ra, a.node) <
+                                std::tie(b.smt, rb, b.node);
+                     });
+    return order;
+}
+
+/**
+ * @brief 按策略为第 index 个子进程选择 CPU 集合和内存节点
+ * @details Placement::None 返回空的 CPU 集合，不修改 CPU 亲和性和内存策略
+ */
+inline CpuPlacement placeChild(const Topology& topo, Placement placement,
+                               int index) {
+    CpuPlacement place;
+    CPU_ZERO(&place.cpus);
+    if (topo.cpus.empty())
+        return place;
+
+    switch (placement) {
+    case Placement::None:
+        return place;
+    case Placement::Compact: {
+        std::vector<CpuInfo> order = compactOrder(topo);
+        const CpuInfo& c = order[index % order.size()];
+        CPU_SET(c.cpu, &place.cpus);
+        place.node = c.node;
+        break;
+    }
+    case Placement::Scatter: {
+        std::vector<CpuInfo> order = scatterOrder(topo);
+        const CpuInfo& c = order[index % order.size()];
+        CPU_SET(c.cpu, &place.cpus);
+        place.node = c.node;
+        break;
+    }
+    case Placement::PhysicalCore: {
+        std::vector<CpuInfo> cores;
+        for (const CpuInfo& c : scatterOrder(topo)) {
+            if (c.smt == 0)
+                cores.push_back(c);
+        }
+        const CpuInfo& core = cores[index % cores.size()];
+        for (const CpuInfo& c : topo.cpus) {
+            if (c.package == core.package && c.core == core.core)
+                CPU_SET(c.cpu, &place.cpus);
+        }
+        place.node = core.node;
+        break;
+    }
+    case Placement::NumaNode: {
+        // 只在有 CPU 的节点之间轮转
+        std::vector<int> nodes;
+        for (const CpuInfo& c : topo.cpus) {
+            if (std::find(nodes.begin(), nodes.end(), c.node) == nodes.end())
+                nodes.push_back(c.node);
+        }
+        std::sort(nodes.begin(), nodes.end());
+        place.node = nodes[index % nodes.size()];
+        for (const CpuInfo& c : topo.cpus) {
+            if (c.node == place.node)
+                CPU_SET(c.cpu, &place.cpus);
+        }
+        place.mode = MPOL_BIND;
+        return place;
+    }
+    }
+    place.mode = MPOL_PREFERRED;
+    return place;
+}
+
+constexpr unsigned long NODE_MASK_BITS = 1024;
+
+/**
+ * @brief 把放置应用到调用线程，在 fork() 之后的子进程中调用
+ * @details 只使用系统调用，可以在 vfork() 的子进程中调用；
+ *          CPU 集合为空、node 为 -1 的部分不做修改
+ * @return 成功，true；失败，false（errno 表示原因）
+ */
+inline bool applyPlacement(const CpuPlacement& place) {
+    if (CPU_COUNT(&place.cpus) > 0 &&
+        sched_setaffinity(0, sizeof(place.cpus), &place.cpus) == -1)
+        return false;
+    if (place.node < 0 ||
+        static_cast<unsigned long>(place.node) >= NODE_MASK_BITS)
+        return true;
+    unsigned long mask[NODE_MASK_BITS / (8 * sizeof(unsigned long))] = {};
+    mask[place.node / (8 * sizeof(unsigned long))] |=
+        1UL << (place.node % (8 * sizeof(unsigned long)));
+    // 内核会先把 maxnode 减一，所以多传一位
+    return syscall(SYS_set_mempolicy, place.mode, mask, NODE_MASK_BITS + 1) == 0;
+}
+
+/**
+ * @brief 按 place 放置并创建子进程，参数和返回值同 spawnChild()
+ * @details 调用线程的 CPU 亲和性和内存策略在返回前恢复，失败时打印错误并退出
+ */
+inline pid_t spawnPlaced(const char* program, char** arg_list, SpawnMode mode,
+                         const CpuPlacement& place, int* pidfd = nullptr) {
+    if (CPU_COUNT(&place.cpus) == 0 && place.node < 0)
+        return spawnChild(program, arg_list, mode, pidfd);
+
+    cpu_set_t saved_cpus;
+    int saved_mode;
+    unsigned long saved_mask[NODE_MASK_BITS / (8 * sizeof(unsigned long))] = {};
+    if (sched_getaffinity(0, sizeof(saved_cpus), &saved_cpus) == -1 ||
+        syscall(SYS_get_mempolicy, &saved_mode, saved_mask, NODE_MASK_BITS,
+                nullptr, 0) == -1) {
+        perror("save placement");
+        exit(EXIT_FAILURE);
+    }
+    if (!applyPlacement(place)) {
+        perror("applyPlacement");
+        exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = spawnChild(program, arg_list, mode, pidfd);
+
+    if (sched_setaffinity(0, sizeof(saved_cpus), &saved_cpus) == -1 ||
+        syscall(SYS_set_mempolicy, saved_mode,
+                saved_mode == MPOL_DEFAULT ? nullptr : saved_mask,
+                NODE_MASK_BITS + 1) == -1) {
+        perror("restore placement");
+        exit(EXIT_FAILURE);
+    }
+    return pid;
+}
@@ -0,0 +1,207 @@
+/**
+ * @brief 比较各种放置策略下，内存密集型工作进程的吞吐量、缓存未命中和迁移次数
+ * @details
+ * 对 ./topology.h 的每种 Placement，用 spawnPlaced() 创建 workers 个子进程
+ * （/proc/self/exe --worker），子进程在放置之后才分配自己的数据：
+ * 一块 kb 大小的缓冲区，按 64 字节一个节点串成随机环（Sattolo 算法），
+ * 然后沿环访问 accesses 次。每次访问依赖上一次的结果，吞吐量完全取决于内存延迟。
+ *
+ * 子进程每访问 4096 次用 sched_getcpu() 看一下自己在哪个 CPU 上，
+ * 统计迁移次数；缓存未命中来自 perf_event_open，不可用时为 -1。
+ * 结果通过继承的管道写回父进程（一条记录小于 PIPE_BUF，写入是原子的）。
+ * 放置后的子进程只应出现在分配给它的 CPU 上，否则报错退出。
+ *
+ * 报告：墙上时间、总吞吐量（每秒百万次访问）、每次访问的平均纳秒数、
+ * 所有子进程的迁移次数之和、每次访问的缓存未命中数。
+ *
+ * @note
+ * g++ process/fork/topology_bench.cpp -o out/topology_bench --std=c++17 -O2
+ * out/topology_bench [workers=nproc] [kb=16384] [accesses=5000000]
+ */
+#include "../../benchmark/bench.h"
+#include "topology.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+constexpr int CHECK_EVERY = 4096;
+
+struct alignas(64) Node {
+    Node* next;
+};
+
+struct WorkerResult {
+    int32_t index;
+    int32_t migrations;
+    uint64_t cpus[4]; // 出现过的 CPU（只记录前 256 个）
+    double ns_per_access;
+    double misses_per_access;
+    uint64_t sink;
+};
+
+// Sattolo 算法：得到一个包含所有节点的随机环
+Node* buildChain(std::vector<Node>& nodes, uint64_t seed) {
+    std::vector<uint32_t> order(nodes.size());
+    for (uint32_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    uint64_t x = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = order.size() - 1; i > 0; --i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        std::swap(order[i], order[x % i]);
+    }
+    for (size_t i = 0; i < order.size(); ++i)
+        nodes[order[i]].next = &nodes[order[(i + 1) % order.size()]];
+    return &nodes[order[0]];
+}
+
+int workerMain(int fd, int index, size_t kb, long accesses) {
+    std::vector<Node> nodes(kb * 1024 / sizeof(Node));
+    Node* p = buildChain(nodes, static_cast<uint64_t>(index) + 1);
+
+    WorkerResult res{};
+    res.index = index;
+    int last_cpu = sched_getcpu();
+    bench_perf_setup();
+    uint64_t before[BENCH_NCOUNTERS] = {0}, after[BENCH_NCOUNTERS] = {0};
+    bool perf = bench_perf_read(before);
+    ioctl(bench_perf_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    double begin = bench_now_ns();
+    for (long i = 0; i < accesses; i += CHECK_EVERY) {
+        for (int k = 0; k < CHECK_EVERY; ++k)
+            p = p->next;
+        int cpu = sched_getcpu();
+        if (cpu != last_cpu)
+            ++res.migrations;
+        last_cpu = cpu;
+        if (cpu >= 0 && cpu < 256)
+            res.cpus[cpu / 64] |= 1ULL << (cpu % 64);
+    }
+    double elapsed = bench_now_ns() - begin;
+
+    ioctl(bench_perf_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    perf = perf && bench_perf_read(after);
+    res.ns_per_access = elapsed / accesses;
+    res.misses_per_access =
+        perf ? static_cast<double>(after[2] - before[2]) / accesses : -1;
+    res.sink = reinterpret_cast<uintptr_t>(p);
+    if (write(fd, &res, sizeof(res)) != sizeof(res)) {
+        perror("worker write");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+struct RoundResult {
+    double wall_ms;
+    double maccess_per_s;
+    double ns_per_access;
+    long migrations;
+    double misses_per_access;
+};
+
+RoundResult runRound(const Topology& topo, Placement placement, int workers,
+                     size_t kb, long accesses) {
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC) == -1) {
+        perror("pipe2");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(pipefd[1], F_SETFD, 0); // 写端由子进程继承
+
+    std::string fd_arg = std::to_string(pipefd[1]);
+    std::string kb_arg = std::to_string(kb);
+    std::string accesses_arg = std::to_string(accesses);
+    std::vector<CpuPlacement> places;
+    std::vector<pid_t> pids;
+
+    double begin = bench_now_ns();
+    for (int i = 0; i < workers; ++i) {
+        std::string index_arg = std::to_string(i);
+        char* arg_list[] = {const_cast<char*>("topology_bench"),
+                            const_cast<char*>("--worker"),
+                            fd_arg.data(),
+                            index_arg.data(),
+                            kb_arg.data(),
+                            accesses_arg.data(),
+                            nullptr};
+        places.push_back(placeChild(topo, placement, i));
+        pids.push_back(spawnPlaced("/proc/self/exe", arg_list,
+                                   SpawnMode::PosixSpawn, places.back()));
+    }
+    close(pipefd[1]);
+
+    RoundResult round{};
+    for (int i = 0; i < workers; ++i) {
+        WorkerResult res;
+        if (read(pipefd[0], &res, sizeof(res)) != sizeof(res)) {
+            fprintf(stderr, "%s: worker exited without a result\n",
+                    placementName(placement));
+            exit(EXIT_FAILURE);
+        }
+        // Placement::None 不限制 CPU
+        for (int cpu = 0; cpu < 256 && CPU_COUNT(&places[res.index].cpus) > 0;
+             ++cpu) {
+            if ((res.cpus[cpu / 64] >> (cpu % 64) & 1) &&
+                !CPU_ISSET(cpu, &places[res.index].cpus)) {
+                fprintf(stderr, "%s: worker %d ran on cpu %d\n",
+                        placementName(placement), res.index, cpu);
+                exit(EXIT_FAILURE);
+            }
+        }
+        round.ns_per_access += res.ns_per_access / workers;
+        round.migrations += res.migrations;
+        if (res.misses_per_access < 0 || round.misses_per_access < 0)
+            round.misses_per_access = -1; // 任何一个子进程没有计数器
+        else
+            round.misses_per_access += res.misses_per_access / workers;
+    }
+    round.wall_ms = (bench_now_ns() - begin) / 1e6;
+    close(pipefd[0]);
+    for (pid_t pid : pids) {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "worker %d failed\n", pid);
+            exit(EXIT_FAILURE);
+        }
+    }
+    round.maccess_per_s = workers * accesses / (round.wall_ms * 1e3);
+    return round;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 6 && strcmp(argv[1], "--worker") == 0)
+        return workerMain(atoi(argv[2]), atoi(argv[3]),
+                          strtoul(argv[4], nullptr, 10), atol(argv[5]));
+
+    Topology topo = readTopology();
+    int workers = argc > 1 ? atoi(argv[1]) : static_cast<int>(topo.cpus.size());
+    size_t kb = argc > 2 ? strtoul(argv[2], nullptr, 10) : 16384;
+    long accesses = argc > 3 ? atol(argv[3]) : 5000000;
+
+    int cores = 0;
+    for (const CpuInfo& c : topo.cpus)
+        cores += c.smt == 0;
+    printf("%zu cpus, %d physical cores, %d numa nodes; "
+           "%d workers x %zu KB x %ld accesses\n",
+           topo.cpus.size(), cores, topo.nodes, workers, kb, accesses);
+    printf("%-14s %10s %14s %10s %11s %15s\n", "placement", "wall_ms",
+           "Maccess_per_s", "ns_access", "migrations", "misses_access");
+    for (Placement placement : ALL_PLACEMENTS) {
+        RoundResult r = runRound(topo, placement, workers, kb, accesses);
+        printf("%-14s %10.1f %14.2f %10.2f %11ld %15.3f\n",
+               placementName(placement), r.wall_ms, r.maccess_per_s,
+               r.ns_per_access, r.migrations, r.misses_per_access);
+    }
+    return EXIT_SUCCESS;
+}
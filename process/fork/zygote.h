@@ -0,0 +1,161 @@
+/**
+ * @brief fork 服务器（zygote）：从预先初始化好的小模板进程创建子进程
+ * @details
+ * fork() + execve() 每创建一个子进程都要：
+ * 复制父进程的页表（父进程越大越慢），execve() 后再从头加载、初始化一遍。
+ *
+ * Zygote 在构造时 fork 出一个模板进程（此时父进程应当还很小），
+ * 模板进程执行一次 init()，把子进程需要的东西都加载、预热好，
+ * 然后在控制 socket 上等待请求。每个请求由模板进程 clone 一个子进程，
+ * 子进程直接调用 entry(arg)，返回值作为退出码，不需要 execve()，
+ * 复制的也只是模板进程的小页表，init() 准备的数据通过写时复制共享。
+ *
+ * clone3 使用 CLONE_PARENT：新子进程的父进程是调用 spawn() 的进程而不是模板进程，
+ * 所以仍然可以用 wait() / ./reaper.h 回收，也可以对返回的 pid 调用 pidfd_open。
+ *
+ * 控制 socket 是 SOCK_SEQPACKET 的 socketpair，一个请求一个报文。
+ * 父进程关闭 socket 后模板进程退出。spawn() 不是线程安全的。
+ *
+ * @details
+ * https://source.android.com/docs/core/runtime/zygote
+ * https://man7.org/linux/man-pages/man2/clone.2.html
+ */
+#pragma once
+
+#include "reaper.h" // pidfdOpen
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/sched.h> // struct clone_args
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+class Zygote {
+public:
+    using Init = void (*)();
+    using Entry = int (*)(int arg);
+
+    /**
+     * @brief 创建模板进程，返回时 init() 已经执行完
+     * @param init 在模板进程中执行一次，可以为 nullptr
+     * @param entry 每个子进程执行的函数
+     */
+    Zygote(Init init, Entry entry) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1) {
+            perror("socketpair");
+            exit(EXIT_FAILURE);
+        }
+        pid_ = fork();
+        if (pid_ == -1) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid_ == 0) {
+            close(sv[0]);
+            serve(sv[1], init, entry);
+        }
+        close(sv[1]);
+        sock_ = sv[0];
+
+        // 模板进程初始化完成后发一个字节
+        char ready;
+        if (recv(sock_, &ready, 1, 0) != 1) {
+            perror("zygote init");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ~Zygote() { stop(); }
+
+    Zygote(const Zygote&) = delete;
+    Zygote& operator=(const Zygote&) = delete;
+
+    /**
+     * @brief 让模板进程创建一个执行 entry(arg) 的子进程
+     * @param pidfd 不为空时写入子进程的 pidfd
+     * @return 子进程 pid，失败时打印错误并退出
+     */
+    pid_t spawn(int arg, int* pidfd = nullptr) {
+        Request req{arg};
+        Reply reply{};
+        if (send(sock_, &req, sizeof(req), 0) != sizeof(req) ||
+            recv(sock_, &reply, sizeof(reply), 0) != sizeof(reply)) {
+            perror("zygote");
+            exit(EXIT_FAILURE);
+        }
+        if (reply.pid < 0) {
+            errno = reply.err;
+            perror("zygote clone3");
+            exit(EXIT_FAILURE);
+        }
+        if (pidfd != nullptr) {
+            // 子进程是我们的子进程，回收之前 pid 不会被复用
+            *pidfd = pidfdOpen(reply.pid);
+            if (*pidfd == -1) {
+                perror("pidfd_open");
+                exit(EXIT_FAILURE);
+            }
+        }
+        return reply.pid;
+    }
+
+    // 关闭控制 socket 并回收模板进程，之后不能再 spawn()
+    void stop() {
+        if (sock_ == -1)
+            return;
+        close(sock_);
+        sock_ = -1;
+        waitpid(pid_, nullptr, 0);
+    }
+
+    // 模板进程的 pid
+    pid_t pid() const { return pid_; }
+
+private:
+    struct Request {
+        int32_t arg;
+    };
+
+    struct Reply {
+        int32_t pid; // 失败时为 -1
+        int32_t err;
+    };
+
+    [[noreturn]] static void serve(int sock, Init init, Entry entry) {
+        // 不继承父进程为了 signalfd 而屏蔽的信号
+        sigset_t empty_mask;
+        sigemptyset(&empty_mask);
+        sigprocmask(SIG_SETMASK, &empty_mask, nullptr);
+
+        if (init != nullptr)
+            init();
+        char ready = 'R';
+        send(sock, &ready, 1, 0);
+
+        Request req;
+        while (recv(sock, &req, sizeof(req), 0) == sizeof(req)) {
+            struct clone_args args;
+            memset(&args, 0, sizeof(args));
+            // CLONE_PARENT 要求 exit_signal 为 0，内核沿用模板进程的 SIGCHLD
+            args.flags = CLONE_PARENT;
+            pid_t pid =
+                static_cast<pid_t>(syscall(SYS_clone3, &args, sizeof(args)));
+            if (pid == 0) {
+                close(sock);
+                _exit(entry(req.arg));
+            }
+            Reply reply{pid, pid == -1 ? errno : 0};
+            send(sock, &reply, sizeof(reply), 0);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    int sock_ = -1;
+    pid_t pid_ = -1;
+};
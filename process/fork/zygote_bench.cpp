@@ -0,0 +1,178 @@
+/**
+ * @brief 比较 zygote 与 fork + execve 的“子进程第一次完成有用工作”的时间
+ * @details
+ * 每个子进程需要一张 warm_mb 大小的表（模拟加载配置、动态库、缓存等初始化），
+ * 有用的工作是在表里查若干次并把结果写回结果管道。
+ * 从发起创建到父进程读到结果的时间（含回收子进程）：
+ *
+ * fork+execve   从大父进程 fork，execve(/proc/self/exe --worker)，子进程自己初始化
+ * posix_spawn   同上，但不复制父进程页表
+ * fork          从大父进程 fork，不 exec，直接使用父进程已经初始化好的表
+ * zygote        由 ./zygote.h 的模板进程 clone，表已经在模板进程中初始化好
+ *
+ * 父进程先把 RSS 撑到 rss_mb，模拟一个已经很大的服务进程；
+ * zygote 在这之前创建，所以它的页表很小。
+ *
+ * @note
+ * g++ process/fork/zygote_bench.cpp -o out/zygote_bench --std=c++17 -O2
+ * out/zygote_bench [rss_mb=1024] [warm_mb=32]
+ */
+#include "../../benchmark/bench.h"
+#include "spawn.h"
+#include "zygote.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+constexpr size_t MB = 1 << 20;
+constexpr int LOOKUPS = 4096;
+
+static size_t warm_mb = 32;
+static uint64_t* table = nullptr;
+static int result_fd = -1;
+
+// 初始化：生成查找表，每一页都会被写到
+void warm() {
+    size_t n = warm_mb * MB / sizeof(uint64_t);
+    table = static_cast<uint64_t*>(malloc(n * sizeof(uint64_t)));
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        table[i] = x;
+    }
+}
+
+// 有用的工作：在表中查 LOOKUPS 次，结果写回父进程
+int work(int seed) {
+    size_t n = warm_mb * MB / sizeof(uint64_t);
+    uint64_t sum = 0, index = static_cast<uint64_t>(seed);
+    for (int i = 0; i < LOOKUPS; ++i) {
+        sum += table[index % n];
+        index = table[index % n];
+    }
+    if (write(result_fd, &sum, sizeof(sum)) != sizeof(sum))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+// 把父进程的 RSS 增加到 target_mb，新映射的页全部写一遍以确保真正驻留
+void growRss(size_t target_mb) {
+    void* p = mmap(nullptr, target_mb * MB, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    memset(p, 1, target_mb * MB);
+}
+
+struct Context {
+    int result_rd;
+    uint64_t expect;
+    Zygote* zygote;
+    SpawnMode mode;
+    std::string fd_arg;
+    std::string warm_arg;
+};
+
+// 读出子进程的结果并检查，然后回收子进程
+void collect(Context* ctx, pid_t pid) {
+    uint64_t sum;
+    if (read(ctx->result_rd, &sum, sizeof(sum)) != sizeof(sum)) {
+        perror("read result");
+        exit(EXIT_FAILURE);
+    }
+    if (sum != ctx->expect) {
+        fprintf(stderr, "worker %d: wrong result\n", pid);
+        exit(EXIT_FAILURE);
+    }
+    waitpid(pid, nullptr, 0);
+}
+
+void execWorker(void* arg) {
+    Context* ctx = static_cast<Context*>(arg);
+    char* arg_list[] = {const_cast<char*>("zygote_bench"),
+                        const_cast<char*>("--worker"), ctx->fd_arg.data(),
+                        ctx->warm_arg.data(), nullptr};
+    collect(ctx, spawnChild("/proc/self/exe", arg_list, ctx->mode));
+}
+
+void forkWorker(void* arg) {
+    Context* ctx = static_cast<Context*>(arg);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0)
+        _exit(work(0));
+    collect(ctx, pid);
+}
+
+void zygoteWorker(void* arg) {
+    Context* ctx = static_cast<Context*>(arg);
+    collect(ctx, ctx->zygote->spawn(0));
+}
+
+int main(int argc, char* argv[]) {
+    // 被 execve 的子进程：zygote_bench --worker <fd> <warm_mb>
+    if (argc == 4 && strcmp(argv[1], "--worker") == 0) {
+        result_fd = atoi(argv[2]);
+        warm_mb = strtoul(argv[3], nullptr, 10);
+        warm();
+        return work(0);
+    }
+
+    size_t rss_mb = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1024;
+    warm_mb = argc > 2 ? strtoul(argv[2], nullptr, 10) : 32;
+
+    // 写端不设 CLOEXEC，execve 的子进程通过参数得到它的编号
+    int result[2];
+    if (pipe(result) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    result_fd = result[1];
+
+    // 趁父进程还小的时候创建模板进程
+    Zygote zygote(warm, work);
+
+    growRss(rss_mb);
+    warm();
+
+    Context ctx{result[0], 0, &zygote, SpawnMode::Fork,
+                std::to_string(result_fd), std::to_string(warm_mb)};
+    // 父进程自己算一遍期望的结果
+    work(0);
+    if (read(result[0], &ctx.expect, sizeof(ctx.expect)) !=
+        sizeof(ctx.expect)) {
+        perror("read");
+        exit(EXIT_FAILURE);
+    }
+
+    bench_init(nullptr);
+    if (bench_cfg.format == BENCH_TEXT)
+        printf("parent rss %zu MB, warm %zu MB per worker\n", rss_mb, warm_mb);
+
+    struct bench_result r;
+    ctx.mode = SpawnMode::Fork;
+    r = bench_run("fork+execve", execWorker, &ctx, 1);
+    bench_report(&r);
+    ctx.mode = SpawnMode::PosixSpawn;
+    r = bench_run("posix_spawn", execWorker, &ctx, 1);
+    bench_report(&r);
+    r = bench_run("fork", forkWorker, &ctx, 1);
+    bench_report(&r);
+    r = bench_run("zygote", zygoteWorker, &ctx, 1);
+    bench_report(&r);
+
+    zygote.stop();
+    return EXIT_SUCCESS;
+}